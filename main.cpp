@@ -6,6 +6,7 @@
 #include <QTimer>
 #include <iostream>
 
+#include "src/cli/batchrunner.h"
 #include "src/cli/clioptions.h"
 #include "src/cli/clirunner.h"
 #include "src/mainwindow.h"
@@ -82,6 +83,10 @@ int CLIMode(QCommandLineParser &parser, Ripes::CLIModeOptions &options) {
     parser.showHelp();
     return 0;
   }
+  if (options.batchWorker)
+    return Ripes::BatchRunner::runWorker();
+  if (!options.batchManifest.isEmpty())
+    return Ripes::BatchRunner(options).run();
   return Ripes::CLIRunner(options).run();
 }
 
@@ -11,8 +11,10 @@
 #include "ripes_types.h"
 
 #include <cstdint>
+#include <future>
 #include <numeric>
 #include <set>
+#include <unordered_set>
 #include <variant>
 
 #include "STLExtras.h"
@@ -31,7 +33,7 @@ namespace Assembler {
     assert(result.errors.size() != 0);                                         \
     return result;                                                             \
   }                                                                            \
-  auto resName = std::get<resType>(passFunction##_res);
+  auto resName = std::move(std::get<resType>(passFunction##_res));
 
 /**
  * A macro for running an assembler operation which may throw an error or return
@@ -96,6 +98,7 @@ public:
     /// by default, emit to .text until otherwise specified
     setCurrentSegment(Location::unknown(), ".text");
     m_symbolMap.clear();
+    m_exprCache.clear();
     if (symbols) {
       m_symbolMap = *symbols;
     }
@@ -104,7 +107,7 @@ public:
     runPass(tokenizedLines, SourceProgram, pass0, programLines);
 
     /// Pseudo instruction expansion
-    runPass(expandedLines, SourceProgram, pass1, tokenizedLines);
+    runPass(expandedLines, SourceProgram, pass1, std::move(tokenizedLines));
 
     /** Assemble. During assembly, we generate:
      * - linkageMap: Recording offsets of instructions which require linkage
@@ -123,6 +126,155 @@ public:
     return result;
   }
 
+  AssembleResult
+  assembleUnits(const std::vector<AssemblyUnit> &units,
+                const SymbolMap *symbols = nullptr) const override {
+    if (units.size() < 2)
+      return assembleRaw(units.empty() ? QString() : units.front().source,
+                         symbols);
+
+    AssembleResult result;
+    auto addUnitError = [&](size_t i, const Error &err) {
+      result.errors.push_back(
+          Error(err, units.at(i).name + ": " + err.errorMessage()));
+    };
+
+    // An assembler maintains the state of the program being assembled, so each
+    // unit is assembled by a separate instance. Units are assembled relative to
+    // address 0, and placed by the linker. Section bases are reset only once
+    // all instances have been created, given that constructing an assembler
+    // may broadcast the section base settings to all assemblers.
+    std::vector<std::unique_ptr<AssemblerBase>> assemblers;
+    for (size_t i = 0; i < units.size(); ++i)
+      assemblers.push_back(clone());
+    for (auto &assembler : assemblers)
+      for (const auto &base : m_sectionBasePointers)
+        assembler->setSegmentBase(base.first, 0);
+    auto unitAssembler = [&](size_t i) {
+      return static_cast<const Assembler<Reg_T> *>(assemblers.at(i).get());
+    };
+
+    std::vector<RelocatableUnit> objects(units.size());
+    concurrentFor(units.size(), [&](size_t i) {
+      objects[i] = unitAssembler(i)->assembleUnit(
+          splitLines(units.at(i).source), symbols);
+    });
+    for (size_t i = 0; i < units.size(); ++i)
+      for (const auto &err : objects[i].errors)
+        addUnitError(i, err);
+    if (!result.errors.empty())
+      return result;
+
+    // Lay out the sections of each unit after the corresponding sections of the
+    // preceding units.
+    std::vector<std::map<Section, AInt>> unitBases(units.size());
+    for (const auto &base : m_sectionBasePointers) {
+      AInt address = base.second;
+      for (size_t i = 0; i < units.size(); ++i) {
+        const auto &section = objects[i].program.sections.at(base.first);
+        if (!section.data.isEmpty())
+          address += (section.alignment - address % section.alignment) %
+                     section.alignment;
+        unitBases[i][base.first] = address;
+        address += section.data.size();
+      }
+    }
+
+    // Relocate the address symbols of each unit, and gather the symbols which
+    // are exported to other units.
+    SymbolMap globals;
+    std::map<QString, size_t> globalDefinitions;
+    for (size_t i = 0; i < units.size(); ++i) {
+      SymbolMap &unitSymbols = assemblers.at(i)->m_symbolMap;
+      for (const auto &def : objects[i].definitions) {
+        const VInt value = unitBases[i].at(def.section) + def.offset;
+        auto err = def.symbol.isLocal()
+                       ? unitSymbols.addRelSymbol(def.line, def.symbol, value)
+                       : unitSymbols.addAbsSymbol(def.line, def.symbol, value);
+        if (err)
+          addUnitError(i, err.value());
+      }
+
+      for (const auto &global : unitSymbols.globals) {
+        auto it = unitSymbols.abs.find(Symbol(global));
+        if (it == unitSymbols.abs.end()) {
+          addUnitError(i, Error(Location::unknown(),
+                                "Undefined global symbol '" + global + "'"));
+          continue;
+        }
+        auto [definedIn, inserted] = globalDefinitions.try_emplace(global, i);
+        if (!inserted) {
+          addUnitError(i, Error(Location::unknown(),
+                                "Multiple definitions of global symbol '" +
+                                    global + "' (also defined in " +
+                                    units.at(definedIn->second).name + ")"));
+          continue;
+        }
+        globals.abs.insert(*it);
+      }
+    }
+    if (!result.errors.empty())
+      return result;
+
+    // Resolve the link requests of each unit against its own symbols, followed
+    // by the global symbols of all units.
+    for (size_t i = 0; i < units.size(); ++i) {
+      for (const auto &base : unitBases[i])
+        assemblers.at(i)->setSegmentBase(base.first, base.second);
+      auto &unitSymbols = assemblers.at(i)->m_symbolMap.abs;
+      for (const auto &global : globals.abs)
+        unitSymbols.try_emplace(global.first, global.second);
+    }
+    concurrentFor(units.size(), [&](size_t i) {
+      auto res = unitAssembler(i)->pass3(objects[i].program,
+                                         objects[i].needsLinkage);
+      if (auto *errors = std::get_if<Errors>(&res))
+        objects[i].errors = *errors;
+    });
+    for (size_t i = 0; i < units.size(); ++i)
+      for (const auto &err : objects[i].errors)
+        addUnitError(i, err);
+    if (!result.errors.empty())
+      return result;
+
+    // Merge the sections of the units into the linked program.
+    Program &program = result.program;
+    QByteArray sources;
+    for (const auto &base : m_sectionBasePointers) {
+      ProgramSection section;
+      section.name = base.first;
+      section.address = base.second;
+      for (size_t i = 0; i < units.size(); ++i) {
+        const auto &unitSection = objects[i].program.sections.at(base.first);
+        section.data.append(QByteArray(unitBases[i].at(base.first) -
+                                           section.address -
+                                           section.data.size(),
+                                       '\0'));
+        section.data.append(unitSection.data);
+        section.alignment = std::lcm(section.alignment, unitSection.alignment);
+      }
+      program.sections[base.first] = section;
+    }
+    for (size_t i = 0; i < units.size(); ++i) {
+      for (const auto &iter : assemblers.at(i)->m_symbolMap.abs) {
+        if (iter.first.is(Symbol::Type::Address)) {
+          auto [it, inserted] =
+              program.symbols.try_emplace(iter.second, iter.first);
+          if (!inserted && it->second < iter.first)
+            it->second = iter.first;
+        }
+      }
+      sources += units.at(i).source.toUtf8();
+    }
+
+    // Source lines are only meaningful for a single unit; map the first unit,
+    // which is placed at the start of the text section.
+    program.sourceMapping = objects.front().program.sourceMapping;
+    program.sourceHash = Program::calculateHash(sources);
+    program.entryPoint = m_sectionBasePointers.at(".text");
+    return result;
+  }
+
   DisassembleResult disassemble(const Program &program,
                                 const AInt baseAddress = 0) const override {
     VInt progByteIter = 0;
@@ -185,6 +337,13 @@ public:
     return opres;
   }
 
+  std::optional<unsigned> instructionSize(const VInt word) const override {
+    auto match = m_matcher->matchInstruction(word);
+    if (std::holds_alternative<Error>(match))
+      return std::nullopt;
+    return std::get<const _Instruction *>(match)->size();
+  }
+
   const _Matcher &getMatcher() { return *m_matcher; }
 
   std::set<QString> getOpcodes() const override {
@@ -233,6 +392,60 @@ protected:
 
   using LinkRequests = std::vector<LinkRequest>;
 
+  /// Definition of an address symbol as an offset into the section in which it
+  /// was defined.
+  struct SymbolDefinition {
+    unsigned line;
+    Symbol symbol;
+    Section section;
+    VInt offset;
+  };
+  using SymbolDefinitions = std::vector<SymbolDefinition>;
+
+  /// A separately assembled unit. Address symbols of the unit are recorded as
+  /// section offsets, and link requests are left unresolved, until the unit
+  /// has been placed by the linker.
+  struct RelocatableUnit {
+    Errors errors;
+    Program program;
+    LinkRequests needsLinkage;
+    SymbolDefinitions definitions;
+  };
+
+  /**
+   * @brief assembleUnit
+   * Runs the passes preceding symbol linkage on a single unit of an
+   * assembleUnits call.
+   */
+  RelocatableUnit assembleUnit(const QStringList &programLines,
+                               const SymbolMap *symbols) const {
+    RelocatableUnit result;
+
+    setCurrentSegment(Location::unknown(), ".text");
+    m_symbolMap.clear();
+    m_exprCache.clear();
+    if (symbols) {
+      m_symbolMap = *symbols;
+    }
+
+    runPass(tokenizedLines, SourceProgram, pass0, programLines);
+    runPass(expandedLines, SourceProgram, pass1, std::move(tokenizedLines));
+    runPass(program, Program, pass2, expandedLines, result.needsLinkage,
+            &result.definitions);
+    result.program = std::move(program);
+    return result;
+  }
+
+  /// Runs @p f for each index in [0; n) concurrently, and waits for all calls
+  /// to finish.
+  static void concurrentFor(size_t n, const std::function<void(size_t)> &f) {
+    std::vector<std::future<void>> futures;
+    for (size_t i = 0; i < n; ++i)
+      futures.push_back(std::async(std::launch::async, f, i));
+    for (auto &future : futures)
+      future.get();
+  }
+
   /**
    * @brief pass0
    * Line tokenization and source line recording
@@ -241,7 +454,7 @@ protected:
     Errors errors;
     SourceProgram tokenizedLines;
     tokenizedLines.reserve(program.size());
-    Symbols symbols;
+    std::unordered_set<Symbol> symbols;
 
     /** @brief carry
      * A symbol should refer to the next following assembler line; whether an
@@ -291,6 +504,12 @@ protected:
                    directiveAndRest.second);
 
       tsl.tokens = finalTokens;
+      if (!tsl.directive.isEmpty() && m_earlyDirectives.count(tsl.directive)) {
+        bool wasDirective; // unused
+        runOperation(directiveBytes, assembleDirective,
+                     DirectiveArg{tsl, nullptr}, wasDirective, false);
+      }
+
       if (tsl.tokens.empty() && tsl.directive.isEmpty()) {
         if (!tsl.symbols.empty()) {
           carry.insert(tsl.symbols.begin(), tsl.symbols.end());
@@ -298,13 +517,7 @@ protected:
       } else {
         tsl.symbols.insert(carry.begin(), carry.end());
         carry.clear();
-        tokenizedLines.push_back(tsl);
-      }
-
-      if (!tsl.directive.isEmpty() && m_earlyDirectives.count(tsl.directive)) {
-        bool wasDirective; // unused
-        runOperation(directiveBytes, assembleDirective,
-                     DirectiveArg{tsl, nullptr}, wasDirective, false);
+        tokenizedLines.push_back(std::move(tsl));
       }
     }
 
@@ -320,7 +533,7 @@ protected:
    * Pseudo-op expansion. If @return errors is empty, pass succeeded.
    */
   std::variant<Errors, SourceProgram>
-  pass1(const SourceProgram &tokenizedLines) const {
+  pass1(SourceProgram &&tokenizedLines) const {
     Errors errors;
     SourceProgram expandedLines;
     expandedLines.reserve(tokenizedLines.size());
@@ -338,14 +551,14 @@ protected:
           tsl.tokens = eop.value();
           if (eop.index() == 0) {
             tsl.directive = tokenizedLine.value().directive;
-            tsl.symbols = tokenizedLine.value().symbols;
+            tsl.symbols = std::move(tokenizedLine.value().symbols);
           }
-          expandedLines.push_back(tsl);
+          expandedLines.push_back(std::move(tsl));
         }
       } else {
-        // This was not a pseudoinstruction; just add line to the set of
+        // This was not a pseudoinstruction; just move the line to the set of
         // expanded lines
-        expandedLines.push_back(tokenizedLine.value());
+        expandedLines.push_back(std::move(tokenizedLine.value()));
       }
     }
 
@@ -362,9 +575,12 @@ protected:
    * In the following, current size of the program is used as an analog for the
    * offset of the to-be-assembled instruction in the program. This is then used
    * for symbol resolution.
+   * If @p definitions is set, address symbols are recorded as section offsets
+   * in @p definitions rather than being added to the symbol map.
    */
-  std::variant<Errors, Program> pass2(const SourceProgram &tokenizedLines,
-                                      LinkRequests &needsLinkage) const {
+  std::variant<Errors, Program>
+  pass2(const SourceProgram &tokenizedLines, LinkRequests &needsLinkage,
+        SymbolDefinitions *definitions = nullptr) const {
     // Initialize program with initialized segments:
     Program program;
     for (const auto &iter : m_sectionBasePointers) {
@@ -384,6 +600,12 @@ protected:
       // position
       VInt addr_offset = currentSection->data.size();
       for (const auto &s : line.symbols) {
+        if (definitions) {
+          definitions->push_back(
+              {static_cast<unsigned>(line.sourceLine()), s, m_currentSection,
+               addr_offset});
+          continue;
+        }
         // Record symbol position as its absolute address in memory
         auto res = m_symbolMap.addSymbol(
             line, s,
@@ -446,7 +668,12 @@ protected:
     /// @todo: also consider relative symbols here.
     for (const auto &iter : m_symbolMap.abs) {
       if (iter.first.is(Symbol::Type::Address)) {
-        program.symbols[iter.second] = iter.first;
+        // The symbol map is unordered; for aliasing symbols, deterministically
+        // select the lexicographically largest symbol.
+        auto [it, inserted] =
+            program.symbols.try_emplace(iter.second, iter.first);
+        if (!inserted && it->second < iter.first)
+          it->second = iter.first;
       }
     }
 
@@ -57,6 +57,17 @@ struct AssembleResult {
   Program program;
 };
 
+/**
+ * @brief The AssemblyUnit struct
+ * A source file which is assembled separately from, and subsequently linked
+ * together with, other units.
+ */
+struct AssemblyUnit {
+  /// Name of the unit (typically its file name), used for error reporting.
+  QString name;
+  QString source;
+};
+
 struct DisassembleResult {
   Errors errors;
   QStringList program;
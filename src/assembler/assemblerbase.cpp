@@ -29,10 +29,26 @@ void AssemblerBase::setSegmentBase(Section seg, AInt base) {
   m_sectionBasePointers[seg] = base;
 }
 
+QStringList AssemblerBase::splitLines(const QString &program) {
+  // Split on either of '\r' and '\n'. Done through a linear scan rather than
+  // QString::split with a regular expression, which dominates assembly time for
+  // large sources.
+  QStringList programLines;
+  qsizetype start = 0;
+  for (qsizetype i = 0; i < program.size(); ++i) {
+    const QChar ch = program.at(i);
+    if (ch == '\r' || ch == '\n') {
+      programLines.push_back(program.mid(start, i - start));
+      start = i + 1;
+    }
+  }
+  programLines.push_back(program.mid(start));
+  return programLines;
+}
+
 AssembleResult AssemblerBase::assembleRaw(const QString &program,
                                           const SymbolMap *symbols) const {
-  const auto programLines = program.split(QRegularExpression("[\r\n]"));
-  return assemble(programLines, symbols,
+  return assemble(splitLines(program), symbols,
                   Program::calculateHash(program.toUtf8()));
 }
 
@@ -40,14 +56,19 @@ AssembleResult AssemblerBase::assembleRaw(const QString &program,
 /// the expression evaluator.
 ExprEvalRes AssemblerBase::evalExpr(const Location &location,
                                     const QString &expr) const {
-  auto relativeMap = m_symbolMap.copyRelativeTo(location.sourceLine());
-
-  auto symbolValue = relativeMap.find(expr);
-  if (symbolValue != relativeMap.end()) {
-    return symbolValue->second;
-  } else {
-    return evaluate(location, expr, &relativeMap);
+  const unsigned line = location.sourceLine();
+  if (auto symbolValue = m_symbolMap.lookup(expr, line);
+      symbolValue.has_value()) {
+    return symbolValue.value();
   }
+
+  auto parsed = m_exprCache.get(location, expr);
+  if (auto *err = std::get_if<Error>(&parsed))
+    return *err;
+  return evaluate(location, std::get<ExprPtr>(parsed),
+                  [this, line](const QString &symbol) -> std::optional<VIntS> {
+                    return m_symbolMap.lookup(symbol, line);
+                  });
 }
 
 void AssemblerBase::setDirectives(const DirectiveVec &directives) {
@@ -123,16 +144,17 @@ AssemblerBase::splitSymbolsFromLine(const Location &location,
       splitTokens.push_back(token);
       continue;
     }
-    Token buffer;
-    for (const auto &ch : token) {
-      buffer.append(ch);
-      if (ch == ':') {
-        splitTokens.push_back(buffer);
-        buffer.clear();
-      }
+    qsizetype start = 0;
+    qsizetype colon;
+    while ((colon = token.indexOf(':', start)) != -1) {
+      splitTokens.push_back(Token(token.mid(start, colon - start + 1)));
+      start = colon + 1;
     }
-    if (!buffer.isEmpty()) {
-      splitTokens.push_back(buffer);
+    if (start == 0) {
+      // No ':' in token; keep it as-is.
+      splitTokens.push_back(token);
+    } else if (start < token.size()) {
+      splitTokens.push_back(Token(token.mid(start)));
     }
   }
 
@@ -2,7 +2,9 @@
 
 #include <QRegularExpression>
 
+#include <memory>
 #include <optional>
+#include <vector>
 
 #include "assembler_defines.h"
 #include "directive.h"
@@ -43,6 +45,21 @@ public:
   AssembleResult assembleRaw(const QString &program,
                              const SymbolMap *symbols = nullptr) const;
 
+  /// Assembles each of the provided units separately and concurrently, and
+  /// links the resulting relocatable units into a single program. The sections
+  /// of the units are laid out in the order of @p units, such that execution
+  /// starts at the first unit. Only symbols declared through .global/.globl are
+  /// visible to other units. Given that the addresses of symbols are only known
+  /// after linking, address symbols may be referenced by instructions but not
+  /// by data directives.
+  virtual AssembleResult
+  assembleUnits(const std::vector<AssemblyUnit> &units,
+                const SymbolMap *symbols = nullptr) const = 0;
+
+  /// Returns a new assembler for the same ISA and section base pointers as this
+  /// assembler.
+  virtual std::unique_ptr<AssemblerBase> clone() const = 0;
+
   /// Disassembles an input program relative to the provided base address.
   virtual DisassembleResult disassemble(const Program &program,
                                         const AInt baseAddress = 0) const = 0;
@@ -53,6 +70,11 @@ public:
                                           const ReverseSymbolMap &symbols,
                                           const AInt baseAddress = 0) const = 0;
 
+  /// Returns the size (in bytes) of the instruction encoded by the input word,
+  /// without disassembling it. Returns std::nullopt if the word does not encode
+  /// a known instruction.
+  virtual std::optional<unsigned> instructionSize(const VInt word) const = 0;
+
   /// Returns the set of opcodes (as strings) which are supported by this
   /// assembler.
   virtual std::set<QString> getOpcodes() const = 0;
@@ -74,6 +96,13 @@ public:
   mutable SymbolMap m_symbolMap;
 
 protected:
+  /// Expressions parsed during the current assembly. Marked mutable given that
+  /// expressions are evaluated during assembling.
+  mutable ExprCache m_exprCache;
+
+  /// Splits a source program into its lines.
+  static QStringList splitLines(const QString &program);
+
   /// Creates a set of LineTokens by tokenizing a line of source code.
   QRegularExpression m_splitterRegex;
   Result<LineTokens> tokenize(const Location &location,
@@ -18,7 +18,7 @@ class AssemblerBase;
 /// program section of which the directive handler should work on.
 struct DirectiveArg {
   const TokenizedSrcLine &line;
-  const ProgramSection *section;
+  ProgramSection *section;
 };
 
 /// An assembler directive represents a function which may be activated through
@@ -1,6 +1,7 @@
 #include "expreval.h"
 
 #include <iostream>
+#include <limits>
 #include <memory>
 
 #include "assembler_defines.h"
@@ -16,7 +17,7 @@ const QString s_exprOperators QStringLiteral("+-*/%@");
 const QString s_exprTokens QStringLiteral("()+-*/%@");
 
 #define IfExpr(TExpr, boundVar)                                                \
-  if (auto *boundVar = std::get_if<TExpr>(expr.get())) {
+  if (auto *boundVar = std::get_if<TExpr>(&*expr)) {
 #define FiExpr }
 
 struct Expr;
@@ -37,6 +38,13 @@ struct Literal : Printable {
   void print(std::ostream &str) const override;
 };
 
+/// A literal or subexpression which was resolved to a value during parsing.
+struct Constant : Printable {
+  explicit Constant(VIntS _v) : v(_v) {}
+  VIntS v;
+  void print(std::ostream &str) const override;
+};
+
 struct Add : Printable {
   Add(const std::shared_ptr<Expr> &_lhs, const std::shared_ptr<Expr> &_rhs)
       : lhs(_lhs), rhs(_rhs) {}
@@ -94,8 +102,8 @@ struct SignExtend : Printable {
   void print(std::ostream &str) const override;
 };
 
-struct Expr : std::variant<Literal, Add, Mul, Div, Sub, Mod, And, Or, Nothing,
-                           SignExtend> {
+struct Expr : std::variant<Literal, Constant, Add, Mul, Div, Sub, Mod, And, Or,
+                           Nothing, SignExtend> {
   using variant::variant;
 
   /**
@@ -116,6 +124,7 @@ struct Expr : std::variant<Literal, Add, Mul, Div, Sub, Mod, And, Or, Nothing,
     tryPrint(Mul);
     tryPrint(Sub);
     tryPrint(Literal);
+    tryPrint(Constant);
     tryPrint(Mod);
     tryPrint(Nothing);
     tryPrint(SignExtend);
@@ -144,6 +153,9 @@ void Mod::print(std::ostream& os) const {
 void Literal::print(std::ostream& os) const {
     os << v.toStdString();
 }
+void Constant::print(std::ostream& os) const {
+    os << v;
+}
 void And::print(std::ostream& os) const {
     os << "(" << lhs << " & " << rhs << ")";
 }
@@ -222,7 +234,7 @@ ExprRes parseLeft(const Location &loc, const QString &s, int &pos, int &depth) {
             case '%': { return rightRec<Mod>(loc, res, s, pos, depth);}
             case '@': { return rightRec<SignExtend>(loc, res, s, pos, depth);}
             case ')': { return depth-- != 0 ? res : ExprRes(Error(loc, "Unmatched parenthesis in expression '" + s + '"'));};
-            default:  { return ExprRes(Error(-1, "Invalid operator '" + QString(ch) + "' in expression '" + s + "'"));}
+            default:  { return ExprRes(Error(loc, "Invalid operator '" + QString(ch) + "' in expression '" + s + "'"));}
         }
     // clang-format on
   } else {
@@ -230,42 +242,60 @@ ExprRes parseLeft(const Location &loc, const QString &s, int &pos, int &depth) {
   }
 }
 
-VIntS evaluate(const std::shared_ptr<Expr> &expr,
-               const AbsoluteSymbolMap *variables) {
+VIntS evaluate(const Expr *expr, const SymbolLookup *variables) {
   // There is a bug in GCC for variant visitors on incomplete variant types
   // (recursive), So instead we'll macro our way towards something that looks
   // like a pattern match for the variant type.
+  IfExpr(Constant, v) { return v->v; }
+  FiExpr;
   IfExpr(Add, v) {
-    return evaluate(v->lhs, variables) + evaluate(v->rhs, variables);
+    return evaluate(v->lhs.get(), variables) +
+           evaluate(v->rhs.get(), variables);
   }
   FiExpr;
   IfExpr(Div, v) {
-    return evaluate(v->lhs, variables) / evaluate(v->rhs, variables);
+    const VIntS rhs = evaluate(v->rhs.get(), variables);
+    if (rhs == 0)
+      throw std::runtime_error("Division by zero");
+    const VIntS lhs = evaluate(v->lhs.get(), variables);
+    if (rhs == -1 && lhs == std::numeric_limits<VIntS>::min())
+      throw std::runtime_error("Division overflow");
+    return lhs / rhs;
   }
   FiExpr;
   IfExpr(Mul, v) {
-    return evaluate(v->lhs, variables) * evaluate(v->rhs, variables);
+    return evaluate(v->lhs.get(), variables) *
+           evaluate(v->rhs.get(), variables);
   }
   FiExpr;
   IfExpr(Sub, v) {
-    return evaluate(v->lhs, variables) - evaluate(v->rhs, variables);
+    return evaluate(v->lhs.get(), variables) -
+           evaluate(v->rhs.get(), variables);
   }
   FiExpr;
   IfExpr(Mod, v) {
-    return evaluate(v->lhs, variables) % evaluate(v->rhs, variables);
+    const VIntS rhs = evaluate(v->rhs.get(), variables);
+    if (rhs == 0)
+      throw std::runtime_error("Division by zero");
+    const VIntS lhs = evaluate(v->lhs.get(), variables);
+    if (rhs == -1 && lhs == std::numeric_limits<VIntS>::min())
+      throw std::runtime_error("Division overflow");
+    return lhs % rhs;
   }
   FiExpr;
   IfExpr(And, v) {
-    return evaluate(v->lhs, variables) & evaluate(v->rhs, variables);
+    return evaluate(v->lhs.get(), variables) &
+           evaluate(v->rhs.get(), variables);
   }
   FiExpr;
   IfExpr(Or, v) {
-    return evaluate(v->lhs, variables) | evaluate(v->rhs, variables);
+    return evaluate(v->lhs.get(), variables) |
+           evaluate(v->rhs.get(), variables);
   }
   FiExpr;
   IfExpr(SignExtend, v) {
-    return vsrtl::signextend(evaluate(v->lhs, variables),
-                             evaluate(v->rhs, variables));
+    return vsrtl::signextend(evaluate(v->lhs.get(), variables),
+                             evaluate(v->rhs.get(), variables));
   }
   FiExpr;
   IfExpr(Nothing, v) {
@@ -274,32 +304,69 @@ VIntS evaluate(const std::shared_ptr<Expr> &expr,
   }
   FiExpr;
   IfExpr(Literal, v) {
-    bool ok = false;
-    auto value = getImmediate(v->v, ok);
-    if (!ok) {
-      if (variables != nullptr) {
-        auto it = variables->find(v->v);
-        if (it != variables->end()) {
-          value = it->second;
-          ok = true;
-        }
-      }
+    // Numeric literals have been folded into constants during parsing; any
+    // remaining literal is a symbol.
+    if (variables != nullptr) {
+      if (auto symbolValue = (*variables)(v->v); symbolValue.has_value())
+        return symbolValue.value();
     }
+    throw std::runtime_error(
+        QString("Unknown symbol '%1'").arg(v->v).toStdString());
+  }
+  FiExpr;
+
+  Q_UNREACHABLE();
+}
+
+std::shared_ptr<Expr> fold(const std::shared_ptr<Expr> &expr);
 
-    if (!ok) {
-      throw std::runtime_error(
-          QString("Unknown symbol '%1'").arg(v->v).toStdString());
+template <typename BinOp>
+std::shared_ptr<Expr> foldBinOp(const BinOp &op) {
+  auto folded = std::make_shared<Expr>(BinOp{fold(op.lhs), fold(op.rhs)});
+  const auto &foldedOp = std::get<BinOp>(*folded);
+  if (std::holds_alternative<Constant>(*foldedOp.lhs) &&
+      std::holds_alternative<Constant>(*foldedOp.rhs)) {
+    try {
+      return std::make_shared<Expr>(Constant{evaluate(folded.get(), nullptr)});
+    } catch (const std::runtime_error &) {
+      // Errors (i.e., division by zero) are reported upon evaluation.
     }
+  }
+  return folded;
+}
 
-    return value;
+/// Returns @p expr with numeric literals and constant subexpressions replaced
+/// by their values.
+std::shared_ptr<Expr> fold(const std::shared_ptr<Expr> &expr) {
+  IfExpr(Literal, v) {
+    bool ok = false;
+    const auto value = getImmediate(v->v, ok);
+    return ok ? std::make_shared<Expr>(Constant{value}) : expr;
+  }
+  FiExpr;
+  IfExpr(Nothing, v) {
+    Q_UNUSED(v);
+    return std::make_shared<Expr>(Constant{0});
   }
   FiExpr;
 
-  Q_UNREACHABLE();
+#define tryFold(type)                                                          \
+  IfExpr(type, v) { return foldBinOp(*v); }                                    \
+  FiExpr;
+
+  tryFold(Add);
+  tryFold(Sub);
+  tryFold(Mul);
+  tryFold(Div);
+  tryFold(Mod);
+  tryFold(And);
+  tryFold(Or);
+  tryFold(SignExtend);
+
+  return expr;
 }
 
-ExprEvalRes evaluate(const Location &loc, const QString &s,
-                     const AbsoluteSymbolMap *variables) {
+Result<ExprPtr> parseExpr(const Location &loc, const QString &s) {
   QString sNoWhitespace = s;
   sNoWhitespace.replace(" ", "");
   int pos = 0;
@@ -308,14 +375,59 @@ ExprEvalRes evaluate(const Location &loc, const QString &s,
   if (auto *err = std::get_if<Error>(&exprTree)) {
     return *err;
   }
-  const auto exprTreeRes = std::get<std::shared_ptr<Expr>>(exprTree);
+  return ExprPtr(fold(std::get<std::shared_ptr<Expr>>(exprTree)));
+}
+
+ExprEvalRes evaluate(const Location &loc, const ExprPtr &expr,
+                     const SymbolLookup &lookup) {
   try {
-    return {evaluate(exprTreeRes, variables)};
+    return {evaluate(expr.get(), lookup ? &lookup : nullptr)};
   } catch (const std::runtime_error &e) {
     return {Error(loc, e.what())};
   }
 }
 
+ExprEvalRes evaluate(const Location &loc, const QString &s,
+                     const AbsoluteSymbolMap *variables) {
+  if (variables == nullptr)
+    return evaluate(loc, s, SymbolLookup());
+
+  return evaluate(
+      loc, s, [variables](const QString &name) -> std::optional<ExprEvalVT> {
+        auto it = variables->find(name);
+        if (it != variables->end())
+          return it->second;
+        return std::nullopt;
+      });
+}
+
+ExprEvalRes evaluate(const Location &loc, const QString &s,
+                     const SymbolLookup &lookup) {
+  auto expr = parseExpr(loc, s);
+  if (auto *err = std::get_if<Error>(&expr)) {
+    return *err;
+  }
+  return evaluate(loc, std::get<ExprPtr>(expr), lookup);
+}
+
+Result<ExprPtr> ExprCache::get(const Location &loc, const QString &s) {
+  auto it = m_cache.constFind(s);
+  if (it == m_cache.constEnd()) {
+    CachedExpr entry;
+    auto expr = parseExpr(loc, s);
+    if (auto *err = std::get_if<Error>(&expr))
+      entry.error = err->errorMessage();
+    else
+      entry.expr = std::get<ExprPtr>(expr);
+    it = m_cache.insert(s, entry);
+  }
+
+  // Parse errors are reported at the location of the current evaluation.
+  if (!it->expr)
+    return Error(loc, it->error);
+  return it->expr;
+}
+
 bool couldBeExpression(const QString &s) {
   return std::any_of(s_exprTokens.begin(), s_exprTokens.end(),
                      [&s](const auto &ch) { return s.contains(ch); });
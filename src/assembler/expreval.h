@@ -3,7 +3,11 @@
 #include "assembler_defines.h"
 #include "assemblererror.h"
 #include "symbolmap.h"
+#include <QHash>
 #include <QRegularExpression>
+#include <functional>
+#include <memory>
+#include <optional>
 #include <variant>
 
 namespace Ripes {
@@ -26,6 +30,51 @@ using ExprEvalRes = Result<ExprEvalVT>;
 ExprEvalRes evaluate(const Location &, const QString &,
                      const AbsoluteSymbolMap *variables = nullptr);
 
+/// Function used to resolve the value of a symbol during expression
+/// evaluation. Returns std::nullopt if the symbol is unknown.
+using SymbolLookup =
+    std::function<std::optional<ExprEvalVT>(const QString &)>;
+
+/// Evaluates an expression, resolving symbols through the provided lookup
+/// function.
+ExprEvalRes evaluate(const Location &, const QString &,
+                     const SymbolLookup &lookup);
+
+struct Expr;
+/// A parsed expression. Numeric literals and constant subexpressions are folded
+/// during parsing, such that evaluating the expression only entails resolving
+/// its symbols.
+using ExprPtr = std::shared_ptr<const Expr>;
+
+/// Parses an expression for subsequent evaluation.
+Result<ExprPtr> parseExpr(const Location &, const QString &);
+
+/// Evaluates a parsed expression, resolving symbols through the provided lookup
+/// function.
+ExprEvalRes evaluate(const Location &, const ExprPtr &,
+                     const SymbolLookup &lookup);
+
+/**
+ * @brief The ExprCache class
+ * Cache of parsed expressions, keyed by the expression string. Allows for an
+ * expression to be evaluated both before and after symbol resolution, or to be
+ * repeated throughout a program, while only being parsed once.
+ */
+class ExprCache {
+public:
+  /// Returns the parsed expression @p s, parsing it if not already cached.
+  Result<ExprPtr> get(const Location &, const QString &s);
+  void clear() { m_cache.clear(); }
+
+private:
+  struct CachedExpr {
+    ExprPtr expr;
+    /// Parse error, set if expr is unset.
+    QString error;
+  };
+  QHash<QString, CachedExpr> m_cache;
+};
+
 /**
  * @brief couldBeExpression
  * @returns true if we have probably cause that the string is an expression and
@@ -1,6 +1,8 @@
 #include "gnudirectives.h"
 #include "assembler.h"
 
+#include <numeric>
+
 namespace Ripes {
 namespace Assembler {
 
@@ -42,8 +44,8 @@ DirectiveVec gnuDirectives() {
   add_directive(directives, textDirective());
   add_directive(directives, bssDirective());
 
-  add_directive(directives, dummyDirective(".global"));
-  add_directive(directives, dummyDirective(".globl"));
+  add_directive(directives, globalDirective(".global"));
+  add_directive(directives, globalDirective(".globl"));
 
   return directives;
 }
@@ -137,6 +139,26 @@ Directive dummyDirective(const QString &name) {
       });
 }
 
+/**
+ * @brief globalDirective
+ * Generates a directive handler for @p name, which marks the symbols provided
+ * as arguments as being visible to other units during linking.
+ */
+Directive globalDirective(const QString &name) {
+  return Directive(
+      name,
+      [](const AssemblerBase *assembler,
+         const DirectiveArg &arg) -> Result<QByteArray> {
+        if (arg.line.tokens.length() < 1) {
+          return {Error(arg.line,
+                        "Invalid number of arguments (expected at least 1)")};
+        }
+        for (const auto &token : arg.line.tokens)
+          assembler->m_symbolMap.globals.insert(token);
+        return {QByteArray()};
+      });
+}
+
 Directive::DirectiveHandler genSegmentChangeFunctor(const QString &segment) {
   return [segment](const AssemblerBase *assembler, const DirectiveArg &arg) {
     if (arg.line.tokens.length() != 0) {
@@ -227,6 +249,8 @@ Directive alignDirective() {
     if (boundary == 0) {
       return {QByteArray()};
     }
+    arg.section->alignment =
+        std::lcm(arg.section->alignment, static_cast<unsigned>(boundary));
     int byteOffset =
         (arg.section->address + arg.section->data.size()) % boundary;
     int bytesToSkip = byteOffset != 0 ? boundary - byteOffset : 0;
@@ -29,6 +29,7 @@ Directive longDirective();
 Directive alignDirective();
 
 Directive dummyDirective(const QString &name);
+Directive globalDirective(const QString &name);
 
 Directive textDirective();
 Directive dataDirective();
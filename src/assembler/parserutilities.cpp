@@ -1,6 +1,7 @@
 #include "parserutilities.h"
 #include "binutils.h"
 
+#include <algorithm>
 #include <memory>
 
 namespace Ripes {
@@ -84,6 +85,12 @@ bool matchedParens(std::vector<QChar> &parensStack, QChar end) {
   return (toMatch == '[' && end == ']') || (toMatch == '(' && end == ')');
 }
 
+static bool containsParentheses(QStringView token) {
+  return std::any_of(token.begin(), token.end(), [](QChar ch) {
+    return ch == '(' || ch == ')' || ch == '[' || ch == ']';
+  });
+}
+
 Result<LineTokens> joinParentheses(const Location &loc,
                                    const QStringList &tokens) {
   LineTokens outtokens;
@@ -103,6 +110,11 @@ Result<LineTokens> joinParentheses(const Location &loc,
       outtokens << Token(token);
       continue;
     }
+    if (parensStack.empty() && !containsParentheses(token)) {
+      // Nothing to join; the token can be kept as-is.
+      outtokens << Token(token);
+      continue;
+    }
     for (const auto &ch : token) {
       switch (ch.unicode()) {
       case '(':
@@ -146,44 +158,46 @@ Result<LineTokens> joinParentheses(const Location &loc,
 
 Result<QStringList> tokenizeQuotes(const Location &location,
                                    const QString &line) {
+  // Tokens are located as (start, end) offsets into the source line, such that
+  // each token is only allocated once it is complete.
   QStringList tokens;
+  const QStringView view(line);
   bool inQuotes = false;
   bool escape = false;
-  QString substr;
-  auto pushSubstr = [&] {
-    tokens.push_back(substr);
-    substr.clear();
+  qsizetype start = -1;
+  auto pushToken = [&](qsizetype end) {
+    if (start >= 0 && end > start)
+      tokens.push_back(view.sliced(start, end - start).toString());
+    start = -1;
   };
-  for (auto &ch : line) {
+  for (qsizetype i = 0; i < view.size(); ++i) {
+    const QChar ch = view.at(i);
     if (inQuotes) {
-      if (!escape) {
-        if (inQuotes && ch == '"') {
-          inQuotes = false;
-          substr += ch;
-          pushSubstr();
-          continue;
-        }
-        if (ch == '\\')
-          escape = true;
-      } else
+      if (escape)
         escape = false;
-      substr.push_back(ch);
-    } else {
-      if (ch == ' ' || ch == ',' || ch == '\t') {
-        if (!substr.isEmpty())
-          pushSubstr();
-      } else
-        substr.push_back(ch);
-      if (ch == '\"')
-        inQuotes = true;
+      else if (ch == '\\')
+        escape = true;
+      else if (ch == '"') {
+        inQuotes = false;
+        pushToken(i + 1);
+      }
+      continue;
+    }
+
+    if (ch == ' ' || ch == ',' || ch == '\t') {
+      pushToken(i);
+      continue;
     }
+    if (start < 0)
+      start = i;
+    if (ch == '"')
+      inQuotes = true;
   }
 
   if (inQuotes)
     return {Error(location, "Missing terminating '\"' character.")};
 
-  tokens.push_back(substr);
-  tokens.removeAll(QLatin1String(""));
+  pushToken(view.size());
   return {tokens};
 }
 
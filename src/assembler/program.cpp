@@ -4,6 +4,16 @@
 
 namespace Ripes {
 
+/// Returns the little-endian word of up to @p bytes bytes at @p offset in
+/// @p data.
+static VInt readWord(const QByteArray &data, AInt offset, unsigned bytes) {
+  VInt word = 0;
+  for (unsigned i = 0; i < bytes && offset + i < AInt(data.size()); ++i)
+    word |= static_cast<VInt>(static_cast<uint8_t>(data.at(offset + i)))
+            << (CHAR_BIT * i);
+  return word;
+}
+
 const ProgramSection *Program::getSection(const QString &name) const {
   const auto secIter =
       std::find_if(sections.begin(), sections.end(),
@@ -17,47 +27,57 @@ const ProgramSection *Program::getSection(const QString &name) const {
 }
 
 void DisassembledProgram::clear() {
-  addressToDisresMap.clear();
-  indexToAddressMap.clear();
-  addressToIndexMap.clear();
+  std::lock_guard lock(m_cacheMutex);
+  m_addresses.clear();
+  m_cache.clear();
+  m_cacheIndex.clear();
 }
 
-bool DisassembledProgram::empty() const { return addressToDisresMap.empty(); }
+bool DisassembledProgram::empty() const { return m_addresses.empty(); }
+
+void DisassembledProgram::append(VInt address) {
+  assert((m_addresses.empty() || m_addresses.back() < address) &&
+         "Addresses must be appended in increasing order");
+  m_addresses.push_back(address);
+}
 
 std::optional<VInt> DisassembledProgram::indexToAddress(unsigned idx) const {
-  auto it = indexToAddressMap.find(idx);
-  if (it != indexToAddressMap.end())
-    return it->second;
+  if (idx < m_addresses.size())
+    return m_addresses[idx];
   return std::nullopt;
 }
 
 std::optional<unsigned> DisassembledProgram::addressToIndex(VInt addr) const {
-  auto it = addressToIndexMap.find(addr);
-  if (it != addressToIndexMap.end())
-    return it->second;
+  auto it = std::lower_bound(m_addresses.begin(), m_addresses.end(), addr);
+  if (it != m_addresses.end() && *it == addr)
+    return std::distance(m_addresses.begin(), it);
   return std::nullopt;
 }
 
-void DisassembledProgram::set(unsigned int idx, VInt address,
-                              const QString &disres) {
-  assert(indexToAddressMap.count(idx) == 0);
-  assert(addressToDisresMap.count(address) == 0);
-  indexToAddressMap[idx] = address;
-  addressToIndexMap[address] = idx;
-  addressToDisresMap[address] = disres;
-}
-
 std::optional<QString> DisassembledProgram::getFromAddr(VInt address) const {
-  auto it = addressToDisresMap.find(address);
-  if (it != addressToDisresMap.end())
-    return {it->second};
-  return {};
+  std::lock_guard lock(m_cacheMutex);
+  auto cacheIt = m_cacheIndex.find(address);
+  if (cacheIt != m_cacheIndex.end()) {
+    // Move the entry to the front of the LRU list.
+    m_cache.splice(m_cache.begin(), m_cache, cacheIt->second);
+    return {cacheIt->second->second};
+  }
+
+  if (!m_disassembler || !addressToIndex(address).has_value())
+    return {};
+
+  m_cache.emplace_front(address, m_disassembler(address));
+  m_cacheIndex[address] = m_cache.begin();
+  if (m_cache.size() > s_cacheSize) {
+    m_cacheIndex.erase(m_cache.back().first);
+    m_cache.pop_back();
+  }
+  return {m_cache.front().second};
 }
 
 std::optional<QString> DisassembledProgram::getFromIdx(unsigned idx) const {
-  auto it = indexToAddressMap.find(idx);
-  if (it != indexToAddressMap.end())
-    return getFromAddr(it->second);
+  if (auto addr = indexToAddress(idx); addr.has_value())
+    return getFromAddr(addr.value());
   return {};
 }
 
@@ -69,31 +89,36 @@ const DisassembledProgram &Program::getDisassembled() const {
   }
   if (disassembled.empty()) {
     auto &assembler = ProcessorHandler::getAssembler();
-    auto &memory = ProcessorHandler::getMemory();
-    auto &symbols = ProcessorHandler::getProgram()->symbols;
-
-    // Initialize caching
     const unsigned instrBytes = ProcessorHandler::currentISA()->instrBytes();
     const VInt textSectionBaseAddr = textSection->address;
-    unsigned line = 0;
-    for (AInt addr = 0;
-         addr < static_cast<AInt>(ProcessorHandler::getCurrentProgramSize());) {
-      const VInt disassembleAddr = addr + textSectionBaseAddr;
-      auto disRes =
-          assembler->disassemble(memory.readMem(disassembleAddr, instrBytes),
-                                 symbols, disassembleAddr);
-      // todo(mortbopet): shouldn't we do something about the possibility of the
-      // disassembling returning an error?
-      const VInt realAddr = textSectionBaseAddr + addr;
-      disassembled.set(line, realAddr, disRes.repr);
-      if (disRes.err.has_value()) {
-        // Error during disassembled; we'll just have to increment the address
+    const QByteArray &data = textSection->data;
+
+    // Build the instruction index. Only the size of each instruction is
+    // determined here; disassembly is deferred until an instruction is
+    // requested.
+    for (AInt addr = 0; addr < static_cast<AInt>(data.size());) {
+      const VInt word = readWord(data, addr, instrBytes);
+      disassembled.append(textSectionBaseAddr + addr);
+      if (auto size = assembler->instructionSize(word); size.has_value())
+        addr += size.value();
+      else {
+        // Unknown instruction; we'll just have to increment the address
         // counter by the default instruction size of the ISA.
         addr += instrBytes;
-      } else
-        addr += disRes.bytesDisassembled;
-      ++line;
+      }
     }
+
+    // Instructions are disassembled from the program's own text section,
+    // rather than from simulator memory which may be modified by a running
+    // simulation.
+    auto symbolsCopy = std::make_shared<const ReverseSymbolMap>(symbols);
+    disassembled.setDisassembler([=](VInt address) {
+      const VInt word =
+          readWord(data, address - textSectionBaseAddr, instrBytes);
+      // todo(mortbopet): shouldn't we do something about the possibility of the
+      // disassembling returning an error?
+      return assembler->disassemble(word, *symbolsCopy, address).repr;
+    });
   }
   return disassembled;
 }
@@ -5,8 +5,12 @@
 #include <QMap>
 #include <QMetaType>
 #include <QString>
+#include <functional>
+#include <list>
+#include <mutex>
 #include <optional>
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 #include "ripes_types.h"
@@ -65,6 +69,8 @@ public:
   unsigned type = 0;
 };
 
+/// Ordered mapping of [address : symbol]. Kept ordered since it is used for
+/// address-ordered traversal and range queries.
 using ReverseSymbolMap = std::map<AInt, Symbol>;
 
 struct LoadFileParams {
@@ -78,13 +84,49 @@ struct ProgramSection {
   QString name;
   AInt address;
   QByteArray data;
+  /// Alignment (in bytes) required of the section address, as requested by
+  /// .align directives within the section. Respected when linking separately
+  /// assembled units.
+  unsigned alignment = 1;
 };
 
+/**
+ * @brief The DisassembledProgram class
+ * Flat index of the instructions in a program's text section. The index
+ * (instruction index <-> address) is built in a single linear pass over the
+ * text section, whereas the disassembled text of each instruction is only
+ * produced when requested, and kept in a bounded LRU cache. This allows views
+ * to only pay for the disassembly of the rows which are actually visible.
+ * The cache is guarded by a mutex, such that instructions may be requested
+ * from multiple threads.
+ */
 class DisassembledProgram {
 public:
-  /// Associates the given address and index with the disassembled instruction
-  /// string
-  void set(unsigned idx, VInt address, const QString &disres);
+  DisassembledProgram() = default;
+  /// Copies the instruction index and disassembler; the cache is not copied.
+  DisassembledProgram(const DisassembledProgram &other)
+      : m_addresses(other.m_addresses), m_disassembler(other.m_disassembler) {}
+  DisassembledProgram &operator=(const DisassembledProgram &other) {
+    if (this != &other) {
+      clear();
+      m_addresses = other.m_addresses;
+      m_disassembler = other.m_disassembler;
+    }
+    return *this;
+  }
+
+  /// A function which returns the disassembled representation of the
+  /// instruction at the provided address.
+  using Disassembler = std::function<QString(VInt address)>;
+
+  /// Appends an instruction at the given address to the index. Addresses must
+  /// be appended in strictly increasing order.
+  void append(VInt address);
+
+  /// Sets the function used for lazily disassembling instructions.
+  void setDisassembler(const Disassembler &disassembler) {
+    m_disassembler = disassembler;
+  }
 
   /// Returns the disassembled instruction for the given index.
   std::optional<QString> getFromIdx(unsigned idx) const;
@@ -101,16 +143,24 @@ public:
   /// Returns true if no disassembled program has been set.
   bool empty() const;
 
-  unsigned numInstructions() const { return indexToAddressMap.size(); }
+  unsigned numInstructions() const { return m_addresses.size(); }
 
 private:
-  /// An ordered map of [instruction address : disassembled instruction]
-  std::map<VInt, QString> addressToDisresMap;
+  /// Maximum number of disassembled instruction strings kept in the cache.
+  static constexpr unsigned s_cacheSize = 4096;
+
+  /// Ordered vector of instruction addresses. The index of an address in this
+  /// vector is the index of the instruction within the program.
+  std::vector<VInt> m_addresses;
+
+  Disassembler m_disassembler;
 
-  /// Ordered maps of the index of a given disassembled instruction to its
-  /// address.
-  std::map<unsigned, VInt> indexToAddressMap;
-  std::map<VInt, unsigned> addressToIndexMap;
+  /// LRU cache of [instruction address : disassembled instruction]. The most
+  /// recently used entry is at the front of the list.
+  using CacheList = std::list<std::pair<VInt, QString>>;
+  mutable CacheList m_cache;
+  mutable std::unordered_map<VInt, CacheList::iterator> m_cacheIndex;
+  mutable std::mutex m_cacheMutex;
 };
 
 /**
@@ -140,8 +190,9 @@ public:
   /// nullptr if no section was found with the given name.
   const ProgramSection *getSection(const QString &name) const;
 
-  /// Returns the disassembled version of this program. The result is an ordered
-  /// map of [instruction address : disassembled instruction]
+  /// Returns the disassembled version of this program. The instruction index
+  /// is built upon the first call; instruction strings are disassembled
+  /// on demand.
   const DisassembledProgram &getDisassembled() const;
   const SourceMapping &getSourceMapping() const;
 
@@ -155,4 +206,11 @@ private:
 
 } // namespace Ripes
 
+template <>
+struct std::hash<Ripes::Symbol> {
+  std::size_t operator()(const Ripes::Symbol &s) const noexcept {
+    return qHash(s.v);
+  }
+};
+
 Q_DECLARE_METATYPE(Ripes::SourceType);
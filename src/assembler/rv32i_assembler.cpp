@@ -40,6 +40,13 @@ RV32I_Assembler::RV32I_Assembler(const ISAInfo<ISA::RV32I> *isa)
   RipesSettings::getObserver(RIPES_SETTING_ASSEMBLER_BSSSTART)->trigger();
 }
 
+std::unique_ptr<AssemblerBase> RV32I_Assembler::clone() const {
+  auto assembler = std::make_unique<RV32I_Assembler>(
+      static_cast<const ISAInfo<ISA::RV32I> *>(m_isa));
+  assembler->m_sectionBasePointers = m_sectionBasePointers;
+  return assembler;
+}
+
 std::tuple<RV32I_Assembler::_InstrVec, RV32I_Assembler::_PseudoInstrVec>
 RV32I_Assembler::initInstructions(const ISAInfo<ISA::RV32I> *isa) const {
   _InstrVec instructions;
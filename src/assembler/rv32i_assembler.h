@@ -15,6 +15,7 @@ class RV32I_Assembler : public QObject, public Assembler<uint32_t> {
 public:
   using Reg_T = uint32_t;
   RV32I_Assembler(const ISAInfo<ISA::RV32I> *isa);
+  std::unique_ptr<AssemblerBase> clone() const override;
 
 private:
   std::tuple<_InstrVec, _PseudoInstrVec>
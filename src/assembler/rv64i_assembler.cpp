@@ -42,6 +42,13 @@ RV64I_Assembler::RV64I_Assembler(const ISAInfo<ISA::RV64I> *isa)
   RipesSettings::getObserver(RIPES_SETTING_ASSEMBLER_BSSSTART)->trigger();
 }
 
+std::unique_ptr<AssemblerBase> RV64I_Assembler::clone() const {
+  auto assembler = std::make_unique<RV64I_Assembler>(
+      static_cast<const ISAInfo<ISA::RV64I> *>(m_isa));
+  assembler->m_sectionBasePointers = m_sectionBasePointers;
+  return assembler;
+}
+
 std::tuple<RV64I_Assembler::_InstrVec, RV64I_Assembler::_PseudoInstrVec>
 RV64I_Assembler::initInstructions(const ISAInfo<ISA::RV64I> *isa) const {
   _InstrVec instructions;
@@ -67,27 +74,7 @@ void RV64I_Assembler::enableExtI(const ISAInfoBase *isa,
                                  _InstrVec &instructions,
                                  _PseudoInstrVec &pseudoInstructions) {
   RV_I<Reg_T>::enable(isa, instructions, pseudoInstructions,
-                      {RV_I<Reg_T>::Options::shifts64BitVariant,
-                       RV_I<Reg_T>::Options::LI64BitVariant});
-
-  instructions.push_back(IType32(Token("addiw"), 0b000));
-
-  instructions.push_back(
-      IShiftType64(Token("slli"), RVISA::OPIMM, 0b001, 0b000000));
-  instructions.push_back(
-      IShiftType64(Token("srli"), RVISA::OPIMM, 0b101, 0b000000));
-  instructions.push_back(
-      IShiftType64(Token("srai"), RVISA::OPIMM, 0b101, 0b010000));
-
-  instructions.push_back(RType32(Token("addw"), 0b000, 0b0000000));
-  instructions.push_back(RType32(Token("subw"), 0b000, 0b0100000));
-  instructions.push_back(RType32(Token("sllw"), 0b001, 0b0000000));
-  instructions.push_back(RType32(Token("srlw"), 0b101, 0b0000000));
-  instructions.push_back(RType32(Token("sraw"), 0b101, 0b0100000));
-
-  instructions.push_back(LoadType(Token("lwu"), 0b110));
-  instructions.push_back(LoadType(Token("ld"), 0b011));
-  instructions.push_back(SType(Token("sd"), 0b011));
+                      {RV_I<Reg_T>::Options::LI64BitVariant});
 
   pseudoInstructions.push_back(PseudoLoad(Token("ld")));
   pseudoInstructions.push_back(PseudoStore(Token("sd")));
@@ -110,12 +97,6 @@ void RV64I_Assembler::enableExtM(const ISAInfoBase *isa,
                                  _InstrVec &instructions,
                                  _PseudoInstrVec &pseudoInstructions) {
   RV_M<Reg_T>::enable(isa, instructions, pseudoInstructions);
-
-  instructions.push_back(RType32(Token("mulw"), 0b000, 0b0000001));
-  instructions.push_back(RType32(Token("divw"), 0b100, 0b0000001));
-  instructions.push_back(RType32(Token("divuw"), 0b101, 0b0000001));
-  instructions.push_back(RType32(Token("remw"), 0b110, 0b0000001));
-  instructions.push_back(RType32(Token("remuw"), 0b111, 0b0000001));
 }
 
 } // namespace Assembler
@@ -14,6 +14,7 @@ class RV64I_Assembler : public QObject, public Assembler<uint64_t> {
 
 public:
   RV64I_Assembler(const ISAInfo<ISA::RV64I> *isa);
+  std::unique_ptr<AssemblerBase> clone() const override;
 
 private:
   std::tuple<_InstrVec, _PseudoInstrVec>
@@ -20,9 +20,7 @@ template <typename Reg__T>
 struct RV_I {
   AssemblerTypes(Reg__T);
   enum class Options {
-    shifts64BitVariant, // appends 'w' to 32-bit shift operations, for use in
-                        // the 64-bit RISC-V ISA
-    LI64BitVariant      // Modifies LI to be able to emit 64-bit constants
+    LI64BitVariant // Modifies LI to be able to emit 64-bit constants
   };
 
   static void enable(const ISAInfoBase *isa, _InstrVec &instructions,
@@ -169,8 +167,62 @@ struct RV_I {
         new _PseudoInstruction(Token("bleu"), {RegTok, RegTok, ImmTok}, _PseudoExpandFunc(line) {
             return LineTokensVec{LineTokens{Token("bgeu"), line.tokens.at(2), line.tokens.at(1), line.tokens.at(3)}};
         })));
+
+    pseudoInstructions.push_back(std::shared_ptr<_PseudoInstruction>(
+        new _PseudoInstruction(Token("csrr"), {RegTok, ImmTok}, _PseudoExpandFunc(line) {
+            return LineTokensVec{LineTokens{Token("csrrs"), line.tokens.at(1), line.tokens.at(2), Token("x0")}};
+        })));
+
+    pseudoInstructions.push_back(std::shared_ptr<_PseudoInstruction>(
+        new _PseudoInstruction(Token("csrw"), {ImmTok, RegTok}, _PseudoExpandFunc(line) {
+            return LineTokensVec{LineTokens{Token("csrrw"), Token("x0"), line.tokens.at(1), line.tokens.at(2)}};
+        })));
+
+    pseudoInstructions.push_back(std::shared_ptr<_PseudoInstruction>(
+        new _PseudoInstruction(Token("csrs"), {ImmTok, RegTok}, _PseudoExpandFunc(line) {
+            return LineTokensVec{LineTokens{Token("csrrs"), Token("x0"), line.tokens.at(1), line.tokens.at(2)}};
+        })));
+
+    pseudoInstructions.push_back(std::shared_ptr<_PseudoInstruction>(
+        new _PseudoInstruction(Token("csrc"), {ImmTok, RegTok}, _PseudoExpandFunc(line) {
+            return LineTokensVec{LineTokens{Token("csrrc"), Token("x0"), line.tokens.at(1), line.tokens.at(2)}};
+        })));
+
+    pseudoInstructions.push_back(std::shared_ptr<_PseudoInstruction>(
+        new _PseudoInstruction(Token("csrwi"), {ImmTok, ImmTok}, _PseudoExpandFunc(line) {
+            return LineTokensVec{LineTokens{Token("csrrwi"), Token("x0"), line.tokens.at(1), line.tokens.at(2)}};
+        })));
+
+    pseudoInstructions.push_back(std::shared_ptr<_PseudoInstruction>(
+        new _PseudoInstruction(Token("csrsi"), {ImmTok, ImmTok}, _PseudoExpandFunc(line) {
+            return LineTokensVec{LineTokens{Token("csrrsi"), Token("x0"), line.tokens.at(1), line.tokens.at(2)}};
+        })));
+
+    pseudoInstructions.push_back(std::shared_ptr<_PseudoInstruction>(
+        new _PseudoInstruction(Token("csrci"), {ImmTok, ImmTok}, _PseudoExpandFunc(line) {
+            return LineTokensVec{LineTokens{Token("csrrci"), Token("x0"), line.tokens.at(1), line.tokens.at(2)}};
+        })));
     // clang-format on
 
+    // Counter read pseudo-instructions; rdcycle, rdtime, rdinstret and their
+    // upper-half variants on RV32.
+    QStringList counters = {"cycle", "time", "instret"};
+    if (isa->bits() == 32)
+      counters << "cycleh"
+               << "timeh"
+               << "instreth";
+    for (const auto &counter : std::as_const(counters)) {
+      pseudoInstructions.push_back(std::shared_ptr<_PseudoInstruction>(
+          new _PseudoInstruction(Token("rd" + counter), {RegTok},
+                                 [counter](const _PseudoInstruction &,
+                                           const TokenizedSrcLine &line,
+                                           const SymbolMap &) {
+                                   return LineTokensVec{LineTokens{
+                                       Token("csrrs"), line.tokens.at(1),
+                                       Token(counter), Token("x0")}};
+                                 })));
+    }
+
     pseudoInstructions.push_back(std::shared_ptr<
                                  _PseudoInstruction>(new _PseudoInstruction(
         Token("li"), {RegTok, ImmTok}, _PseudoExpandFuncSyms(line, symbols) {
@@ -183,12 +235,12 @@ struct RV_I {
           int64_t immediate = getImmediateSext32(line.tokens.at(2), canConvert);
 
           if (!canConvert) {
-            auto absSymbols = symbols.copyRelativeTo(line.sourceLine());
             // Check if the immediate has been made available in the symbol set
             // at this point...
-            auto it = absSymbols.find(line.tokens.at(2));
-            if (it != absSymbols.end()) {
-              immediate = it->second;
+            auto symbolValue =
+                symbols.lookup(line.tokens.at(2), line.sourceLine());
+            if (symbolValue.has_value()) {
+              immediate = symbolValue.value();
             } else {
               if (unsignedFitErr) {
                 return Result<std::vector<LineTokens>>{
@@ -259,75 +311,7 @@ struct RV_I {
         })));
 
     // Assembler functors
-
-    instructions.push_back(std::shared_ptr<_Instruction>(new _Instruction(
-        _Opcode(Token("ecall"),
-                {OpPart(RVISA::Opcode::ECALL, 0, 6), OpPart(0, 7, 31)}),
-        {})));
-
-    instructions.push_back(UType(Token("lui"), RVISA::Opcode::LUI));
-
-    instructions.push_back(std::shared_ptr<_Instruction>(new _Instruction(
-        _Opcode(Token("auipc"), {OpPart(RVISA::Opcode::AUIPC, 0, 6)}),
-        {std::make_shared<_Reg>(isa, 1, 7, 11, "rd"),
-         std::make_shared<_Imm>(2, 32, _Imm::Repr::Hex,
-                                std::vector{ImmPart(0, 12, 31)},
-                                _Imm::SymbolType::Absolute)})));
-
-    instructions.push_back(JType(Token("jal"), RVISA::Opcode::JAL));
-
-    instructions.push_back(JALRType(Token("jalr")));
-
-    instructions.push_back(LoadType(Token("lb"), 0b000));
-    instructions.push_back(LoadType(Token("lh"), 0b001));
-    instructions.push_back(LoadType(Token("lw"), 0b010));
-    instructions.push_back(LoadType(Token("lbu"), 0b100));
-    instructions.push_back(LoadType(Token("lhu"), 0b101));
-
-    instructions.push_back(SType(Token("sb"), 0b000));
-    instructions.push_back(SType(Token("sh"), 0b001));
-    instructions.push_back(SType(Token("sw"), 0b010));
-
-    instructions.push_back(IType(Token("addi"), 0b000));
-    instructions.push_back(IType(Token("slti"), 0b010));
-    instructions.push_back(IType(Token("sltiu"), 0b011));
-    instructions.push_back(IType(Token("xori"), 0b100));
-    instructions.push_back(IType(Token("ori"), 0b110));
-    instructions.push_back(IType(Token("andi"), 0b111));
-
-    if (options.count(Options::shifts64BitVariant)) {
-      instructions.push_back(
-          IShiftType32(Token("slliw"), RVISA::OPIMM32, 0b001, 0b0000000));
-      instructions.push_back(
-          IShiftType32(Token("srliw"), RVISA::OPIMM32, 0b101, 0b0000000));
-      instructions.push_back(
-          IShiftType32(Token("sraiw"), RVISA::OPIMM32, 0b101, 0b0100000));
-    } else {
-      instructions.push_back(
-          IShiftType32(Token("slli"), RVISA::OPIMM, 0b001, 0b0000000));
-      instructions.push_back(
-          IShiftType32(Token("srli"), RVISA::OPIMM, 0b101, 0b0000000));
-      instructions.push_back(
-          IShiftType32(Token("srai"), RVISA::OPIMM, 0b101, 0b0100000));
-    }
-
-    instructions.push_back(RType(Token("add"), 0b000, 0b0000000));
-    instructions.push_back(RType(Token("sub"), 0b000, 0b0100000));
-    instructions.push_back(RType(Token("sll"), 0b001, 0b0000000));
-    instructions.push_back(RType(Token("slt"), 0b010, 0b0000000));
-    instructions.push_back(RType(Token("sltu"), 0b011, 0b0000000));
-    instructions.push_back(RType(Token("xor"), 0b100, 0b0000000));
-    instructions.push_back(RType(Token("srl"), 0b101, 0b0000000));
-    instructions.push_back(RType(Token("sra"), 0b101, 0b0100000));
-    instructions.push_back(RType(Token("or"), 0b110, 0b0000000));
-    instructions.push_back(RType(Token("and"), 0b111, 0b0000000));
-
-    instructions.push_back(BType(Token("beq"), 0b000));
-    instructions.push_back(BType(Token("bne"), 0b001));
-    instructions.push_back(BType(Token("blt"), 0b100));
-    instructions.push_back(BType(Token("bge"), 0b101));
-    instructions.push_back(BType(Token("bltu"), 0b110));
-    instructions.push_back(BType(Token("bgeu"), 0b111));
+    RV_Table<Reg__T>::enable(isa, instructions, 'I');
   }
 };
 
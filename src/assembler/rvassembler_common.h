@@ -1,11 +1,51 @@
 #pragma once
 
+#include "../isa/rvcsr.h"
+#include "../isa/rvinstrtable.h"
 #include "../isa/rvisainfo_common.h"
 #include "assembler.h"
 
 namespace Ripes {
 namespace Assembler {
 
+/**
+ * @brief The Csr struct
+ * The CSR operand of the Zicsr instructions. CSRs may be referred to by their
+ * name (see isa/rvcsr.h) or by their 12-bit number.
+ */
+template <typename Reg_T>
+struct Csr : public Field<Reg_T> {
+  Csr(unsigned _tokenIndex) : Field<Reg_T>(_tokenIndex) {}
+
+  std::optional<Error> apply(const TokenizedSrcLine &line, Instr_T &instruction,
+                             FieldLinkRequest<Reg_T> &) const override {
+    const QString &csrToken = line.tokens[this->tokenIndex];
+    auto csr = RVISA::csrNumber(csrToken);
+    if (!csr) {
+      bool success;
+      const int64_t value = getImmediate(csrToken, success);
+      if (success && isUInt<12>(value))
+        csr = static_cast<unsigned>(value);
+    }
+    if (!csr)
+      return Error(line, "Unknown CSR '" + csrToken + "'");
+    instruction |= m_range.apply(*csr);
+    return std::nullopt;
+  }
+  std::optional<Error> decode(const Instr_T instruction,
+                              const Reg_T /*address*/, const ReverseSymbolMap &,
+                              LineTokens &line) const override {
+    const unsigned csr = m_range.decode(instruction);
+    const QString name = RVISA::csrName(csr);
+    line.push_back(name.isEmpty() ? "0x" + QString::number(csr, 16) : name);
+    return std::nullopt;
+  }
+
+  std::vector<BitRange> bitRanges() const override { return {m_range}; }
+
+  const BitRange m_range = BitRange(20, 31);
+};
+
 // The following macros assumes that ASSEMBLER_TYPES(..., ...) has been defined
 // for the given assembler.
 
@@ -107,6 +147,23 @@ namespace Assembler {
        std::make_shared<_Imm>(3, 12, _Imm::Repr::Signed,                       \
                               std::vector{ImmPart(0, 20, 31)})}))
 
+#define CsrType(name, funct3)                                                  \
+  std::shared_ptr<_Instruction>(new _Instruction(                              \
+      _Opcode(name,                                                            \
+              {OpPart(RVISA::Opcode::SYSTEM, 0, 6), OpPart(funct3, 12, 14)}),  \
+      {std::make_shared<_Reg>(isa, 1, 7, 11, "rd"),                            \
+       std::make_shared<Csr<Reg__T>>(2),                                       \
+       std::make_shared<_Reg>(isa, 3, 15, 19, "rs1")}))
+
+#define CsrImmType(name, funct3)                                               \
+  std::shared_ptr<_Instruction>(new _Instruction(                              \
+      _Opcode(name,                                                            \
+              {OpPart(RVISA::Opcode::SYSTEM, 0, 6), OpPart(funct3, 12, 14)}),  \
+      {std::make_shared<_Reg>(isa, 1, 7, 11, "rd"),                            \
+       std::make_shared<Csr<Reg__T>>(2),                                       \
+       std::make_shared<_Imm>(3, 5, _Imm::Repr::Unsigned,                      \
+                              std::vector{ImmPart(0, 15, 19)})}))
+
 #define RegTok _PseudoInstruction::reg()
 #define ImmTok _PseudoInstruction::imm()
 #define Create_PseudoInstruction
@@ -154,5 +211,80 @@ namespace Assembler {
         return Result<std::vector<LineTokens>>(v);                             \
       }))
 
+/**
+ * Instruction table enabler.
+ * Registers the instructions of the RISC-V instruction table (see
+ * isa/rvinstrtable.h) which are provided by the given extension, for the
+ * register width of the given ISA.
+ */
+template <typename Reg__T>
+struct RV_Table {
+  AssemblerTypes(Reg__T);
+  static void enable(const ISAInfoBase *isa, _InstrVec &instructions,
+                     char extension) {
+    const unsigned xlen = isa->bits();
+    for (const auto &enc : RVISA::Instructions) {
+      if (enc.extension != extension || enc.xlen > xlen)
+        continue;
+
+      const Token name(enc.mnemonic);
+      switch (enc.format) {
+      case RVISA::InstrFormat::R:
+        instructions.push_back(
+            RTypeCommon(name, enc.opcode, enc.funct3, enc.funct7));
+        break;
+      case RVISA::InstrFormat::I:
+        instructions.push_back(ITypeCommon(enc.opcode, name, enc.funct3));
+        break;
+      case RVISA::InstrFormat::IShift:
+        // On RV64, the shift amount of the full-width shifts extends into the
+        // lowest bit of funct7.
+        if (xlen == 64 && enc.opcode == RVISA::OPIMM)
+          instructions.push_back(
+              IShiftType64(name, enc.opcode, enc.funct3, enc.funct7 >> 1));
+        else
+          instructions.push_back(
+              IShiftType32(name, enc.opcode, enc.funct3, enc.funct7));
+        break;
+      case RVISA::InstrFormat::Load:
+        instructions.push_back(LoadType(name, enc.funct3));
+        break;
+      case RVISA::InstrFormat::S:
+        instructions.push_back(SType(name, enc.funct3));
+        break;
+      case RVISA::InstrFormat::B:
+        instructions.push_back(BType(name, enc.funct3));
+        break;
+      case RVISA::InstrFormat::U:
+        if (enc.opcode == RVISA::AUIPC) {
+          instructions.push_back(std::shared_ptr<_Instruction>(
+              new _Instruction(_Opcode(name, {OpPart(enc.opcode, 0, 6)}),
+                               {std::make_shared<_Reg>(isa, 1, 7, 11, "rd"),
+                                std::make_shared<_Imm>(
+                                    2, 32, _Imm::Repr::Hex,
+                                    std::vector{ImmPart(0, 12, 31)},
+                                    _Imm::SymbolType::Absolute)})));
+        } else {
+          instructions.push_back(UType(name, enc.opcode));
+        }
+        break;
+      case RVISA::InstrFormat::J:
+        instructions.push_back(JType(name, enc.opcode));
+        break;
+      case RVISA::InstrFormat::System:
+        instructions.push_back(std::shared_ptr<_Instruction>(new _Instruction(
+            _Opcode(name, {OpPart(enc.opcode, 0, 6), OpPart(0, 7, 31)}), {})));
+        break;
+      case RVISA::InstrFormat::Csr:
+        instructions.push_back(CsrType(name, enc.funct3));
+        break;
+      case RVISA::InstrFormat::CsrImm:
+        instructions.push_back(CsrImmType(name, enc.funct3));
+        break;
+      }
+    }
+  }
+};
+
 } // namespace Assembler
 } // namespace Ripes
@@ -26,24 +26,32 @@ std::optional<Error> SymbolMap::addRelSymbol(const unsigned &line,
   return {};
 }
 
-AbsoluteSymbolMap SymbolMap::copyRelativeTo(unsigned line,
-                                            const QString &beforeSuffix,
-                                            const QString &afterSuffix) const {
-  AbsoluteSymbolMap res = abs;
-
-  for (auto &relSymbols : rel) {
-    auto ub = relSymbols.second.upper_bound(line);
-    if (ub != relSymbols.second.end())
-      res[QString::number(relSymbols.first) + afterSuffix] = ub->second;
-
-    if (ub != relSymbols.second.begin()) {
-      auto lb = ub;
-      std::advance(lb, -1);
-      res[QString::number(relSymbols.first) + beforeSuffix] = lb->second;
+std::optional<VIntS> SymbolMap::lookup(const QString &s, unsigned line,
+                                       const QString &beforeSuffix,
+                                       const QString &afterSuffix) const {
+  // Relative symbols take precedence over absolute symbols.
+  if (!rel.empty()) {
+    const bool before = s.endsWith(beforeSuffix);
+    if (before || s.endsWith(afterSuffix)) {
+      bool ok;
+      const int id =
+          s.left(s.size() - (before ? beforeSuffix : afterSuffix).size())
+              .toInt(&ok);
+      auto relSymbols = rel.find(id);
+      if (ok && relSymbols != rel.end()) {
+        auto ub = relSymbols->second.upper_bound(line);
+        if (!before && ub != relSymbols->second.end())
+          return ub->second;
+        if (before && ub != relSymbols->second.begin())
+          return std::prev(ub)->second;
+      }
     }
   }
 
-  return res;
+  auto it = abs.find(s);
+  if (it != abs.end())
+    return it->second;
+  return std::nullopt;
 }
 
 } // namespace Assembler
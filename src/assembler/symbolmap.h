@@ -2,20 +2,28 @@
 
 #include "assembler_defines.h"
 #include <optional>
+#include <set>
+#include <unordered_map>
 
 namespace Ripes {
 namespace Assembler {
 
-using AbsoluteSymbolMap = std::map<Symbol, VIntS>;
+/// Hashed mapping of [symbol : value]. Symbol lookups are the hot path during
+/// assembling, whereas no ordering of the symbols is required.
+using AbsoluteSymbolMap = std::unordered_map<Symbol, VIntS>;
 struct SymbolMap {
   AbsoluteSymbolMap abs;
   using RelativeSymbol = int;
   using SourceLine = unsigned;
   std::map<RelativeSymbol, std::map<SourceLine, VIntS>> rel;
+  /// Symbols declared through .global/.globl, which are visible to other units
+  /// when linking separately assembled units.
+  std::set<QString> globals;
 
   void clear() {
     abs.clear();
     rel.clear();
+    globals.clear();
   }
 
   std::optional<Error> addSymbol(const TokenizedSrcLine &line, const Symbol &s,
@@ -45,12 +53,12 @@ struct SymbolMap {
   std::optional<Error> addRelSymbol(const unsigned &line, const Symbol &s,
                                     VInt v);
 
-  /// Returns a copy of this symbol map with relative symbols copied relative to
-  /// 'line'. Relative symbols may be suffixed with additional strings in cases
-  /// of being before/after the provided source line.
-  AbsoluteSymbolMap copyRelativeTo(unsigned line,
-                                   const QString &beforeSuffix = "b",
-                                   const QString &afterSuffix = "f") const;
+  /// Returns the value of symbol 's' as seen from 'line'. Relative symbols are
+  /// referenced by suffixing them with 'beforeSuffix' or 'afterSuffix', in
+  /// which case the closest definition before/after 'line' is returned.
+  std::optional<VIntS> lookup(const QString &s, unsigned line,
+                              const QString &beforeSuffix = "b",
+                              const QString &afterSuffix = "f") const;
 };
 
 } // namespace Assembler
@@ -3,6 +3,7 @@
 #include "io/iomanager.h"
 #include "loaddialog.h"
 #include "processorhandler.h"
+#include "programcache.h"
 #include "ripessettings.h"
 #include "utilities/systemutils.h"
 
@@ -134,6 +135,18 @@ CCManager::CCRes CCManager::compile(const QStringList &files, QString outname,
   const auto cc = createCompileCommand(files, outname);
   res.cc = cc;
 
+  // Reuse a previously compiled executable for identical inputs.
+  const QString cachedExecutable =
+      ProgramCache::get().cachedExecutable(cc, files, outname);
+  if (!cachedExecutable.isEmpty() && QFile::copy(cachedExecutable, outname)) {
+    auto elfInfo = LoadDialog::validateELFFile(QFile(outname));
+    if (elfInfo.valid) {
+      res.success = true;
+      return res;
+    }
+    QFile::remove(outname);
+  }
+
   // Run compiler
 
   /**
@@ -181,6 +194,9 @@ CCManager::CCRes CCManager::compile(const QStringList &files, QString outname,
   res.errorOutput.errMsg = elfInfo.errorMessage;
   res.aborted = m_aborted;
 
+  if (res.success)
+    ProgramCache::get().storeExecutable(cc, files, outname, outname);
+
   return res;
 #else
   CCRes res;
@@ -0,0 +1,469 @@
+#include "batchrunner.h"
+#include "clirunner.h"
+#include "hostprofile.h"
+#include "syscall/systemio.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QProcess>
+#include <QTextStream>
+#include <QThread>
+
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace Ripes {
+
+// Number of trailing bytes of a failed worker's console output which are
+// included in the report.
+static constexpr qint64 kLogTailBytes = 2048;
+
+// Returns a manifest value which may be either a string or a list of strings
+// as a list of strings.
+static QStringList stringList(const QJsonValue &v) {
+  if (v.isArray()) {
+    QStringList list;
+    for (const auto &item : v.toArray())
+      list << item.toVariant().toString();
+    return list;
+  }
+  return {v.toVariant().toString()};
+}
+
+// Quotes a CSV field if required.
+static QString csvField(QString field) {
+  if (field.contains(',') || field.contains('"') || field.contains('\n')) {
+    field.replace("\"", "\"\"");
+    return "\"" + field + "\"";
+  }
+  return field;
+}
+
+BatchRunner::BatchRunner(const CLIModeOptions &options)
+    : QObject(), m_options(options) {
+  if (m_options.batchJobs == 0)
+    m_options.batchJobs = std::max(1, QThread::idealThreadCount());
+}
+
+int BatchRunner::run() {
+  QString err;
+  if (!parseManifest(err)) {
+    error(err);
+    return 1;
+  }
+  if (!m_workDir.isValid()) {
+    error("Failed to create temporary directory");
+    return 1;
+  }
+
+  const int workers =
+      std::min(m_options.batchJobs, static_cast<int>(m_jobs.size()));
+  info("Running " + QString::number(m_jobs.size()) + " jobs on " +
+       QString::number(workers) + " workers");
+  m_elapsed.start();
+  for (const auto &job : m_jobs)
+    m_pending.push_back(job.index);
+
+  for (int i = 0; i < workers; ++i)
+    startWorker();
+  while (m_running > 0)
+    QCoreApplication::processEvents(QEventLoop::WaitForMoreEvents);
+
+  // Jobs may remain if no worker could be started.
+  while (!m_pending.empty()) {
+    Job &job = m_jobs.at(m_pending.front());
+    m_pending.pop_front();
+    job.timer.start();
+    jobFinished(job, -1);
+  }
+
+  if (report())
+    return 1;
+  return m_failed == 0 ? 0 : 1;
+}
+
+bool BatchRunner::parseManifest(QString &errorMessage) {
+  QFile file(m_options.batchManifest);
+  if (!file.open(QIODevice::ReadOnly)) {
+    errorMessage =
+        "Failed to open manifest '" + m_options.batchManifest + "' (--batch).";
+    return false;
+  }
+  QJsonParseError parseError;
+  const auto doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (doc.isNull()) {
+    errorMessage = "Invalid manifest: " + parseError.errorString();
+    return false;
+  }
+
+  QJsonArray jobs;
+  QJsonObject defaults;
+  if (doc.isArray()) {
+    jobs = doc.array();
+  } else {
+    jobs = doc.object().value("jobs").toArray();
+    defaults = doc.object().value("defaults").toObject();
+  }
+
+  for (int i = 0; i < jobs.size(); ++i) {
+    QJsonObject job = defaults;
+    const auto overrides = jobs.at(i).toObject();
+    for (auto it = overrides.begin(); it != overrides.end(); ++it)
+      job.insert(it.key(), it.value());
+
+    Job out;
+    out.index = i;
+    if (!jobArguments(job, out, errorMessage)) {
+      errorMessage = "Job " + QString::number(i) + ": " + errorMessage;
+      return false;
+    }
+    m_jobs.push_back(out);
+  }
+  return true;
+}
+
+bool BatchRunner::jobArguments(const QJsonObject &job, Job &out,
+                               QString &errorMessage) {
+  if (!job.contains("src") || !job.contains("proc")) {
+    errorMessage = "Jobs must specify 'src' and 'proc'.";
+    return false;
+  }
+  QStringList &args = out.arguments;
+  for (const auto &src : stringList(job.value("src")))
+    args << "--src" << src;
+  args << "--t" << job.value("t").toString("asm");
+  args << "--proc" << job.value("proc").toString();
+  if (job.contains("engine"))
+    args << "--engine" << job.value("engine").toString();
+  if (job.contains("isaexts"))
+    args << "--isaexts" << stringList(job.value("isaexts")).join(",");
+  // Workers read jobs from stdin, so jobs without an input file read from
+  // the null device.
+  args << "--input-file"
+       << (job.contains("input") ? job.value("input").toString()
+                                 : QProcess::nullDevice());
+  if (job.contains("timeout"))
+    args << "--timeout" << job.value("timeout").toVariant().toString();
+  if (job.contains("max-cycles"))
+    args << "--max-cycles" << job.value("max-cycles").toVariant().toString();
+  if (job.contains("max-instructions"))
+    args << "--max-instructions"
+         << job.value("max-instructions").toVariant().toString();
+
+  const auto regInit = job.value("reginit");
+  if (regInit.isObject()) {
+    QStringList inits;
+    const auto regs = regInit.toObject();
+    for (auto it = regs.begin(); it != regs.end(); ++it)
+      inits << it.key() + "=" + it.value().toVariant().toString();
+    args << "--reginit" << inits.join(",");
+  } else if (!regInit.isUndefined()) {
+    args << "--reginit" << stringList(regInit).join(",");
+  }
+
+  for (const auto &key : stringList(job.value("telemetry"))) {
+    if (key.isEmpty())
+      continue;
+    const bool known =
+        key == "all" ||
+        std::any_of(m_options.telemetry.begin(), m_options.telemetry.end(),
+                    [&](const auto &t) { return t->key() == key; });
+    if (!known) {
+      errorMessage = "Unknown telemetry option '" + key + "'.";
+      return false;
+    }
+    args << "--" + key;
+  }
+
+  out.name = job.contains("name") ? job.value("name").toString()
+                                  : stringList(job.value("src")).first();
+  out.result.insert("name", out.name);
+  out.result.insert("src", job.value("src"));
+  out.result.insert("proc", job.value("proc"));
+  return true;
+}
+
+void BatchRunner::startWorker() {
+  m_workers.push_back(std::make_unique<Worker>());
+  Worker &worker = *m_workers.back();
+  worker.process = new QProcess(this);
+  // Console output of jobs is written to their log files by the worker.
+  worker.process->setProcessChannelMode(QProcess::ForwardedErrorChannel);
+  connect(worker.process, &QProcess::started, this,
+          [&worker] { worker.started = true; });
+  connect(worker.process, &QProcess::readyReadStandardOutput, this,
+          [this, &worker] { workerOutput(worker); });
+  connect(worker.process, &QProcess::finished, this,
+          [this, &worker](int exitCode, QProcess::ExitStatus status) {
+            workerFinished(worker,
+                           status == QProcess::NormalExit ? exitCode : -1);
+          });
+  connect(worker.process, &QProcess::errorOccurred, this,
+          [this, &worker](QProcess::ProcessError error) {
+            // Failures other than start failures are followed by finished().
+            if (error == QProcess::FailedToStart)
+              workerFinished(worker, -1);
+          });
+  m_running++;
+  worker.process->start(QCoreApplication::applicationFilePath(),
+                        {"--mode", "cli", "--batch-worker"});
+  // Start failures may already have been handled by workerFinished.
+  if (worker.process->state() != QProcess::NotRunning)
+    assignJob(worker);
+}
+
+void BatchRunner::assignJob(Worker &worker) {
+  if (m_pending.empty()) {
+    worker.process->closeWriteChannel();
+    return;
+  }
+  Job &job = m_jobs.at(m_pending.front());
+  m_pending.pop_front();
+  worker.job = job.index;
+
+  const QString base = m_workDir.filePath("job" + QString::number(job.index));
+  QStringList args = job.arguments;
+  args << "--json"
+       << "--output" << base + ".json";
+  QJsonObject request;
+  request.insert("args", QJsonArray::fromStringList(args));
+  request.insert("log", base + ".log");
+  job.timer.start();
+  worker.process->write(QJsonDocument(request).toJson(QJsonDocument::Compact) +
+                        "\n");
+}
+
+void BatchRunner::workerOutput(Worker &worker) {
+  while (worker.process->canReadLine()) {
+    bool ok;
+    const int exitCode = worker.process->readLine().trimmed().toInt(&ok);
+    if (!ok || worker.job < 0)
+      continue;
+    Job &job = m_jobs.at(worker.job);
+    worker.job = -1;
+    jobFinished(job, exitCode);
+    assignJob(worker);
+  }
+}
+
+void BatchRunner::workerFinished(Worker &worker, int exitCode) {
+  worker.process->deleteLater();
+  m_running--;
+
+  // A worker which exits while running a job has crashed, or failed to start.
+  if (worker.job >= 0) {
+    Job &job = m_jobs.at(worker.job);
+    worker.job = -1;
+    jobFinished(job, exitCode == 0 ? -1 : exitCode);
+  }
+  if (worker.started && !m_pending.empty())
+    startWorker();
+}
+
+void BatchRunner::jobFinished(Job &job, int exitCode) {
+  const QString base = m_workDir.filePath("job" + QString::number(job.index));
+  job.result.insert("exitCode", exitCode);
+  job.result.insert("wallTimeMs", job.timer.elapsed());
+
+  // Jobs stopped by a run limit still write a report of the partial run.
+  const bool limited = exitCode == CLIRunner::kRunLimitExitCode;
+  QFile reportFile(base + ".json");
+  bool ok = (exitCode == 0 || limited) && reportFile.open(QIODevice::ReadOnly);
+  if (ok) {
+    const auto doc = QJsonDocument::fromJson(reportFile.readAll());
+    ok = doc.isObject();
+    job.result.insert("telemetry", doc.object());
+    reportFile.close();
+  }
+  job.result.insert("status", !ok ? "failed" : limited ? "limit" : "ok");
+  if (!ok) {
+    m_failed++;
+    QFile log(base + ".log");
+    if (log.open(QIODevice::ReadOnly)) {
+      log.seek(std::max<qint64>(0, log.size() - kLogTailBytes));
+      job.result.insert("log", QString::fromUtf8(log.readAll()));
+    }
+  }
+  QFile::remove(base + ".json");
+  QFile::remove(base + ".log");
+
+  const auto running =
+      std::count_if(m_workers.begin(), m_workers.end(),
+                    [](const auto &worker) { return worker->job >= 0; });
+  info("[" +
+       QString::number(m_jobs.size() - m_pending.size() -
+                       static_cast<size_t>(running)) +
+       "/" + QString::number(m_jobs.size()) + "] " + job.name + ": " +
+       job.result.value("status").toString());
+}
+
+int BatchRunner::report() {
+  std::unique_ptr<QTextStream> stream;
+  std::unique_ptr<QFile> outputFile;
+  if (m_options.outputFile.isEmpty()) {
+    stream = std::make_unique<QTextStream>(stdout, QIODevice::WriteOnly);
+  } else {
+    outputFile = std::make_unique<QFile>(m_options.outputFile);
+    if (!outputFile->open(QIODevice::Truncate | QIODevice::Text |
+                          QIODevice::WriteOnly)) {
+      error("Failed to open output file");
+      return 1;
+    }
+    stream = std::make_unique<QTextStream>(outputFile.get());
+  }
+
+  if (m_options.jsonOutput) {
+    QJsonArray jobs;
+    for (const auto &job : m_jobs)
+      jobs.append(job.result);
+    QJsonObject summary;
+    summary.insert("jobs", static_cast<int>(m_jobs.size()));
+    summary.insert("failed", m_failed);
+    summary.insert("workers", m_options.batchJobs);
+    summary.insert("wallTimeMs", m_elapsed.elapsed());
+    QJsonObject out;
+    out.insert("summary", summary);
+    out.insert("jobs", jobs);
+    *stream << QJsonDocument(out).toJson(QJsonDocument::Indented);
+  } else {
+    // One row per job, with a column for each reported telemetry key.
+    QStringList keys;
+    for (const auto &job : m_jobs) {
+      for (const auto &key : job.result.value("telemetry").toObject().keys())
+        if (!keys.contains(key))
+          keys << key;
+    }
+    QStringList header = {"name", "src", "proc", "status", "exitCode",
+                          "wallTimeMs"};
+    for (const auto &key : std::as_const(keys))
+      header << csvField(key);
+    *stream << header.join(",") << "\n";
+
+    for (const auto &job : m_jobs) {
+      const auto &r = job.result;
+      QStringList row = {csvField(job.name),
+                         csvField(stringList(r.value("src")).join(" ")),
+                         csvField(r.value("proc").toString()),
+                         r.value("status").toString(),
+                         r.value("exitCode").toVariant().toString(),
+                         r.value("wallTimeMs").toVariant().toString()};
+      const auto telemetry = r.value("telemetry").toObject();
+      for (const auto &key : std::as_const(keys)) {
+        const auto v = telemetry.value(key);
+        QString field;
+        if (v.isObject())
+          field = QJsonDocument(v.toObject()).toJson(QJsonDocument::Compact);
+        else if (v.isArray())
+          field = QJsonDocument(v.toArray()).toJson(QJsonDocument::Compact);
+        else
+          field = v.toVariant().toString();
+        row << csvField(field);
+      }
+      *stream << row.join(",") << "\n";
+    }
+  }
+
+  if (outputFile)
+    outputFile->close();
+  return 0;
+}
+
+void BatchRunner::info(const QString &msg, bool alwaysPrint,
+                       const QString &prefix) {
+  if (m_options.verbose || alwaysPrint)
+    std::cout << (prefix + ": " + msg).toStdString() << std::endl;
+}
+
+void BatchRunner::error(const QString &msg) { info(msg, true, "ERROR"); }
+
+
+// Redirects the console output (stdout and stderr) of the process to the file
+// at @p path.
+static bool redirectConsoleOutput(const QString &path) {
+  std::cout.flush();
+  std::fflush(stdout);
+  std::fflush(stderr);
+  std::FILE *file = std::fopen(QFile::encodeName(path).constData(), "wb");
+  if (!file)
+    return false;
+#ifdef _WIN32
+  const bool ok = _dup2(_fileno(file), _fileno(stdout)) == 0 &&
+                  _dup2(_fileno(file), _fileno(stderr)) == 0;
+#else
+  const bool ok = dup2(fileno(file), fileno(stdout)) >= 0 &&
+                  dup2(fileno(file), fileno(stderr)) >= 0;
+#endif
+  std::fclose(file);
+  return ok;
+}
+
+// Runs the job with the CLI arguments @p arguments in this process.
+static int runWorkerJob(const QStringList &arguments) {
+  QCommandLineParser parser;
+  CLIModeOptions options;
+  addCLIOptions(parser, options);
+  QString err;
+  if (!parser.parse(QStringList{QCoreApplication::applicationFilePath()} +
+                    arguments)) {
+    err = parser.errorText();
+  } else if (parseCLIOptions(parser, err, options) &&
+             (options.batchWorker || !options.batchManifest.isEmpty())) {
+    err = "Jobs cannot run batches.";
+  }
+  if (!err.isEmpty()) {
+    std::cout << "ERROR: " << err.toStdString() << std::endl;
+    return 1;
+  }
+
+  // Each job starts from the state of a fresh process. CLIRunner constructs
+  // a new processor, and the state which outlives it is reset here.
+  SystemIO::reset();
+  HostProfile::get().reset();
+  return CLIRunner(options).run();
+}
+
+int BatchRunner::runWorker() {
+  // Exit statuses are written to a duplicate of stdout, since stdout itself
+  // is redirected to the log file of each job.
+#ifdef _WIN32
+  std::FILE *replies = _fdopen(_dup(_fileno(stdout)), "w");
+#else
+  std::FILE *replies = fdopen(dup(fileno(stdout)), "w");
+#endif
+  if (!replies)
+    return 1;
+
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    const auto request =
+        QJsonDocument::fromJson(QByteArray::fromStdString(line)).object();
+    QStringList arguments;
+    for (const auto &arg : request.value("args").toArray())
+      arguments << arg.toString();
+
+    int status = 1;
+    if (redirectConsoleOutput(request.value("log").toString()))
+      status = runWorkerJob(arguments);
+    // Release the log file, such that it may be removed.
+    redirectConsoleOutput(QProcess::nullDevice());
+
+    std::fprintf(replies, "%d\n", status);
+    std::fflush(replies);
+  }
+  std::fclose(replies);
+  return 0;
+}
+
+} // namespace Ripes
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "clioptions.h"
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QObject>
+#include <QTemporaryDir>
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+class QProcess;
+
+namespace Ripes {
+
+/// The BatchRunner class runs the jobs of a batch manifest (--batch).
+/// Simulations share global state (ie. ProcessorHandler), so jobs cannot be
+/// run concurrently within a single process. Instead, jobs are distributed
+/// over a pool of CLIModeOptions::batchJobs worker processes, each of which
+/// runs Ripes in CLI mode and runs one job after the other (see runWorker).
+/// A worker which crashes fails its current job and is replaced. The JSON
+/// reports of the jobs are aggregated into a single JSON or CSV report.
+class BatchRunner : public QObject {
+  Q_OBJECT
+public:
+  BatchRunner(const CLIModeOptions &options);
+
+  /// Runs all jobs of the manifest. Returns 0 if no job failed; jobs stopped
+  /// by a run limit do not count as failed.
+  int run();
+
+  /// Runs a worker process (--batch-worker). Jobs are read from stdin, one
+  /// per line, as a JSON object of the CLI arguments of the job ('args') and
+  /// the file to which the console output of the job is written ('log').
+  /// Once a job has finished, its exit status is written to stdout as a
+  /// line. Returns once stdin is closed.
+  static int runWorker();
+
+private:
+  struct Job {
+    int index;
+    QString name;
+    QStringList arguments;
+    QJsonObject result;
+    QElapsedTimer timer;
+  };
+
+  struct Worker {
+    QProcess *process = nullptr;
+    // Whether the process has started; workers which fail to start are not
+    // replaced.
+    bool started = false;
+    // Index of the job run by the worker, or -1 if idle.
+    int job = -1;
+  };
+
+  /// Parses the manifest into m_jobs.
+  bool parseManifest(QString &errorMessage);
+  /// Converts a manifest job into the CLI arguments of a worker.
+  bool jobArguments(const QJsonObject &job, Job &out, QString &errorMessage);
+  /// Starts a worker process and assigns it a job.
+  void startWorker();
+  /// Sends the next pending job to @p worker, or closes its stdin if no jobs
+  /// remain, after which it exits.
+  void assignJob(Worker &worker);
+  void workerOutput(Worker &worker);
+  void workerFinished(Worker &worker, int exitCode);
+  void jobFinished(Job &job, int exitCode);
+
+  /// Prints the aggregated report to the console/output file.
+  int report();
+  void info(const QString &msg, bool alwaysPrint = false,
+            const QString &prefix = "INFO");
+  void error(const QString &msg);
+
+  CLIModeOptions m_options;
+  std::vector<Job> m_jobs;
+  std::deque<int> m_pending;
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  // Number of worker processes which have not yet exited.
+  int m_running = 0;
+  int m_failed = 0;
+  QTemporaryDir m_workDir;
+  QElapsedTimer m_elapsed;
+};
+
+} // namespace Ripes
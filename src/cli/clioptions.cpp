@@ -3,14 +3,22 @@
 #include "radix.h"
 #include "telemetry.h"
 #include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 #include <QMetaEnum>
 
 namespace Ripes {
 
 void addCLIOptions(QCommandLineParser &parser, Ripes::CLIModeOptions &options) {
-  parser.addOption(QCommandLineOption("src", "Path to source file.", "path"));
   parser.addOption(QCommandLineOption(
-      "t", "Source file type. Options: [c, asm, bin]", "type", "asm"));
+      "src",
+      "Path to source file. Assembly source files may be specified multiple "
+      "times, in which case each file is assembled separately and linked in "
+      "the order given.",
+      "path"));
+  parser.addOption(QCommandLineOption(
+      "t", "Source file type. Options: [c, asm, bin, elf]", "type", "asm"));
 
   // Processor models. Generate information from processor registry.
   QStringList processorOptions;
@@ -20,6 +28,15 @@ void addCLIOptions(QCommandLineParser &parser, Ripes::CLIModeOptions &options) {
   QString desc =
       "Processor model. Options: [" + processorOptions.join(", ") + "]";
   parser.addOption(QCommandLineOption("proc", desc, "name"));
+  parser.addOption(QCommandLineOption(
+      "engine",
+      "Simulation engine. Options: [vsrtl, compiled, translated]. The "
+      "compiled engine is available for the single-cycle processors and the "
+      "5-stage processors with forwarding and hazard detection. The "
+      "translated engine is the compiled single-cycle engine, translating hot "
+      "code to host machine code on x86-64 hosts; it does not support the "
+      "pipeline report.",
+      "engine", "vsrtl"));
   parser.addOption(QCommandLineOption("isaexts",
                                       "ISA extensions to enable (comma "
                                       "separated)",
@@ -30,16 +47,76 @@ void addCLIOptions(QCommandLineParser &parser, Ripes::CLIModeOptions &options) {
       "value may be specified in signed, hex, or boolean notation. Format:\n"
       "<register idx>=<value>,<register idx>=<value>",
       "[rid:v]"));
+  parser.addOption(QCommandLineOption(
+      "lanes",
+      "Run the program once for each lane of a JSON lane file, executing the "
+      "lanes in lockstep. The file is a list of lanes, each an object with "
+      "the optional keys [reginit, input], which correspond to --reginit "
+      "(applied on top of --reginit) and --input-file. A report of the exit "
+      "status, instructions retired and console output, and with --regs the "
+      "register values, of each lane is printed instead of the report "
+      "options. Only available for the single-cycle processors; memory "
+      "mapped I/O and syscalls other than exit, print, read and write are "
+      "unavailable to lanes.",
+      "path"));
   parser.addOption(QCommandLineOption(
       "timeout",
       "Simulation timeout in milliseconds. If simulation does not finish "
       "within the specified time, it will be aborted.",
       "ms", "0"));
+  parser.addOption(QCommandLineOption(
+      "max-cycles",
+      "Maximum number of cycles to simulate. If reached, simulation is "
+      "stopped, the report is printed for the partial run and Ripes exits "
+      "with status 2.",
+      "n", "0"));
+  parser.addOption(QCommandLineOption(
+      "max-instructions",
+      "Maximum number of instructions to retire. If reached, simulation is "
+      "stopped, the report is printed for the partial run and Ripes exits "
+      "with status 2.",
+      "n", "0"));
+  parser.addOption(QCommandLineOption(
+      "input-file",
+      "File from which console input (reads from stdin) of the program is "
+      "read. If not set, console input is read from stdin.",
+      "path"));
+  parser.addOption(QCommandLineOption(
+      "telemetry-interval",
+      "Report the enabled report options while running, every N cycles or, "
+      "if suffixed with 'ms', every N milliseconds. Each report is written as "
+      "a single line of JSON.",
+      "N[ms]"));
+  parser.addOption(QCommandLineOption(
+      "telemetry-output",
+      "Output file of --telemetry-interval reports. If not set, reports are "
+      "printed to stderr.",
+      "path"));
   parser.addOption(QCommandLineOption("v", "Verbose output"));
   parser.addOption(QCommandLineOption(
       "output", "Report output file. If not set, report is printed to stdout.",
       "path"));
   parser.addOption(QCommandLineOption("json", "JSON-formatted report."));
+  parser.addOption(QCommandLineOption(
+      "batch",
+      "Run all jobs of a JSON job manifest, and report the telemetry of all "
+      "jobs as a single JSON (--json) or CSV report. Each job is an object "
+      "with the keys [name, src, t, proc, engine, isaexts, reginit, timeout, "
+      "max-cycles, max-instructions, input, telemetry], which correspond to "
+      "the options of the same name (input to --input-file); telemetry is a "
+      "list of report options. The "
+      "manifest is either a list of jobs, or an object with a 'jobs' list and "
+      "a 'defaults' job whose keys apply to all jobs.",
+      "manifest"));
+  parser.addOption(QCommandLineOption(
+      "jobs",
+      "Number of jobs to run concurrently in batch mode (--batch). Defaults "
+      "to the number of host threads.",
+      "n", "0"));
+  QCommandLineOption batchWorkerOption(
+      "batch-worker", "Run as a worker process of batch mode (internal).");
+  batchWorkerOption.setFlags(QCommandLineOption::HiddenFromHelp);
+  parser.addOption(batchWorkerOption);
 
   parser.addOption(QCommandLineOption("all", "Enable all report options."));
 
@@ -51,6 +128,7 @@ void addCLIOptions(QCommandLineParser &parser, Ripes::CLIModeOptions &options) {
   options.telemetry.push_back(std::make_shared<PipelineTelemetry>());
   options.telemetry.push_back(std::make_shared<RegisterTelemetry>());
   options.telemetry.push_back(std::make_shared<RunInfoTelemetry>(&parser));
+  options.telemetry.push_back(std::make_shared<HostTelemetry>());
 
   for (auto &telemetry : options.telemetry) {
     QString desc = "Report " + telemetry->description();
@@ -59,15 +137,130 @@ void addCLIOptions(QCommandLineParser &parser, Ripes::CLIModeOptions &options) {
   }
 }
 
+// Parses the register initializations @p value, in the format of --reginit,
+// into @p regInit. @p option names the source of the value in error messages.
+static bool parseRegInit(const QString &value, const QString &option,
+                         RegisterInitialization &regInit,
+                         QString &errorMessage) {
+  const QString suffix = " specified (" + option + ").";
+  QStringList regInitList = value.split(",");
+  for (auto &regInitStr : regInitList) {
+    QStringList regInitParts = regInitStr.split("=");
+    if (regInitParts.size() != 2) {
+      errorMessage = "Invalid register initialization '" + regInitStr + "'" +
+                     suffix;
+      return false;
+    }
+    bool ok;
+    int regIdx = regInitParts[0].toInt(&ok);
+    if (!ok) {
+      errorMessage = "Invalid register index '" + regInitParts[0] + "'" +
+                     suffix;
+      return false;
+    }
+
+    auto &vstr = regInitParts[1];
+    VInt regVal;
+    if (vstr.startsWith("0x"))
+      regVal = decodeRadixValue(vstr, Radix::Hex, &ok);
+    else if (vstr.startsWith("0b"))
+      regVal = decodeRadixValue(vstr, Radix::Binary, &ok);
+    else
+      regVal = decodeRadixValue(vstr, Radix::Signed, &ok);
+
+    if (!ok) {
+      errorMessage = "Invalid register value '" + vstr + "'" + suffix;
+      return false;
+    }
+
+    if (regInit.count(regIdx) > 0) {
+      errorMessage = "Duplicate register initialization for register " +
+                     QString::number(regIdx) + suffix;
+      return false;
+    }
+
+    regInit[regIdx] = regVal;
+  }
+  return true;
+}
+
+// Parses the lane file @p path (--lanes) into options.lanes. The register
+// initializations of each lane apply on top of options.regInit.
+static bool parseLanes(const QString &path, CLIModeOptions &options,
+                       QString &errorMessage) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly)) {
+    errorMessage = "Failed to open lane file '" + path + "' (--lanes).";
+    return false;
+  }
+  QJsonParseError parseError;
+  const auto doc = QJsonDocument::fromJson(file.readAll(), &parseError);
+  if (!doc.isArray() || doc.array().isEmpty()) {
+    errorMessage = "Invalid lane file '" + path + "' (--lanes): " +
+                   (doc.isNull() ? parseError.errorString()
+                                 : "expected a non-empty list of lanes");
+    return false;
+  }
+
+  const auto lanes = doc.array();
+  for (int i = 0; i < lanes.size(); ++i) {
+    const auto lane = lanes.at(i).toObject();
+    const QString option = "--lanes, lane " + QString::number(i);
+    CLIModeOptions::Lane out;
+    // As in batch manifests, register initializations are either a
+    // --reginit string or an object of register indices and values.
+    QString regInitStr = lane.value("reginit").toString();
+    if (lane.value("reginit").isObject()) {
+      QStringList inits;
+      const auto regs = lane.value("reginit").toObject();
+      for (auto it = regs.begin(); it != regs.end(); ++it)
+        inits << it.key() + "=" + it.value().toVariant().toString();
+      regInitStr = inits.join(",");
+    }
+    RegisterInitialization laneRegInit;
+    if (!regInitStr.isEmpty() &&
+        !parseRegInit(regInitStr, option, laneRegInit, errorMessage))
+      return false;
+    out.regInit = options.regInit;
+    for (const auto &kv : laneRegInit)
+      out.regInit[kv.first] = kv.second;
+    out.inputFile = lane.value("input").toString();
+    options.lanes.push_back(out);
+  }
+  return true;
+}
+
 bool parseCLIOptions(QCommandLineParser &parser, QString &errorMessage,
                      CLIModeOptions &options) {
   options.verbose = parser.isSet("v");
+  options.jsonOutput = parser.isSet("json");
+  options.outputFile = parser.value("output");
+
+  if (parser.isSet("batch-worker")) {
+    // The options of each job are parsed by the worker.
+    options.batchWorker = true;
+    return true;
+  }
+
+  if (parser.isSet("batch")) {
+    // Jobs are validated as they are run; see BatchRunner.
+    options.batchManifest = parser.value("batch");
+    bool ok;
+    options.batchJobs = parser.value("jobs").toInt(&ok);
+    if (!ok || options.batchJobs < 0) {
+      errorMessage = "Invalid number of jobs specified (--jobs).";
+      return false;
+    }
+    return true;
+  }
 
   if (!parser.isSet("src")) {
     errorMessage = "No source file specified (--src)";
     return false;
   }
-  options.src = parser.value("src");
+  const QStringList srcs = parser.values("src");
+  options.src = srcs.first();
+  options.linkedSrc = srcs.mid(1);
 
   if (!parser.isSet("t")) {
     errorMessage = "No source type specified (--t)";
@@ -87,6 +280,12 @@ bool parseCLIOptions(QCommandLineParser &parser, QString &errorMessage,
     return false;
   }
 
+  if (!options.linkedSrc.empty() && options.srcType != SourceType::Assembly) {
+    errorMessage = "Multiple source files (--src) are only supported for "
+                   "assembly sources";
+    return false;
+  }
+
   if (!parser.isSet("proc")) {
     errorMessage = "No processor specified (-proc).";
     return false;
@@ -101,7 +300,22 @@ bool parseCLIOptions(QCommandLineParser &parser, QString &errorMessage,
   }
   options.proc = static_cast<ProcessorID>(procID);
 
-  options.jsonOutput = parser.isSet("json");
+  const QString engine = parser.value("engine");
+  if (engine == "compiled" || engine == "translated") {
+    options.engine = engine == "compiled" ? ProcessorEngine::Compiled
+                                          : ProcessorEngine::Translated;
+    const auto &desc = ProcessorRegistry::getDescription(options.proc);
+    if (!(options.engine == ProcessorEngine::Translated
+              ? desc.hasTranslatedEngine()
+              : desc.hasCompiledEngine())) {
+      errorMessage = "Processor '" + enumToString<ProcessorID>(options.proc) +
+                     "' has no " + engine + " engine (--engine).";
+      return false;
+    }
+  } else if (engine != "vsrtl") {
+    errorMessage = "Invalid engine '" + engine + "' specified (--engine).";
+    return false;
+  }
 
   if (parser.isSet("isaexts")) {
     options.isaExtensions = parser.value("isaexts").split(",");
@@ -132,55 +346,74 @@ bool parseCLIOptions(QCommandLineParser &parser, QString &errorMessage,
     }
   }
 
-  options.outputFile = parser.value("output");
-
-  // Validate register initializations
-  if (parser.isSet("reginit")) {
-    QStringList regInitList = parser.value("reginit").split(",");
-    for (auto &regInit : regInitList) {
-      QStringList regInitParts = regInit.split("=");
-      if (regInitParts.size() != 2) {
-        errorMessage = "Invalid register initialization '" + regInit +
-                       "' specified (--reginit).";
-        return false;
-      }
-      bool ok;
-      int regIdx = regInitParts[0].toInt(&ok);
-      if (!ok) {
-        errorMessage = "Invalid register index '" + regInitParts[0] +
-                       "' specified (--reginit).";
-        return false;
-      }
+  bool limitsOk;
+  options.maxCycles = parser.value("max-cycles").toLongLong(&limitsOk);
+  if (!limitsOk || options.maxCycles < 0) {
+    errorMessage = "Invalid cycle limit specified (--max-cycles).";
+    return false;
+  }
+  options.maxInstructions =
+      parser.value("max-instructions").toLongLong(&limitsOk);
+  if (!limitsOk || options.maxInstructions < 0) {
+    errorMessage = "Invalid instruction limit specified (--max-instructions).";
+    return false;
+  }
 
-      auto &vstr = regInitParts[1];
-      VInt regVal;
-      if (vstr.startsWith("0x"))
-        regVal = decodeRadixValue(vstr, Radix::Hex, &ok);
-      else if (vstr.startsWith("0b"))
-        regVal = decodeRadixValue(vstr, Radix::Binary, &ok);
-      else
-        regVal = decodeRadixValue(vstr, Radix::Signed, &ok);
+  options.inputFile = parser.value("input-file");
 
-      if (!ok) {
-        errorMessage =
-            "Invalid register value '" + vstr + "' specified (--reginit).";
-        return false;
-      }
+  if (parser.isSet("telemetry-interval")) {
+    QString interval = parser.value("telemetry-interval");
+    const bool ms = interval.endsWith("ms");
+    if (ms)
+      interval.chop(2);
+    bool ok;
+    const long long value = interval.toLongLong(&ok);
+    if (!ok || value <= 0) {
+      errorMessage =
+          "Invalid telemetry interval specified (--telemetry-interval).";
+      return false;
+    }
+    if (ms)
+      options.telemetryIntervalMs = static_cast<int>(value);
+    else
+      options.telemetryIntervalCycles = value;
+  }
+  options.telemetryOutput = parser.value("telemetry-output");
 
-      if (options.regInit.count(regIdx) > 0) {
-        errorMessage = "Duplicate register initialization for register " +
-                       QString::number(regIdx) + " specified (--reginit).";
-        return false;
-      }
+  // Validate register initializations
+  if (parser.isSet("reginit") &&
+      !parseRegInit(parser.value("reginit"), "--reginit", options.regInit,
+                    errorMessage))
+    return false;
 
-      options.regInit[regIdx] = regVal;
+  if (parser.isSet("lanes")) {
+    if (options.proc != ProcessorID::RV32_SS &&
+        options.proc != ProcessorID::RV64_SS) {
+      errorMessage = "Lanes (--lanes) are only supported for the single-cycle "
+                     "processors.";
+      return false;
     }
+    if (!parseLanes(parser.value("lanes"), options, errorMessage))
+      return false;
   }
 
-  // Enable selected telemetry options.
-  for (auto &telemetry : options.telemetry)
-    if (parser.isSet("all") || parser.isSet(telemetry->key()))
+  // Enable selected telemetry options. --all omits per-cycle telemetry which
+  // the engine cannot provide.
+  const bool perCycleEngine = options.engine != ProcessorEngine::Translated;
+  for (auto &telemetry : options.telemetry) {
+    if (parser.isSet(telemetry->key())) {
+      if (telemetry->perCycle() && !perCycleEngine) {
+        errorMessage = "Report option '--" + telemetry->key() +
+                       "' is unavailable with the translated engine, which "
+                       "does not simulate individual cycles (--engine).";
+        return false;
+      }
+      telemetry->enable();
+    } else if (parser.isSet("all") &&
+               (perCycleEngine || !telemetry->perCycle())) {
       telemetry->enable();
+    }
+  }
 
   return true;
 }
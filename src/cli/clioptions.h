@@ -10,15 +10,55 @@ namespace Ripes {
 
 struct CLIModeOptions {
   QString src;
+  // Additional assembly source files, which are assembled separately and
+  // linked together with src.
+  QStringList linkedSrc;
   SourceType srcType;
   ProcessorID proc;
+  ProcessorEngine engine = ProcessorEngine::VSRTL;
   QStringList isaExtensions;
   bool verbose = false;
   QString outputFile = "";
   bool jsonOutput = false;
   int timeout = 0;
+  // Simulation stops once the processor reaches the given number of cycles
+  // or instructions retired. Disabled if zero.
+  long long maxCycles = 0;
+  long long maxInstructions = 0;
+  // File from which console input is read. If empty, console input is read
+  // from stdin.
+  QString inputFile;
   RegisterInitialization regInit;
 
+  // A lane of a lockstep run (--lanes): one run of the program with its own
+  // register initializations and console input.
+  struct Lane {
+    RegisterInitialization regInit;
+    // File from which console input of the lane is read. If empty, the lane
+    // has no console input.
+    QString inputFile;
+  };
+  // If nonempty, the program is run for each lane instead of once; see
+  // CLIRunner::runLanes.
+  std::vector<Lane> lanes;
+
+  // Interval at which telemetry is streamed while running, in either cycles
+  // or milliseconds. Streaming is disabled if both are zero.
+  long long telemetryIntervalCycles = 0;
+  int telemetryIntervalMs = 0;
+  // File to which streamed telemetry is written. If empty, streamed
+  // telemetry is written to stderr.
+  QString telemetryOutput;
+
+  // Job manifest of batch mode. If set, the jobs of the manifest are run
+  // instead of a single source file; see BatchRunner.
+  QString batchManifest;
+  // Number of jobs run concurrently in batch mode.
+  int batchJobs = 0;
+  // Whether this process is a worker of batch mode, which runs the jobs it
+  // reads from stdin; see BatchRunner::runWorker.
+  bool batchWorker = false;
+
   // A list of enabled telemetry options.
   std::vector<std::shared_ptr<Telemetry>> telemetry;
 };
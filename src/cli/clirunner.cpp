@@ -1,11 +1,29 @@
 #include "clirunner.h"
+#include "ccmanager.h"
+#include "hostprofile.h"
 #include "io/iomanager.h"
+#include "loaddialog.h"
 #include "processorhandler.h"
+#include "processors/RISC-V/rv_batchexecutor.h"
+#include "programcache.h"
 #include "programutilities.h"
 #include "syscall/systemio.h"
+#include "telemetrystreamer.h"
 
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QTemporaryDir>
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace Ripes {
 
@@ -35,46 +53,95 @@ static QString qVariantToString(QVariant &v) {
 CLIRunner::CLIRunner(const CLIModeOptions &options)
     : QObject(), m_options(options) {
   info("Ripes CLI mode", false, true);
-  ProcessorHandler::selectProcessor(m_options.proc, m_options.isaExtensions,
-                                    m_options.regInit);
+  {
+    HostProfile::Scope scope("construction");
+    ProcessorHandler::selectProcessor(m_options.proc, m_options.isaExtensions,
+                                      m_options.regInit, m_options.engine);
+  }
 
-  // Connect systemIO output to stdout.
-  connect(&SystemIO::get(), &SystemIO::doPrint, this, [&](auto text) {
-    std::cout << text.toStdString();
-    std::flush(std::cout);
-  });
+  // Connect systemIO output to stdout. Output arrives in coalesced chunks, so
+  // each chunk is flushed as is.
+  connect(
+      &SystemIO::get(), &SystemIO::doPrint, this,
+      [&](const QString &text) {
+        const QByteArray bytes = text.toUtf8();
+        std::cout.write(bytes.constData(), bytes.size());
+        std::cout.flush();
+      },
+      Qt::QueuedConnection);
+}
 
-  // TODO: how to handle system input?
+CLIRunner::~CLIRunner() {
+  SystemIO::setStdinSource(nullptr, false);
+  if (m_inputFile)
+    std::fclose(m_inputFile);
 }
 
 int CLIRunner::run() {
+  if (!m_options.lanes.empty()) {
+    if (processInput())
+      return 1;
+    return runLanes();
+  }
+
+  if (setupInput())
+    return 1;
+
   if (processInput())
     return 1;
 
-  if (runModel())
+  const int runStatus = runModel();
+  if (runStatus != 0 && runStatus != kRunLimitExitCode)
     return 1;
 
+  // Telemetry is reported for partial runs as well.
   if (postRun())
     return 1;
 
+  return runStatus;
+}
+
+int CLIRunner::setupInput() {
+  if (m_options.inputFile.isEmpty()) {
+#ifdef _WIN32
+    const bool interactive = _isatty(_fileno(stdin));
+#else
+    const bool interactive = isatty(fileno(stdin));
+#endif
+    SystemIO::setStdinSource(stdin, interactive);
+    return 0;
+  }
+
+  m_inputFile =
+      std::fopen(QFile::encodeName(m_options.inputFile).constData(), "rb");
+  if (!m_inputFile) {
+    error("Failed to open input file '" + m_options.inputFile + "'");
+    return 1;
+  }
+  SystemIO::setStdinSource(m_inputFile, false);
   return 0;
 }
 
 int CLIRunner::processInput() {
   info("Processing input file", false, true);
+  HostProfile::Scope scope("load");
 
   switch (m_options.srcType) {
   case SourceType::Assembly: {
-    info("Assembling input file '" + m_options.src + "'");
-    QFile inputFile(m_options.src);
-    if (!inputFile.open(QIODevice::ReadOnly)) {
-      error("Failed to open input file");
-      return 1;
+    std::vector<Assembler::AssemblyUnit> units;
+    for (const auto &src : QStringList{m_options.src} + m_options.linkedSrc) {
+      info("Assembling input file '" + src + "'");
+      QFile inputFile(src);
+      if (!inputFile.open(QIODevice::ReadOnly)) {
+        error("Failed to open input file '" + src + "'");
+        return 1;
+      }
+      units.push_back({QFileInfo(src).fileName(), inputFile.readAll()});
     }
-    auto res = ProcessorHandler::getAssembler()->assembleRaw(
-        inputFile.readAll(), &IOManager::get().assemblerSymbols());
+    auto res = ProgramCache::get().assembleUnits(
+        units, &IOManager::get().assemblerSymbols());
     if (res.errors.size() == 0)
-      ProcessorHandler::loadProgram(std::make_shared<Program>(res.program));
+      loadProgram(res.program);
     else {
       error("Error during assembly:");
       for (auto &err : res.errors)
@@ -91,17 +158,89 @@ int CLIRunner::processInput() {
       error(err);
       return 1;
     }
-    ProcessorHandler::loadProgram(std::make_shared<Program>(p));
+    loadProgram(p);
     break;
   }
-  default:
-    assert(false &&
-           "Command-line support for this source type is not yet implemented");
+  case SourceType::ExternalELF: {
+    info("Loading ELF file '" + m_options.src + "'");
+    if (loadElf(m_options.src))
+      return 1;
+    break;
+  }
+  case SourceType::C: {
+    info("Compiling input file '" + m_options.src + "'");
+    if (!CCManager::hasValidCC()) {
+      error("No valid C compiler has been set or could be autodetected. Set a "
+            "compiler in the Ripes settings, or add a RISC-V GCC compiler to "
+            "PATH.");
+      return 1;
+    }
+    // The compiler runs in its own directory, so sources are passed by
+    // absolute path. As in the editor, the peripheral symbols header is
+    // included.
+    QStringList files = {QFileInfo(m_options.src).absoluteFilePath()};
+    const QString peripheralSymbolsHeader =
+        IOManager::get().cSymbolsHeaderpath();
+    if (!peripheralSymbolsHeader.isEmpty())
+      files << peripheralSymbolsHeader;
+
+    // Compile into a directory private to this process, such that concurrent
+    // CLI runs do not share an output file. Executables are cached by
+    // ProgramCache, keyed by the contents of the sources.
+    QTemporaryDir outDir;
+    if (!outDir.isValid()) {
+      error("Failed to create temporary directory");
+      return 1;
+    }
+    const auto res = CCManager::get().compile(
+        files, outDir.filePath(QFileInfo(m_options.src).baseName() + ".elf"),
+        /*showProgressdiag=*/false);
+    if (!res.success) {
+      error(res.errorOutput.toString(res.cc));
+      const QString ccErr = CCManager::getError();
+      if (!ccErr.isEmpty())
+        info(ccErr, true);
+      return 1;
+    }
+    if (loadElf(res.outFile))
+      return 1;
+    break;
+  }
+  case SourceType::InternalELF:
+    assert(false && "Internal ELF files are not a command-line source type");
+    return 1;
   }
 
   return 0;
 }
 
+int CLIRunner::loadElf(const QString &path) {
+  auto elfInfo = LoadDialog::validateELFFile(QFile(path));
+  if (!elfInfo.valid) {
+    // Validation errors are formatted for display in the load dialog.
+    error("Invalid ELF file '" + path +
+          "': " + elfInfo.errorMessage.replace("<br/>", " "));
+    return 1;
+  }
+
+  Program p;
+  QString debugInfoError;
+  QString err = loadElfFile(p, path, &debugInfoError);
+  if (!err.isEmpty()) {
+    error(err);
+    return 1;
+  }
+  if (!debugInfoError.isEmpty())
+    info(debugInfoError);
+  loadProgram(p);
+  return 0;
+}
+
+void CLIRunner::loadProgram(const Program &program) {
+  HostProfile::Scope scope("loadProgram");
+  ProcessorHandler::loadProgram(std::make_shared<Program>(program));
+}
+
 int CLIRunner::runModel() {
   info("Running model", false, true);
 
@@ -136,7 +275,21 @@ int CLIRunner::runModel() {
   if (m_options.verbose)
     infoTimer.start(1000);
 
+  // Stream telemetry while running, if requested.
+  TelemetryStreamer streamer(m_options);
+  if (m_options.telemetryIntervalCycles != 0 ||
+      m_options.telemetryIntervalMs != 0) {
+    QString err;
+    if (!streamer.start(err)) {
+      error(err);
+      return 1;
+    }
+  }
+
   // Start simulation
+  ProcessorHandler::setRunLimits(m_options.maxCycles,
+                                 m_options.maxInstructions);
+  HostProfile::get().enter("run");
   ProcessorHandler::run();
   if (m_options.timeout != 0)
     timeoutTimer.start(m_options.timeout);
@@ -147,50 +300,226 @@ int CLIRunner::runModel() {
 
   timeoutTimer.stop();
   infoTimer.stop();
-  if (hadTimeout) {
+  if (hadTimeout)
     ProcessorHandler::stopRun();
+  // Print any program output which was flushed after the event loop quit.
+  QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+  HostProfile::get().leave();
+  streamer.stop();
+  if (hadTimeout) {
     error("Simulation did not finish within the specified timeout (" +
           QString::number(m_options.timeout) + " ms)");
     return 1;
   }
 
+  // A run limit is reported through the exit status only, to not interfere
+  // with the report printed to stdout.
+  if (ProcessorHandler::runLimitReached()) {
+    auto *proc = ProcessorHandler::getProcessor();
+    info("Simulation stopped by run limit after " +
+         QString::number(proc->getCycleCount()) + " cycles and " +
+         QString::number(proc->getInstructionsRetired()) +
+         " instructions retired");
+    return kRunLimitExitCode;
+  }
+
   return 0;
 }
 
+std::unique_ptr<QTextStream>
+CLIRunner::openOutput(std::unique_ptr<QFile> &outputFile) {
+  if (m_options.outputFile.isEmpty())
+    return std::make_unique<QTextStream>(stdout, QIODevice::WriteOnly);
+
+  outputFile = std::make_unique<QFile>(m_options.outputFile);
+  if (!outputFile->open(QIODevice::Truncate | QIODevice::Text |
+                        QIODevice::WriteOnly)) {
+    error("Failed to open output file");
+    return nullptr;
+  }
+  return std::make_unique<QTextStream>(outputFile.get());
+}
+
+int CLIRunner::runLanes() {
+  info("Running " + QString::number(m_options.lanes.size()) + " lanes", false,
+       true);
+
+  std::unique_ptr<QFile> outputFile;
+  auto stream = openOutput(outputFile);
+  if (!stream)
+    return 1;
+
+  if (ProcessorHandler::currentISA()->bits() == 64)
+    return runLanes<uint64_t>(*stream);
+  return runLanes<uint32_t>(*stream);
+}
+
+template <typename XLEN_T>
+int CLIRunner::runLanes(QTextStream &stream) {
+  using Batch = RVBatchExecutor<XLEN_T>;
+  using LaneStatus = typename Batch::LaneStatus;
+  const auto program = ProcessorHandler::getProgram();
+  const unsigned lanes = static_cast<unsigned>(m_options.lanes.size());
+
+  RVBatchMemory memory;
+  for (const auto &section : program->sections)
+    memory.write(section.second.address, section.second.data.constData(),
+                 section.second.data.size());
+  Batch batch(ProcessorHandler::currentISA(), lanes, memory,
+              static_cast<XLEN_T>(program->entryPoint));
+  for (unsigned lane = 0; lane < lanes; ++lane) {
+    const auto &options = m_options.lanes[lane];
+    for (const auto &kv : options.regInit) {
+      if (kv.first >= ProcessorHandler::currentISA()->regCnt()) {
+        error("Invalid register index " + QString::number(kv.first) +
+              " of lane " + QString::number(lane));
+        return 1;
+      }
+      batch.setRegister(lane, kv.first, static_cast<XLEN_T>(kv.second));
+    }
+    if (options.inputFile.isEmpty())
+      continue;
+    QFile inputFile(options.inputFile);
+    if (!inputFile.open(QIODevice::ReadOnly)) {
+      error("Failed to open input file '" + options.inputFile + "' of lane " +
+            QString::number(lane));
+      return 1;
+    }
+    batch.setInput(lane, inputFile.readAll().toStdString());
+  }
+
+  // Lanes are single-cycle, so cycles equal instructions retired.
+  long long maxInstructions = m_options.maxInstructions;
+  if (m_options.maxCycles != 0 &&
+      (maxInstructions == 0 || m_options.maxCycles < maxInstructions))
+    maxInstructions = m_options.maxCycles;
+
+  HostProfile::get().enter("run");
+  batch.run(
+      [](XLEN_T pc) { return ProcessorHandler::isExecutableAddress(pc); }, {},
+      maxInstructions);
+  HostProfile::get().leave();
+
+  const bool reportRegisters = std::any_of(
+      m_options.telemetry.begin(), m_options.telemetry.end(),
+      [](const auto &telemetry) {
+        return telemetry->isEnabled() &&
+               dynamic_cast<RegisterTelemetry *>(telemetry.get());
+      });
+  const auto *isa = ProcessorHandler::currentISA();
+  const auto statusName = [](LaneStatus status) -> QString {
+    switch (status) {
+    case LaneStatus::Running:
+      return "running";
+    case LaneStatus::Exited:
+      return "exited";
+    case LaneStatus::LeftText:
+      return "finished";
+    case LaneStatus::Error:
+      return "error";
+    case LaneStatus::Limit:
+      return "limit";
+    }
+    return "";
+  };
+
+  int status = 0;
+  QJsonArray jsonLanes;
+  for (unsigned lane = 0; lane < lanes; ++lane) {
+    const LaneStatus laneStatus = batch.status(lane);
+    if (laneStatus == LaneStatus::Error)
+      status = 1;
+    else if (laneStatus == LaneStatus::Limit && status == 0)
+      status = kRunLimitExitCode;
+
+    const QString output = QString::fromStdString(batch.output(lane));
+    if (m_options.jsonOutput) {
+      QJsonObject jsonLane;
+      jsonLane.insert("lane", static_cast<int>(lane));
+      jsonLane.insert("status", statusName(laneStatus));
+      jsonLane.insert("exitCode", batch.exitCode(lane));
+      jsonLane.insert("instructionsRetired",
+                      static_cast<qint64>(batch.instructionsRetired(lane)));
+      jsonLane.insert("output", output);
+      if (reportRegisters) {
+        QJsonObject registers;
+        for (unsigned i = 0; i < isa->regCnt(); i++)
+          registers.insert(isa->regName(i),
+                           QJsonValue::fromVariant(QVariant::fromValue(
+                               static_cast<VInt>(batch.getRegister(lane, i)))));
+        jsonLane.insert("registers", registers);
+      }
+      jsonLanes.append(jsonLane);
+    } else {
+      stream << "===== Lane " << lane << "\n";
+      stream << "status:\t" << statusName(laneStatus) << "\n";
+      stream << "exit code:\t" << batch.exitCode(lane) << "\n";
+      stream << "instructions retired:\t" << batch.instructionsRetired(lane)
+             << "\n";
+      stream << "output:\t" << output << "\n";
+      if (reportRegisters) {
+        for (unsigned i = 0; i < isa->regCnt(); i++) {
+          const VInt v = batch.getRegister(lane, i);
+          stream << isa->regName(i) << ":\t"
+                 << encodeRadixValue(v, Radix::Signed, isa->bytes()) << "\t";
+          stream << "(" << encodeRadixValue(v, Radix::Hex, isa->bytes())
+                 << ")\n";
+        }
+      }
+      stream << "\n";
+    }
+  }
+  if (m_options.jsonOutput) {
+    QJsonObject jsonOutput;
+    jsonOutput.insert("lanes", jsonLanes);
+    stream << QJsonDocument(jsonOutput).toJson(QJsonDocument::Indented);
+  }
+  stream.flush();
+  return status;
+}
+
 int CLIRunner::postRun() {
   info("Post-run", false, true);
 
   // Open output stream
-  std::unique_ptr<QTextStream> stream;
   std::unique_ptr<QFile> outputFile;
-  if (m_options.outputFile.isEmpty()) {
-    stream = std::make_unique<QTextStream>(stdout, QIODevice::WriteOnly);
-  } else {
-    outputFile = std::make_unique<QFile>(m_options.outputFile);
-    if (!outputFile->open(QIODevice::Truncate | QIODevice::Text |
-                          QIODevice::WriteOnly)) {
-      error("Failed to open output file");
-      return 1;
+  auto stream = openOutput(outputFile);
+  if (!stream)
+    return 1;
+
+  // Gather the reported values. Host telemetry is reported last, such that
+  // it includes the time spent gathering the other reports.
+  std::vector<QVariant> reports(m_options.telemetry.size());
+  {
+    HostProfile::Scope scope("postRun");
+    for (size_t i = 0; i < m_options.telemetry.size(); ++i) {
+      auto &telemetry = m_options.telemetry[i];
+      if (telemetry->isEnabled() &&
+          !dynamic_cast<HostTelemetry *>(telemetry.get()))
+        reports[i] = telemetry->report(m_options.jsonOutput);
     }
-    stream = std::make_unique<QTextStream>(outputFile.get());
+  }
+  for (size_t i = 0; i < m_options.telemetry.size(); ++i) {
+    auto &telemetry = m_options.telemetry[i];
+    if (telemetry->isEnabled() &&
+        dynamic_cast<HostTelemetry *>(telemetry.get()))
+      reports[i] = telemetry->report(m_options.jsonOutput);
   }
 
   if (m_options.jsonOutput) {
     // Telemetry output
     QJsonObject jsonOutput;
-    for (auto &telemetry : m_options.telemetry)
-      if (telemetry->isEnabled())
-        jsonOutput.insert(
-            telemetry->prettyKey(),
-            QJsonValue::fromVariant(telemetry->report(/*json=*/true)));
+    for (size_t i = 0; i < m_options.telemetry.size(); ++i)
+      if (m_options.telemetry[i]->isEnabled())
+        jsonOutput.insert(m_options.telemetry[i]->prettyKey(),
+                          QJsonValue::fromVariant(reports[i]));
     *stream << QJsonDocument(jsonOutput).toJson(QJsonDocument::Indented);
   } else {
     // Telemetry output
-    for (auto &telemetry : m_options.telemetry)
-      if (telemetry->isEnabled()) {
-        *stream << "===== " << telemetry->description() << "\n";
-        QVariant reportedValue = telemetry->report(/*json=*/false);
-        *stream << qVariantToString(reportedValue) << "\n";
+    for (size_t i = 0; i < m_options.telemetry.size(); ++i)
+      if (m_options.telemetry[i]->isEnabled()) {
+        *stream << "===== " << m_options.telemetry[i]->description() << "\n";
+        *stream << qVariantToString(reports[i]) << "\n";
       }
   }
 
@@ -1,7 +1,12 @@
 #pragma once
 
 #include "clioptions.h"
+#include <QFile>
 #include <QObject>
+#include <QTextStream>
+
+#include <cstdio>
+#include <memory>
 
 namespace Ripes {
 
@@ -13,17 +18,43 @@ class CLIRunner : public QObject {
   Q_OBJECT
 public:
   CLIRunner(const CLIModeOptions &options);
+  ~CLIRunner();
+
+  /// Exit status of a run which was stopped by --max-cycles or
+  /// --max-instructions.
+  static constexpr int kRunLimitExitCode = 2;
 
-  /// Runs the CLI mode.
+  /// Runs the CLI mode. Returns 0 if the program finished, kRunLimitExitCode
+  /// if it was stopped by a run limit, and 1 on errors.
   int run();
 
 private:
+  /// Connects console input of the program to the input file or stdin.
+  int setupInput();
+
   /// Process the provided source file (assembling, compiling, loading, ...)
   int processInput();
 
-  /// Runs the processor model until the program is finished.
+  /// Validates and loads the executable ELF file @p path.
+  int loadElf(const QString &path);
+
+  /// Loads @p program into the processor.
+  void loadProgram(const Program &program);
+
+  /// Runs the processor model until the program is finished or a run limit
+  /// is reached.
   int runModel();
 
+  /// Runs the loaded program for each lane of CLIModeOptions::lanes in
+  /// lockstep, and prints the report of each lane to the console/output
+  /// file.
+  int runLanes();
+  template <typename XLEN_T>
+  int runLanes(QTextStream &stream);
+
+  /// Opens the console/output file to which the report is written.
+  std::unique_ptr<QTextStream> openOutput(std::unique_ptr<QFile> &outputFile);
+
   /// Prints requested telemetry to the console/output file.
   int postRun();
   void info(QString msg, bool alwaysPrint = false, bool header = false,
@@ -31,6 +62,7 @@ private:
   void error(const QString &msg);
 
   CLIModeOptions m_options;
+  std::FILE *m_inputFile = nullptr;
 };
 
 } // namespace Ripes
@@ -0,0 +1,71 @@
+#include "hostprofile.h"
+#include "utilities/systemutils.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace Ripes {
+
+HostProfile::Times HostProfile::now() const {
+  return {m_clock.nsecsElapsed() / 1000, processCPUTimeUs()};
+}
+
+void HostProfile::enter(const QString &phase) {
+  m_stack.push_back({phase, now(), {}});
+}
+
+void HostProfile::reset() {
+  assert(m_stack.empty() && "Cannot reset while a phase is entered");
+  m_totals.clear();
+}
+
+void HostProfile::leave() {
+  const Entry entry = m_stack.back();
+  m_stack.pop_back();
+  const Times end = now();
+  const Times elapsed = {end.wallUs - entry.start.wallUs,
+                         end.cpuUs - entry.start.cpuUs};
+
+  auto it = std::find_if(
+      m_totals.begin(), m_totals.end(),
+      [&](const auto &total) { return total.first == entry.phase; });
+  if (it == m_totals.end())
+    it = m_totals.emplace(m_totals.end(), entry.phase, Times{});
+  it->second.wallUs += elapsed.wallUs - entry.nested.wallUs;
+  it->second.cpuUs += elapsed.cpuUs - entry.nested.cpuUs;
+
+  if (!m_stack.empty()) {
+    m_stack.back().nested.wallUs += elapsed.wallUs;
+    m_stack.back().nested.cpuUs += elapsed.cpuUs;
+  }
+}
+
+HostProfile::Times HostProfile::times(const QString &phase) const {
+  Times t;
+  auto it =
+      std::find_if(m_totals.begin(), m_totals.end(),
+                   [&](const auto &total) { return total.first == phase; });
+  if (it != m_totals.end())
+    t = it->second;
+
+  const Times end = now();
+  for (const auto &entry : m_stack) {
+    if (entry.phase != phase)
+      continue;
+    t.wallUs += end.wallUs - entry.start.wallUs - entry.nested.wallUs;
+    t.cpuUs += end.cpuUs - entry.start.cpuUs - entry.nested.cpuUs;
+  }
+  return t;
+}
+
+std::vector<QString> HostProfile::phases() const {
+  std::vector<QString> names;
+  for (const auto &total : m_totals)
+    names.push_back(total.first);
+  for (const auto &entry : m_stack)
+    if (std::find(names.begin(), names.end(), entry.phase) == names.end())
+      names.push_back(entry.phase);
+  return names;
+}
+
+} // namespace Ripes
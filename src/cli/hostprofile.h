@@ -0,0 +1,63 @@
+#pragma once
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <vector>
+
+namespace Ripes {
+
+/// The HostProfile class records the host wall and CPU time spent in each
+/// phase of a CLI run (processor construction, program loading, ...).
+/// Phases may be nested, in which case the time of a nested phase is not
+/// counted towards the enclosing phase. Phases must be entered and left on
+/// the same thread.
+class HostProfile {
+public:
+  struct Times {
+    long long wallUs = 0;
+    long long cpuUs = 0;
+  };
+
+  static HostProfile &get() {
+    static HostProfile profile;
+    return profile;
+  }
+
+  /// Records the time between construction and destruction as @p phase.
+  class Scope {
+  public:
+    Scope(const QString &phase) { HostProfile::get().enter(phase); }
+    ~Scope() { HostProfile::get().leave(); }
+  };
+
+  void enter(const QString &phase);
+  void leave();
+
+  /// Returns the time recorded for @p phase. If the phase is currently
+  /// entered, the time spent in it so far is included.
+  Times times(const QString &phase) const;
+
+  /// Returns the names of all recorded phases, in the order they were first
+  /// entered.
+  std::vector<QString> phases() const;
+
+  /// Discards all recorded phases. No phase may currently be entered.
+  void reset();
+
+private:
+  HostProfile() { m_clock.start(); }
+  Times now() const;
+
+  struct Entry {
+    QString phase;
+    Times start;
+    Times nested;
+  };
+
+  QElapsedTimer m_clock;
+  std::vector<Entry> m_stack;
+  std::vector<std::pair<QString, Times>> m_totals;
+};
+
+} // namespace Ripes
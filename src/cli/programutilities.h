@@ -8,4 +8,13 @@ namespace Ripes {
 QString loadFlatBinaryFile(Program &program, const QString &filepath,
                            unsigned long entryPoint, unsigned long loadAt);
 
+/// Loads the sections, function symbols and entry point of the executable ELF
+/// file @p filepath into @p program. Source mappings are loaded from the debug
+/// information of the file, if it was compiled from within the Ripes editor;
+/// failure to load debug information is not an error, but is reported through
+/// @p debugInfoError if provided. Returns an error message if the file could
+/// not be loaded.
+QString loadElfFile(Program &program, const QString &filepath,
+                    QString *debugInfoError = nullptr);
+
 } // namespace Ripes
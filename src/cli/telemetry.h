@@ -2,9 +2,11 @@
 
 #include <QTextStream>
 
+#include "hostprofile.h"
 #include "pipelinediagrammodel.h"
 #include "processorhandler.h"
 #include "radix.h"
+#include "utilities/systemutils.h"
 
 #include <memory>
 
@@ -29,6 +31,11 @@ public:
   // Returns the description of this telemetry.
   virtual QString description() const = 0;
 
+  // Returns true if this telemetry observes each clock cycle of the processor.
+  // Such telemetry is unavailable with the translated engine, which executes
+  // an entire translated block per cycle.
+  virtual bool perCycle() const { return false; }
+
   virtual void enable() { m_enabled = true; }
   virtual void disable() { m_enabled = false; }
   bool isEnabled() const { return m_enabled; }
@@ -100,6 +107,7 @@ public:
 
   QString key() const override { return "pipeline"; }
   QString description() const override { return "pipeline state"; }
+  bool perCycle() const override { return true; }
   QVariant report(bool /*json*/) override {
     // Simply grab the current state of the pipeline diagram model and print it.
     return m_pipelineDiagramModel->toString();
@@ -161,4 +169,62 @@ private:
   QCommandLineParser *m_parser = nullptr;
 };
 
+class HostTelemetry : public Telemetry {
+public:
+  QString key() const override { return "host"; }
+  QString description() const override {
+    return "host wall and CPU time per phase, simulated cycles per host "
+           "second and peak memory usage";
+  }
+  QVariant report(bool json) override {
+    auto &profile = HostProfile::get();
+    const HostProfile::Times syscalls = {
+        ProcessorHandler::syscallWallTimeUs(),
+        ProcessorHandler::syscallCPUTimeUs()};
+
+    // The run phase is reported exclusive of the time spent in syscalls.
+    std::vector<std::pair<QString, HostProfile::Times>> phases;
+    for (const auto &phase : profile.phases()) {
+      auto t = profile.times(phase);
+      if (phase == "run") {
+        t.wallUs -= syscalls.wallUs;
+        t.cpuUs -= syscalls.cpuUs;
+      }
+      phases.push_back({phase, t});
+    }
+    phases.push_back({"syscalls", syscalls});
+
+    const auto runWallUs = profile.times("run").wallUs;
+    const double cyclesPerSecond =
+        runWallUs == 0 ? 0
+                       : ProcessorHandler::getProcessor()->getCycleCount() /
+                             (runWallUs / 1e6);
+    const long long peakRSS = peakResidentSetBytes();
+
+    if (json) {
+      QVariantMap phaseMap;
+      for (const auto &[phase, t] : phases) {
+        QVariantMap times;
+        times["wallMs"] = t.wallUs / 1e3;
+        times["cpuMs"] = t.cpuUs / 1e3;
+        phaseMap[phase] = times;
+      }
+      QVariantMap m;
+      m["phases"] = phaseMap;
+      m["cyclesPerSecond"] = cyclesPerSecond;
+      m["peakRSSBytes"] = peakRSS;
+      return m;
+    } else {
+      QString outStr;
+      QTextStream out(&outStr);
+      for (const auto &[phase, t] : phases)
+        out << phase << ":\twall " << t.wallUs / 1e3 << " ms\tcpu "
+            << t.cpuUs / 1e3 << " ms\n";
+      out << "cycles/s:\t" << cyclesPerSecond << "\n";
+      out << "peak RSS:\t" << peakRSS << " bytes\n";
+      return outStr;
+    }
+  }
+};
+
 } // namespace Ripes
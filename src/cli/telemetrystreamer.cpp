@@ -0,0 +1,100 @@
+#include "telemetrystreamer.h"
+#include "processorhandler.h"
+
+#include <QJsonDocument>
+
+namespace Ripes {
+
+TelemetryStreamer::TelemetryStreamer(const CLIModeOptions &options)
+    : m_options(options) {}
+
+TelemetryStreamer::~TelemetryStreamer() { stop(); }
+
+bool TelemetryStreamer::start(QString &errorMessage) {
+  if (m_options.telemetryOutput.isEmpty()) {
+    m_output = stderr;
+  } else {
+    m_output = std::fopen(m_options.telemetryOutput.toLocal8Bit().constData(),
+                          "w");
+    if (!m_output) {
+      errorMessage = "Failed to open telemetry output file '" +
+                     m_options.telemetryOutput + "' (--telemetry-output).";
+      return false;
+    }
+  }
+
+  m_stopping = false;
+  m_elapsed.start();
+  m_writer = std::thread([this] { writerLoop(); });
+  ProcessorHandler::setRunCallback([this] { sample(); },
+                                   m_options.telemetryIntervalCycles);
+  return true;
+}
+
+void TelemetryStreamer::stop() {
+  if (!m_writer.joinable())
+    return;
+  ProcessorHandler::setRunCallback({});
+  {
+    std::lock_guard lock(m_lock);
+    m_stopping = true;
+  }
+  m_cv.notify_one();
+  m_writer.join();
+  if (m_output != stderr)
+    std::fclose(m_output);
+  m_output = nullptr;
+}
+
+void TelemetryStreamer::sample() {
+  auto *proc = ProcessorHandler::getProcessor();
+  QJsonObject sample;
+  sample.insert("cycle", proc->getCycleCount());
+  sample.insert("elapsedMs", m_elapsed.elapsed());
+  for (auto &telemetry : m_options.telemetry)
+    if (telemetry->isEnabled())
+      sample.insert(telemetry->prettyKey(),
+                    QJsonValue::fromVariant(telemetry->report(/*json=*/true)));
+  {
+    std::lock_guard lock(m_lock);
+    m_queue.push_back(std::move(sample));
+  }
+  m_cv.notify_one();
+}
+
+void TelemetryStreamer::writerLoop() {
+  const auto interval =
+      std::chrono::milliseconds(m_options.telemetryIntervalMs);
+  auto nextRequest = std::chrono::steady_clock::now() + interval;
+  std::unique_lock lock(m_lock);
+  while (true) {
+    // Time-based sampling: the writer thread acts as the timer, and requests
+    // a sample from the simulation thread whenever the interval has elapsed.
+    if (m_options.telemetryIntervalMs > 0) {
+      if (m_cv.wait_until(lock, nextRequest, [this] {
+            return m_stopping || !m_queue.empty();
+          }) == false) {
+        ProcessorHandler::requestRunCallback();
+        nextRequest += interval;
+        continue;
+      }
+    } else {
+      m_cv.wait(lock, [this] { return m_stopping || !m_queue.empty(); });
+    }
+
+    while (!m_queue.empty()) {
+      const QJsonObject sample = std::move(m_queue.front());
+      m_queue.pop_front();
+      lock.unlock();
+      const QByteArray line =
+          QJsonDocument(sample).toJson(QJsonDocument::Compact) + '\n';
+      std::fwrite(line.constData(), 1, line.size(), m_output);
+      std::fflush(m_output);
+      lock.lock();
+    }
+    if (m_stopping)
+      return;
+  }
+}
+
+} // namespace Ripes
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "clioptions.h"
+#include <QElapsedTimer>
+#include <QJsonObject>
+
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace Ripes {
+
+/// The TelemetryStreamer class periodically reports the enabled telemetry
+/// while the processor is running (--telemetry-interval). Samples are taken
+/// on the simulation thread through the ProcessorHandler run callback, every
+/// N cycles or every T milliseconds. Samples are serialized and written as
+/// one JSON object per line (NDJSON) by a background writer thread, to avoid
+/// stalling the simulation on output.
+class TelemetryStreamer {
+public:
+  TelemetryStreamer(const CLIModeOptions &options);
+  ~TelemetryStreamer();
+
+  /// Opens the output and registers the run callback. Returns false, with
+  /// @p errorMessage set, if the output could not be opened.
+  bool start(QString &errorMessage);
+
+  /// Unregisters the run callback and waits for all pending samples to be
+  /// written. Must not be called while the processor is running.
+  void stop();
+
+private:
+  /// Records a sample of the enabled telemetry. Called on the simulation
+  /// thread.
+  void sample();
+  void writerLoop();
+
+  const CLIModeOptions &m_options;
+  std::FILE *m_output = nullptr;
+  QElapsedTimer m_elapsed;
+
+  std::thread m_writer;
+  std::mutex m_lock;
+  std::condition_variable m_cv;
+  std::deque<QJsonObject> m_queue;
+  bool m_stopping = false;
+};
+
+} // namespace Ripes
@@ -15,7 +15,10 @@ Console::Console(QWidget *parent) : QPlainTextEdit(parent) {
   }
   setFont(m_font);
 
-  document()->setMaximumBlockCount(100);
+  document()->setMaximumBlockCount(s_scrollbackLines);
+  m_flushTimer.setSingleShot(true);
+  m_flushTimer.setInterval(s_flushIntervalMs);
+  connect(&m_flushTimer, &QTimer::timeout, this, &Console::flushPendingData);
 
   auto paletteChangeFunctor = [=] {
     QPalette p = palette();
@@ -46,11 +49,30 @@ Console::Console(QWidget *parent) : QPlainTextEdit(parent) {
 }
 
 void Console::putData(const QByteArray &bytes) {
+  m_pendingData += QString::fromUtf8(bytes);
+  if (!m_flushTimer.isActive())
+    m_flushTimer.start();
+}
+
+void Console::flushPendingData() {
+  m_flushTimer.stop();
+  if (m_pendingData.isEmpty())
+    return;
+
+  // Lines which would immediately be discarded from the scrollback are not
+  // inserted.
+  qsizetype start = m_pendingData.size();
+  for (int lines = 0; lines < s_scrollbackLines && start > 0; ++lines)
+    start = m_pendingData.lastIndexOf('\n', start - 1);
+  if (start > 0)
+    m_pendingData.remove(0, start + 1);
+
   // Text can always only be inserted at the end of the console
   auto cursorAtEnd = QTextCursor(document());
   cursorAtEnd.movePosition(QTextCursor::End);
   setTextCursor(cursorAtEnd);
-  insertPlainText(bytes);
+  insertPlainText(m_pendingData);
+  m_pendingData.clear();
 
   QScrollBar *bar = verticalScrollBar();
   bar->setValue(bar->maximum());
@@ -59,9 +81,13 @@ void Console::putData(const QByteArray &bytes) {
 void Console::clearConsole() {
   clear();
   m_buffer.clear();
+  m_pendingData.clear();
+  m_flushTimer.stop();
 }
 
 void Console::backspace() {
+  flushPendingData();
+
   // Deletes the last character in the console
   auto cursorAtEnd = QTextCursor(document());
   cursorAtEnd.movePosition(QTextCursor::End);
@@ -4,6 +4,7 @@
 
 #include <QFont>
 #include <QPlainTextEdit>
+#include <QTimer>
 
 namespace Ripes {
 
@@ -15,18 +16,28 @@ signals:
 
 public:
   Console(QWidget *parent = nullptr);
+  /// Appends @p data to the console. Appends are batched, and performed at
+  /// most once per s_flushIntervalMs.
   void putData(const QByteArray &data);
   void clearConsole();
 
+  /// Number of lines retained in the console.
+  static constexpr int s_scrollbackLines = 10000;
+  static constexpr int s_flushIntervalMs = 16;
+
 protected:
   void keyPressEvent(QKeyEvent *e) override;
 
 private:
   void backspace();
+  void flushPendingData();
 
   bool m_localEchoEnabled = false;
   QFont m_font;
   QString m_buffer;
+  /// Output which has not yet been appended to the console.
+  QString m_pendingData;
+  QTimer m_flushTimer;
 };
 
 } // namespace Ripes
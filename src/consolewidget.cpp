@@ -25,8 +25,10 @@ ConsoleWidget::ConsoleWidget(QWidget *parent)
           &SystemIO::putStdInData);
 
   // Print output data from SystemIO in the console.
-  connect(&SystemIO::get(), &SystemIO::doPrint, m_ui->console,
-          [&](auto text) { m_ui->console->putData(text.toUtf8()); });
+  connect(
+      &SystemIO::get(), &SystemIO::doPrint, m_ui->console,
+      [&](auto text) { m_ui->console->putData(text.toUtf8()); },
+      Qt::QueuedConnection);
 }
 
 ConsoleWidget::~ConsoleWidget() { delete m_ui; }
@@ -0,0 +1,206 @@
+#include "cosimulator.h"
+
+#include "isa/rvisainfo_common.h"
+#include "processors/ripesvsrtlprocessor.h"
+
+#include <algorithm>
+
+namespace Ripes {
+
+Cosimulator::Cosimulator(const Model &reference, const Model &test,
+                         const QStringList &extensions,
+                         const RegisterInitialization &regInit)
+    : m_refModel(reference), m_testModel(test), m_extensions(extensions),
+      m_regInit(regInit) {}
+
+void Cosimulator::load(Side &side, const Model &model,
+                       const Program &program) {
+  side.proc = ProcessorRegistry::constructProcessor(model.id, m_extensions,
+                                                    model.engine);
+  side.exited = false;
+  RipesProcessor *proc = side.proc.get();
+  proc->isExecutableAddress = [this](AInt address) {
+    return address >= m_textStart && address < m_textEnd;
+  };
+  // Only the exit syscall is handled; see the class documentation.
+  proc->trapHandler = [&side, proc] {
+    const unsigned function = proc->getRegister(
+        RegisterFileType::GPR, proc->implementsISA()->syscallReg());
+    if (function == RVABI::SysCall::Exit || function == RVABI::SysCall::Exit2)
+      side.exited = true;
+  };
+  proc->postConstruct();
+
+  // Nothing observes the models while cosimulating.
+  if (auto *design = dynamic_cast<vsrtl::SimDesign *>(proc))
+    design->setEnableSignals(false);
+  else
+    proc->setEmitsSignals(false);
+
+  auto &mem = proc->getMemory();
+  mem.clearInitializationMemories();
+  for (const auto &seg : program.sections) {
+    mem.addInitializationMemory(seg.second.address, seg.second.data.data(),
+                                seg.second.data.length());
+  }
+  proc->setPCInitialValue(program.entryPoint);
+  proc->resetProcessor();
+  for (const auto &kv : m_regInit)
+    proc->setRegister(RegisterFileType::GPR, kv.first, kv.second);
+
+  side.shadow.resize(proc->implementsISA()->regCnt());
+  for (unsigned i = 0; i < side.shadow.size(); ++i)
+    side.shadow[i] = proc->getRegister(RegisterFileType::GPR, i);
+}
+
+void Cosimulator::step(Side &side, std::vector<RegisterWrite> &writes) {
+  side.proc->clock();
+  for (unsigned i = 0; i < side.shadow.size(); ++i) {
+    const VInt value = side.proc->getRegister(RegisterFileType::GPR, i);
+    if (value != side.shadow[i]) {
+      writes.push_back({i, value});
+      side.shadow[i] = value;
+    }
+  }
+}
+
+bool Cosimulator::fillReference() {
+  while (m_pendingRef.empty()) {
+    if (m_ref.exited || m_ref.proc->finished())
+      return false;
+    if (m_maxCycles != 0 && m_ref.proc->getCycleCount() >= m_maxCycles)
+      return false;
+    m_scratch.clear();
+    step(m_ref, m_scratch);
+    m_pendingRef.insert(m_pendingRef.end(), m_scratch.begin(),
+                        m_scratch.end());
+  }
+  return true;
+}
+
+Cosimulator::Result
+Cosimulator::run(const std::shared_ptr<const Program> &program,
+                 long long maxCycles) {
+  Result result;
+  m_maxCycles = maxCycles;
+  m_pendingRef.clear();
+  if (const auto *text = program->getSection(TEXT_SECTION_NAME)) {
+    m_textStart = text->address;
+    m_textEnd = text->address + text->data.length();
+  }
+  load(m_ref, m_refModel, *program);
+  load(m_test, m_testModel, *program);
+
+  std::vector<RegisterWrite> writes;
+  while (!(m_test.exited || m_test.proc->finished())) {
+    if (maxCycles != 0 && result.cycles >= maxCycles) {
+      result.error =
+          "Maximum cycles reached (" + QString::number(maxCycles) + ")";
+      return result;
+    }
+    writes.clear();
+    step(m_test, writes);
+    result.cycles++;
+
+    while (!writes.empty()) {
+      if (!fillReference()) {
+        result.error = report(writes.front());
+        return result;
+      }
+      const RegisterWrite &expected = m_pendingRef.front();
+      auto it = std::find_if(writes.begin(), writes.end(), [&](const auto &w) {
+        return w.index == expected.index && w.value == expected.value;
+      });
+      if (it == writes.end()) {
+        result.error = report(writes.front());
+        return result;
+      }
+      writes.erase(it);
+      m_pendingRef.pop_front();
+      result.registerWrites++;
+    }
+  }
+  if (!m_test.exited)
+    result.error = checkFinalState(*program);
+  return result;
+}
+
+std::optional<QString>
+Cosimulator::checkFinalState(const Program &program) {
+  if (fillReference()) {
+    const auto &expected = m_pendingRef.front();
+    return "The model under test finished before writing x" +
+           QString::number(expected.index) + " -> 0x" +
+           QString::number(expected.value, 16);
+  }
+  if (!(m_ref.exited || m_ref.proc->finished()))
+    return QString("The reference model did not finish");
+
+  QString err;
+  for (unsigned i = 0; i < m_test.shadow.size(); ++i) {
+    if (m_test.shadow[i] == m_ref.shadow[i])
+      continue;
+    err += "Final value of register x" + QString::number(i) +
+           " differs:\t expected: 0x" + QString::number(m_ref.shadow[i], 16) +
+           "\tactual: 0x" + QString::number(m_test.shadow[i], 16) + "\n";
+  }
+
+  auto &testMem = m_test.proc->getMemory();
+  auto &refMem = m_ref.proc->getMemory();
+  for (const auto &seg : program.sections) {
+    if (seg.first == TEXT_SECTION_NAME)
+      continue;
+    const AInt end = seg.second.address + seg.second.data.length();
+    for (AInt address = seg.second.address; address < end; ++address) {
+      const VInt actual = testMem.readMemConst(address, 1) & 0xFF;
+      const VInt expected = refMem.readMemConst(address, 1) & 0xFF;
+      if (actual == expected)
+        continue;
+      err += "Final memory differs at address 0x" +
+             QString::number(address, 16) + " (" + seg.first +
+             "):\t expected: 0x" + QString::number(expected, 16) +
+             "\tactual: 0x" + QString::number(actual, 16) + "\n";
+      // Report the first difference of each section only.
+      break;
+    }
+  }
+  if (err.isEmpty())
+    return std::nullopt;
+  return err;
+}
+
+QString Cosimulator::report(const RegisterWrite &write) const {
+  const auto *test = m_test.proc.get();
+  const auto *ref = m_ref.proc.get();
+  QString err;
+  err += "Register write discrepancy detected";
+  err += "\nUnexpected write was: x" + QString::number(write.index) + " -> 0x" +
+         QString::number(write.value, 16);
+  if (!m_pendingRef.empty()) {
+    const auto &expected = m_pendingRef.front();
+    err += "\nExpected write was: x" + QString::number(expected.index) +
+           " -> 0x" + QString::number(expected.value, 16);
+  } else {
+    err += "\nThe reference model produced no further writes";
+  }
+  err += "\n\nTest processor state: \t\tPC: 0x" +
+         QString::number(test->getPcForStage({0, 0}), 16) +
+         "\t Cycle #: " + QString::number(test->getCycleCount());
+  err += "\nReference processor state: \tPC: 0x" +
+         QString::number(ref->getPcForStage({0, 0}), 16) +
+         "\t Cycle #: " + QString::number(ref->getCycleCount());
+  err += "\n";
+
+  for (unsigned i = 0; i < m_test.shadow.size(); ++i) {
+    const VInt actual = test->getRegister(RegisterFileType::GPR, i);
+    const VInt expected = ref->getRegister(RegisterFileType::GPR, i);
+    if (actual == expected)
+      continue;
+    err += "Difference in register x" + QString::number(i) + ":";
+    err += "\t expected: 0x" + QString::number(expected, 16) +
+           "\tactual: 0x" + QString::number(actual, 16) + "\n";
+  }
+  return err;
+}
+
+} // namespace Ripes
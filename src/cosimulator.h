@@ -0,0 +1,100 @@
+#pragma once
+
+#include <QString>
+
+#include <deque>
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "assembler/program.h"
+#include "processorregistry.h"
+
+namespace Ripes {
+
+/**
+ * @brief The Cosimulator class
+ * Runs a processor model under test in lockstep with a reference model, on
+ * the same program. After each cycle of a model, its register file is compared
+ * to a shadow copy to extract the register writes of that cycle. Each register
+ * write of the model under test must match the next register write of the
+ * reference model; the reference model is clocked on demand until it produces
+ * that write. Writes retired in the same cycle by a multiple-issue model may
+ * match the reference writes in any order. If the model under test finishes by
+ * leaving the program, rather than through the exit syscall, the final
+ * register files and data sections of the two models are compared as well.
+ *
+ * No trace of either model is recorded, so programs of any length are
+ * cosimulated in constant memory. The models are constructed independently of
+ * ProcessorHandler, and thus do not execute environment calls, except for
+ * detecting the exit syscall. Programs must therefore not depend on the results
+ * of environment calls, nor on the values of the counter CSRs.
+ */
+class Cosimulator {
+public:
+  struct Model {
+    ProcessorID id;
+    ProcessorEngine engine = ProcessorEngine::VSRTL;
+  };
+
+  struct Result {
+    /// Number of cycles of the model under test.
+    long long cycles = 0;
+    /// Number of register writes which were compared.
+    long long registerWrites = 0;
+    /// Set if the models diverged, or the cycle limit was reached, describing
+    /// the point of divergence.
+    std::optional<QString> error;
+  };
+
+  Cosimulator(const Model &reference, const Model &test,
+              const QStringList &extensions,
+              const RegisterInitialization &regInit = {});
+
+  /// Cosimulates @p program until the model under test exits or finishes.
+  /// If @p maxCycles is nonzero, cosimulation fails once the model under test
+  /// has been clocked for @p maxCycles cycles.
+  Result run(const std::shared_ptr<const Program> &program,
+             long long maxCycles = 0);
+
+private:
+  struct RegisterWrite {
+    unsigned index;
+    VInt value;
+  };
+
+  struct Side {
+    std::unique_ptr<RipesProcessor> proc;
+    /// The register values as of the last observed cycle.
+    std::vector<VInt> shadow;
+    bool exited = false;
+  };
+
+  void load(Side &side, const Model &model, const Program &program);
+  /// Clocks @p side, appending the register writes of the cycle to @p writes.
+  void step(Side &side, std::vector<RegisterWrite> &writes);
+  /// Clocks the reference model until it has produced a register write which
+  /// has not yet been matched. Returns false if the reference model exited,
+  /// finished or reached the cycle limit first.
+  bool fillReference();
+  /// Runs the reference model to completion, and compares its final state to
+  /// that of the finished model under test.
+  std::optional<QString> checkFinalState(const Program &program);
+  QString report(const RegisterWrite &write) const;
+
+  Model m_refModel;
+  Model m_testModel;
+  QStringList m_extensions;
+  RegisterInitialization m_regInit;
+  long long m_maxCycles = 0;
+  AInt m_textStart = 0;
+  AInt m_textEnd = 0;
+
+  Side m_ref;
+  Side m_test;
+  /// Register writes of the reference model which have not yet been matched.
+  std::deque<RegisterWrite> m_pendingRef;
+  std::vector<RegisterWrite> m_scratch;
+};
+
+} // namespace Ripes
@@ -73,8 +73,9 @@ public slots:
 
 private:
   // Assembles the provided text and updates the ProcessorHandler with the
-  // assembled program.
-  void assemble(const QString &sourceText);
+  // assembled program. If @p useCache, the program is looked up in and stored
+  // to the ProgramCache.
+  void assemble(const QString &sourceText, bool useCache);
   void compile();
 
   void updateProgramViewer();
@@ -95,5 +96,10 @@ private:
   SourceType m_currentSourceType = SourceType::Assembly;
 
   bool m_editorEnabled = true;
+
+  // Set when the source was loaded rather than edited (ie. a file was opened,
+  // or the source was restored from the settings). The next assembly of a
+  // loaded source consults the ProgramCache.
+  bool m_sourceLoaded = true;
 };
 } // namespace Ripes
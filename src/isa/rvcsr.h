@@ -0,0 +1,133 @@
+#pragma once
+
+#include <QString>
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+namespace Ripes {
+namespace RVISA {
+
+/// Counter CSRs of the Zicsr and Zicntr/Zihpm extensions. The counters of
+/// each range are indexed as: 0 = cycle, 1 = time, 2 = instret and
+/// 3-31 = hpmcounter3-31. On RV32, the upper 32 bits of each counter are read
+/// through the corresponding *h CSR.
+enum CounterCSR : unsigned {
+  Cycle = 0xC00,
+  Time = 0xC01,
+  InstRet = 0xC02,
+  HPMCounter3 = 0xC03,
+  CycleH = 0xC80,
+  TimeH = 0xC81,
+  InstRetH = 0xC82,
+  HPMCounter3H = 0xC83,
+  MCycle = 0xB00,
+  MInstRet = 0xB02,
+  MHPMCounter3 = 0xB03,
+  MCycleH = 0xB80,
+  MInstRetH = 0xB82,
+  MHPMCounter3H = 0xB83
+};
+
+/// Counter indices of the counter CSRs.
+enum Counter : unsigned {
+  CycleCounter = 0,
+  TimeCounter = 1,
+  InstRetCounter = 2,
+  FirstHPMCounter = 3,
+  NumCounters = 32
+};
+
+/// Location of a counter CSR; which counter it reads, and whether it reads
+/// the upper 32 bits of the counter.
+struct CounterCSRInfo {
+  unsigned counter;
+  bool high;
+};
+
+/// Returns the counter read by @p csr on an @p xlen-bit hart, if @p csr is a
+/// counter CSR.
+inline std::optional<CounterCSRInfo> counterCSRInfo(unsigned csr,
+                                                    unsigned xlen) {
+  const unsigned index = csr & 0x1F;
+  switch (csr & ~0x1Fu) {
+  case Cycle:
+    return CounterCSRInfo{index, false};
+  case CycleH:
+    if (xlen == 32)
+      return CounterCSRInfo{index, true};
+    return {};
+  case MCycle:
+    // There is no machine-mode time counter.
+    if (index != TimeCounter)
+      return CounterCSRInfo{index, false};
+    return {};
+  case MCycleH:
+    if (xlen == 32 && index != TimeCounter)
+      return CounterCSRInfo{index, true};
+    return {};
+  default:
+    return {};
+  }
+}
+
+/// Returns the value of the CSR @p csr of an @p xlen-bit hart, where
+/// @p counter returns the full 64-bit value of a counter index. CSRs other
+/// than the counter CSRs are not implemented, and read as zero.
+template <typename CounterFn>
+uint64_t readCounterCSR(unsigned csr, unsigned xlen, CounterFn &&counter) {
+  const auto info = counterCSRInfo(csr, xlen);
+  if (!info)
+    return 0;
+  const uint64_t value = counter(info->counter);
+  if (info->high)
+    return value >> 32;
+  return xlen == 32 ? static_cast<uint32_t>(value) : value;
+}
+
+/// Value of the time counter; microseconds of host wall-clock time since the
+/// UNIX epoch.
+inline uint64_t timeCounter() {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::system_clock::now().time_since_epoch())
+      .count();
+}
+
+/// Returns the name of the CSR @p csr, or an empty string if the CSR is not
+/// known by name.
+inline QString csrName(unsigned csr) {
+  static const char *const counterNames[] = {"cycle", "time", "instret"};
+  const unsigned index = csr & 0x1F;
+  const QString counter = index < FirstHPMCounter
+                              ? QString(counterNames[index])
+                              : "hpmcounter" + QString::number(index);
+  switch (csr & ~0x1Fu) {
+  case Cycle:
+    return counter;
+  case CycleH:
+    return counter + "h";
+  case MCycle:
+    return index == TimeCounter ? QString() : "m" + counter;
+  case MCycleH:
+    return index == TimeCounter ? QString() : "m" + counter + "h";
+  default:
+    return QString();
+  }
+}
+
+/// Returns the number of the CSR named @p name, if known.
+inline std::optional<unsigned> csrNumber(const QString &name) {
+  static const unsigned bases[] = {Cycle, CycleH, MCycle, MCycleH};
+  for (const unsigned base : bases) {
+    for (unsigned index = 0; index < NumCounters; ++index) {
+      const QString candidate = csrName(base | index);
+      if (!candidate.isEmpty() && candidate == name)
+        return base | index;
+    }
+  }
+  return {};
+}
+
+} // namespace RVISA
+} // namespace Ripes
@@ -0,0 +1,176 @@
+#pragma once
+
+#include <cstdint>
+
+#include "rvisainfo_common.h"
+
+namespace Ripes {
+namespace RVISA {
+
+/// Encoding formats of the instructions in the instruction table. The format
+/// determines which fields of an instruction word identify the instruction, as
+/// well as the operands of the instruction.
+enum class InstrFormat {
+  R,      // rd, rs1, rs2. Identified by opcode, funct3 and funct7.
+  I,      // rd, rs1, imm. Identified by opcode and funct3.
+  IShift, // rd, rs1, shamt. Identified by opcode, funct3 and funct6.
+  Load,   // rd, imm(rs1). Identified by opcode and funct3.
+  S,      // rs2, imm(rs1). Identified by opcode and funct3.
+  B,      // rs1, rs2, offset. Identified by opcode and funct3.
+  U,      // rd, imm. Identified by opcode.
+  J,      // rd, offset. Identified by opcode.
+  System, // No operands. Identified by opcode and funct3.
+  Csr,    // rd, csr, rs1. Identified by opcode and funct3.
+  CsrImm  // rd, csr, uimm. Identified by opcode and funct3.
+};
+
+// clang-format off
+/**
+ * The 32-bit RISC-V instructions supported by Ripes. This is the single
+ * definition of their encodings, from which both the assembler and the decode
+ * stage of the processor models are generated. Each entry is
+ *
+ *   X(name, mnemonic, format, opcode, funct3, funct7, extension, xlen)
+ *
+ * where name is the RVInstr enumerator of the instruction, extension is the
+ * ISA extension providing the instruction and xlen is the smallest register
+ * width for which the instruction is defined. The Zicsr instructions are
+ * always available, and are listed as part of the I extension. For IShift
+ * instructions, funct7 holds the upper 7 bits of the instruction word, of
+ * which the lowest bit is part of the shift amount on RV64.
+ */
+#define RV_INSTRUCTIONS(X)                                                     \
+  X(ECALL,  "ecall",  System, ECALL,   0b000, 0b0000000, 'I', 32)              \
+  X(LUI,    "lui",    U,      LUI,     0b000, 0b0000000, 'I', 32)              \
+  X(AUIPC,  "auipc",  U,      AUIPC,   0b000, 0b0000000, 'I', 32)              \
+  X(JAL,    "jal",    J,      JAL,     0b000, 0b0000000, 'I', 32)              \
+  X(JALR,   "jalr",   I,      JALR,    0b000, 0b0000000, 'I', 32)              \
+  X(LB,     "lb",     Load,   LOAD,    0b000, 0b0000000, 'I', 32)              \
+  X(LH,     "lh",     Load,   LOAD,    0b001, 0b0000000, 'I', 32)              \
+  X(LW,     "lw",     Load,   LOAD,    0b010, 0b0000000, 'I', 32)              \
+  X(LBU,    "lbu",    Load,   LOAD,    0b100, 0b0000000, 'I', 32)              \
+  X(LHU,    "lhu",    Load,   LOAD,    0b101, 0b0000000, 'I', 32)              \
+  X(SB,     "sb",     S,      STORE,   0b000, 0b0000000, 'I', 32)              \
+  X(SH,     "sh",     S,      STORE,   0b001, 0b0000000, 'I', 32)              \
+  X(SW,     "sw",     S,      STORE,   0b010, 0b0000000, 'I', 32)              \
+  X(ADDI,   "addi",   I,      OPIMM,   0b000, 0b0000000, 'I', 32)              \
+  X(SLTI,   "slti",   I,      OPIMM,   0b010, 0b0000000, 'I', 32)              \
+  X(SLTIU,  "sltiu",  I,      OPIMM,   0b011, 0b0000000, 'I', 32)              \
+  X(XORI,   "xori",   I,      OPIMM,   0b100, 0b0000000, 'I', 32)              \
+  X(ORI,    "ori",    I,      OPIMM,   0b110, 0b0000000, 'I', 32)              \
+  X(ANDI,   "andi",   I,      OPIMM,   0b111, 0b0000000, 'I', 32)              \
+  X(SLLI,   "slli",   IShift, OPIMM,   0b001, 0b0000000, 'I', 32)              \
+  X(SRLI,   "srli",   IShift, OPIMM,   0b101, 0b0000000, 'I', 32)              \
+  X(SRAI,   "srai",   IShift, OPIMM,   0b101, 0b0100000, 'I', 32)              \
+  X(ADD,    "add",    R,      OP,      0b000, 0b0000000, 'I', 32)              \
+  X(SUB,    "sub",    R,      OP,      0b000, 0b0100000, 'I', 32)              \
+  X(SLL,    "sll",    R,      OP,      0b001, 0b0000000, 'I', 32)              \
+  X(SLT,    "slt",    R,      OP,      0b010, 0b0000000, 'I', 32)              \
+  X(SLTU,   "sltu",   R,      OP,      0b011, 0b0000000, 'I', 32)              \
+  X(XOR,    "xor",    R,      OP,      0b100, 0b0000000, 'I', 32)              \
+  X(SRL,    "srl",    R,      OP,      0b101, 0b0000000, 'I', 32)              \
+  X(SRA,    "sra",    R,      OP,      0b101, 0b0100000, 'I', 32)              \
+  X(OR,     "or",     R,      OP,      0b110, 0b0000000, 'I', 32)              \
+  X(AND,    "and",    R,      OP,      0b111, 0b0000000, 'I', 32)              \
+  X(BEQ,    "beq",    B,      BRANCH,  0b000, 0b0000000, 'I', 32)              \
+  X(BNE,    "bne",    B,      BRANCH,  0b001, 0b0000000, 'I', 32)              \
+  X(BLT,    "blt",    B,      BRANCH,  0b100, 0b0000000, 'I', 32)              \
+  X(BGE,    "bge",    B,      BRANCH,  0b101, 0b0000000, 'I', 32)              \
+  X(BLTU,   "bltu",   B,      BRANCH,  0b110, 0b0000000, 'I', 32)              \
+  X(BGEU,   "bgeu",   B,      BRANCH,  0b111, 0b0000000, 'I', 32)              \
+  X(ADDIW,  "addiw",  I,      OPIMM32, 0b000, 0b0000000, 'I', 64)              \
+  X(SLLIW,  "slliw",  IShift, OPIMM32, 0b001, 0b0000000, 'I', 64)              \
+  X(SRLIW,  "srliw",  IShift, OPIMM32, 0b101, 0b0000000, 'I', 64)              \
+  X(SRAIW,  "sraiw",  IShift, OPIMM32, 0b101, 0b0100000, 'I', 64)              \
+  X(ADDW,   "addw",   R,      OP32,    0b000, 0b0000000, 'I', 64)              \
+  X(SUBW,   "subw",   R,      OP32,    0b000, 0b0100000, 'I', 64)              \
+  X(SLLW,   "sllw",   R,      OP32,    0b001, 0b0000000, 'I', 64)              \
+  X(SRLW,   "srlw",   R,      OP32,    0b101, 0b0000000, 'I', 64)              \
+  X(SRAW,   "sraw",   R,      OP32,    0b101, 0b0100000, 'I', 64)              \
+  X(LWU,    "lwu",    Load,   LOAD,    0b110, 0b0000000, 'I', 64)              \
+  X(LD,     "ld",     Load,   LOAD,    0b011, 0b0000000, 'I', 64)              \
+  X(SD,     "sd",     S,      STORE,   0b011, 0b0000000, 'I', 64)              \
+  X(MUL,    "mul",    R,      OP,      0b000, 0b0000001, 'M', 32)              \
+  X(MULH,   "mulh",   R,      OP,      0b001, 0b0000001, 'M', 32)              \
+  X(MULHSU, "mulhsu", R,      OP,      0b010, 0b0000001, 'M', 32)              \
+  X(MULHU,  "mulhu",  R,      OP,      0b011, 0b0000001, 'M', 32)              \
+  X(DIV,    "div",    R,      OP,      0b100, 0b0000001, 'M', 32)              \
+  X(DIVU,   "divu",   R,      OP,      0b101, 0b0000001, 'M', 32)              \
+  X(REM,    "rem",    R,      OP,      0b110, 0b0000001, 'M', 32)              \
+  X(REMU,   "remu",   R,      OP,      0b111, 0b0000001, 'M', 32)              \
+  X(MULW,   "mulw",   R,      OP32,    0b000, 0b0000001, 'M', 64)              \
+  X(DIVW,   "divw",   R,      OP32,    0b100, 0b0000001, 'M', 64)              \
+  X(DIVUW,  "divuw",  R,      OP32,    0b101, 0b0000001, 'M', 64)              \
+  X(REMW,   "remw",   R,      OP32,    0b110, 0b0000001, 'M', 64)              \
+  X(REMUW,  "remuw",  R,      OP32,    0b111, 0b0000001, 'M', 64)              \
+  X(CSRRW,  "csrrw",  Csr,    SYSTEM,  0b001, 0b0000000, 'I', 32)              \
+  X(CSRRS,  "csrrs",  Csr,    SYSTEM,  0b010, 0b0000000, 'I', 32)              \
+  X(CSRRC,  "csrrc",  Csr,    SYSTEM,  0b011, 0b0000000, 'I', 32)              \
+  X(CSRRWI, "csrrwi", CsrImm, SYSTEM,  0b101, 0b0000000, 'I', 32)              \
+  X(CSRRSI, "csrrsi", CsrImm, SYSTEM,  0b110, 0b0000000, 'I', 32)              \
+  X(CSRRCI, "csrrci", CsrImm, SYSTEM,  0b111, 0b0000000, 'I', 32)
+// clang-format on
+
+/// Encoding of an instruction in the instruction table.
+struct InstrEncoding {
+  const char *mnemonic;
+  InstrFormat format;
+  unsigned opcode;
+  unsigned funct3;
+  unsigned funct7;
+  char extension;
+  unsigned xlen;
+
+  /// Returns the bits of an instruction word which identify the instruction.
+  constexpr uint32_t mask() const {
+    switch (format) {
+    case InstrFormat::R:
+      return 0xFE00707F;
+    case InstrFormat::IShift:
+      return 0xFC00707F;
+    case InstrFormat::U:
+    case InstrFormat::J:
+      return 0x7F;
+    default:
+      return 0x707F;
+    }
+  }
+
+  /// Returns the value of the identifying bits of the instruction.
+  constexpr uint32_t match() const {
+    return (opcode | (funct3 << 12) | (funct7 << 25)) & mask();
+  }
+
+  /// Returns true if the instruction is available in an XLEN-bit ISA, given
+  /// whether the M extension is enabled.
+  constexpr bool availableIn(unsigned XLEN, bool extM) const {
+    return xlen <= XLEN && (extension == 'I' || (extension == 'M' && extM));
+  }
+};
+
+#define RV_INSTR_ENCODING(name, mnemonic, format, opcode, funct3, funct7,     \
+                          extension, xlen)                                     \
+  InstrEncoding{mnemonic, InstrFormat::format, Opcode::opcode,                 \
+                funct3,   funct7,              extension,                      \
+                xlen},
+inline constexpr InstrEncoding Instructions[] = {
+    RV_INSTRUCTIONS(RV_INSTR_ENCODING)};
+#undef RV_INSTR_ENCODING
+
+/// Returns true if no two instructions of the instruction table share an
+/// encoding, such that any instruction word decodes to at most one
+/// instruction.
+constexpr bool uniqueEncodings() {
+  for (const auto &a : Instructions) {
+    for (const auto &b : Instructions) {
+      const uint32_t mask = a.mask() & b.mask();
+      if (&a != &b && (a.match() & mask) == (b.match() & mask))
+        return false;
+    }
+  }
+  return true;
+}
+static_assert(uniqueEncodings(), "Ambiguous instruction table encodings");
+
+} // namespace RVISA
+} // namespace Ripes
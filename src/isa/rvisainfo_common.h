@@ -32,6 +32,7 @@ enum Opcode {
   OPIMM32 = 0b0011011,
   OP32 = 0b0111011,
   ECALL = 0b1110011,
+  SYSTEM = 0b1110011,
   AUIPC = 0b0010111,
   INVALID = 0b0
 };
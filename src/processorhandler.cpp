@@ -4,6 +4,7 @@
 #include "processors/ripesvsrtlprocessor.h"
 #include "ripessettings.h"
 #include "statusmanager.h"
+#include "utilities/systemutils.h"
 
 #include "assembler/program.h"
 #include "assembler/rv32i_assembler.h"
@@ -11,10 +12,16 @@
 #include "io/iomanager.h"
 
 #include "syscall/riscv_syscall.h"
+#include "syscall/systemio.h"
 
+#include <QElapsedTimer>
 #include <QMessageBox>
 #include <QtConcurrent/QtConcurrent>
 
+#include <algorithm>
+#include <climits>
+#include <limits>
+
 namespace Ripes {
 
 ProcessorHandler::ProcessorHandler() {
@@ -141,6 +148,61 @@ void ProcessorHandler::_loadProgram(const std::shared_ptr<Program> &p) {
 
 void ProcessorHandler::_writeMem(AInt address, VInt value, int size) {
   m_currentProcessor->getMemory().writeMem(address, value, size);
+  m_currentProcessor->memoryWritten(address, size);
+}
+
+/// Calls @p access(address, offset, bytes) for each of the naturally aligned
+/// accesses of at most sizeof(VInt) bytes which cover the @p size bytes at
+/// @p address, in order.
+template <typename F>
+static void forEachMemBlockAccess(AInt address, size_t size, F &&access) {
+  for (size_t offset = 0; offset < size;) {
+    const AInt accessAddress = address + offset;
+    unsigned bytes = sizeof(VInt);
+    while (bytes > 1 && (accessAddress % bytes != 0 || bytes > size - offset))
+      bytes /= 2;
+    access(accessAddress, offset, bytes);
+    offset += bytes;
+  }
+}
+
+void ProcessorHandler::_readMemBlock(AInt address, char *data, size_t size) {
+  auto &mem = m_currentProcessor->getMemory();
+  forEachMemBlockAccess(
+      address, size, [&](AInt accessAddress, size_t offset, unsigned bytes) {
+        const VInt value = mem.readMemConst(accessAddress, bytes);
+        for (unsigned i = 0; i < bytes; ++i)
+          data[offset + i] = static_cast<char>(value >> (i * CHAR_BIT));
+      });
+}
+
+void ProcessorHandler::_writeMemBlock(AInt address, const char *data,
+                                      size_t size) {
+  auto &mem = m_currentProcessor->getMemory();
+  forEachMemBlockAccess(
+      address, size, [&](AInt accessAddress, size_t offset, unsigned bytes) {
+        VInt value = 0;
+        for (unsigned i = 0; i < bytes; ++i)
+          value |= static_cast<VInt>(static_cast<uint8_t>(data[offset + i]))
+                   << (i * CHAR_BIT);
+        mem.writeMem(accessAddress, value, bytes);
+      });
+  m_currentProcessor->memoryWritten(address, size);
+}
+
+QByteArray ProcessorHandler::_readMemString(AInt address) {
+  // Strings are read in chunks, each of which may extend past the terminating
+  // null character.
+  constexpr size_t chunkSize = 64;
+  QByteArray string;
+  char chunk[chunkSize];
+  for (;; address += chunkSize) {
+    _readMemBlock(address, chunk, chunkSize);
+    const char *end = std::find(chunk, chunk + chunkSize, '\0');
+    string.append(chunk, end - chunk);
+    if (end != chunk + chunkSize)
+      return string;
+  }
 }
 
 vsrtl::core::AddressSpaceMM &ProcessorHandler::_getMemory() {
@@ -193,18 +255,51 @@ void ProcessorHandler::_run() {
     auto *vsrtl_proc =
         dynamic_cast<vsrtl::SimDesign *>(m_currentProcessor.get());
 
+    // Only disable the per-component signals of VSRTL designs.
+    // processorWasClocked is still emitted for each cycle, since per-cycle
+    // observers (ie. cache simulators and the pipeline diagram) depend on it.
     if (vsrtl_proc) {
       vsrtl_proc->setEnableSignals(false);
     }
 
+    const bool hasCallback = static_cast<bool>(m_runCallback);
+    const auto callbackCycle = [&] {
+      return m_runCallbackInterval > 0
+                 ? m_currentProcessor->getCycleCount() + m_runCallbackInterval
+                 : std::numeric_limits<long long>::max();
+    };
+    long long nextCallbackCycle = callbackCycle();
+    m_runCallbackRequested = false;
+    const bool hasLimits = m_maxCycles > 0 || m_maxInstructions > 0;
+    const long long maxCycles =
+        m_maxCycles > 0 ? m_maxCycles : std::numeric_limits<long long>::max();
+    const long long maxInstructions =
+        m_maxInstructions > 0 ? m_maxInstructions
+                              : std::numeric_limits<long long>::max();
+    m_runLimitReached = false;
     while (!(_checkBreakpoint() || m_currentProcessor->finished() ||
              m_stopRunningFlag)) {
+      if (hasLimits &&
+          (m_currentProcessor->getCycleCount() >= maxCycles ||
+           m_currentProcessor->getInstructionsRetired() >= maxInstructions)) {
+        m_runLimitReached = true;
+        break;
+      }
       m_currentProcessor->clock();
+      if (hasCallback &&
+          (m_currentProcessor->getCycleCount() >= nextCallbackCycle ||
+           m_runCallbackRequested.load(std::memory_order_relaxed))) {
+        m_runCallbackRequested = false;
+        nextCallbackCycle = callbackCycle();
+        m_runCallback();
+      }
     }
 
     if (vsrtl_proc) {
       vsrtl_proc->setEnableSignals(true);
     }
+    // Output of the run is printed before runFinished is delivered.
+    SystemIO::flushOutput();
     emit runFinished();
   }));
 }
@@ -285,9 +380,12 @@ void ProcessorHandler::_reset() {
 
 void ProcessorHandler::_selectProcessor(const ProcessorID &id,
                                         const QStringList &extensions,
-                                        const RegisterInitialization &setup) {
+                                        const RegisterInitialization &setup,
+                                        ProcessorEngine engine) {
   m_currentID = id;
   m_currentRegInits = setup;
+  m_syscallWallTimeUs = 0;
+  m_syscallCPUTimeUs = 0;
   RipesSettings::setValue(RIPES_SETTING_PROCESSOR_ID, id);
   RipesSettings::setValue(RIPES_SETTING_PROCESSOR_EXTENSIONS, extensions);
 
@@ -300,7 +398,7 @@ void ProcessorHandler::_selectProcessor(const ProcessorID &id,
 
   // Processor initializations
   m_currentProcessor =
-      ProcessorRegistry::constructProcessor(m_currentID, extensions);
+      ProcessorRegistry::constructProcessor(m_currentID, extensions, engine);
   m_currentProcessor->isExecutableAddress = [=](AInt address) {
     return _isExecutableAddress(address);
   };
@@ -394,6 +492,10 @@ QString ProcessorHandler::_disassembleInstr(const AInt addr) const {
 }
 
 void ProcessorHandler::syscallTrap() {
+  QElapsedTimer wallTimer;
+  wallTimer.start();
+  const long long cpuStart = processCPUTimeUs();
+
   auto futureWatcher = QFutureWatcher<bool>();
   futureWatcher.setFuture(QtConcurrent::run([=] {
     const unsigned int function = m_currentProcessor->getRegister(
@@ -402,6 +504,8 @@ void ProcessorHandler::syscallTrap() {
   }));
 
   futureWatcher.waitForFinished();
+  m_syscallWallTimeUs += wallTimer.nsecsElapsed() / 1000;
+  m_syscallCPUTimeUs += processCPUTimeUs() - cpuStart;
   if (!futureWatcher.result()) {
     // Syscall handling failed, stop running processor
     setStopRunFlag();
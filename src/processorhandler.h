@@ -3,6 +3,8 @@
 #include <QFuture>
 #include <QFutureWatcher>
 #include <QObject>
+#include <atomic>
+#include <functional>
 #include <memory>
 
 #include "VSRTL/graphics/gallantsignalwrapper.h"
@@ -82,13 +84,15 @@ public:
 
   /**
    * @brief selectProcessor
-   * Constructs the processor identified by @param id, and performs all
-   * necessary initialization through the RipesProcessor interface.
+   * Constructs the processor identified by @param id, simulated through
+   * @param engine, and performs all necessary initialization through the
+   * RipesProcessor interface.
    */
   static void selectProcessor(
       const ProcessorID &id, const QStringList &extensions = {},
-      const RegisterInitialization &setup = RegisterInitialization()) {
-    get()->_selectProcessor(id, extensions, setup);
+      const RegisterInitialization &setup = RegisterInitialization(),
+      ProcessorEngine engine = ProcessorEngine::VSRTL) {
+    get()->_selectProcessor(id, extensions, setup, engine);
   }
 
   /**
@@ -146,6 +150,34 @@ public:
     get()->_writeMem(address, value, size);
   }
 
+  /**
+   * @brief readMemBlock
+   * Reads @p size bytes of the memory of the simulator, starting at
+   * @p address, into @p data. Memory is read a word at a time, and without
+   * side effects.
+   */
+  static void readMemBlock(AInt address, char *data, size_t size) {
+    get()->_readMemBlock(address, data, size);
+  }
+
+  /**
+   * @brief writeMemBlock
+   * Writes @p size bytes of @p data into the memory of the simulator, starting
+   * at @p address. Memory is written a word at a time.
+   */
+  static void writeMemBlock(AInt address, const char *data, size_t size) {
+    get()->_writeMemBlock(address, data, size);
+  }
+
+  /**
+   * @brief readMemString
+   * @returns the null-terminated string at @p address in the memory of the
+   * simulator, excluding the terminating null character.
+   */
+  static QByteArray readMemString(AInt address) {
+    return get()->_readMemString(address);
+  }
+
   /**
    * @brief getRegisterValue
    * @returns value of register @param idx
@@ -207,6 +239,49 @@ public:
    */
   static void stopRun() { get()->_stopRun(); }
 
+  /**
+   * @brief setRunLimits
+   * Limits the number of cycles and instructions retired of the processor
+   * when running through run(). A run is stopped before either limit would be
+   * exceeded, unless a single clock retires multiple instructions (ie. a
+   * translated block). A limit of zero is disabled.
+   */
+  static void setRunLimits(long long maxCycles, long long maxInstructions) {
+    get()->m_maxCycles = maxCycles;
+    get()->m_maxInstructions = maxInstructions;
+  }
+
+  /// Returns true if the last run was stopped by reaching a run limit.
+  static bool runLimitReached() { return get()->m_runLimitReached; }
+
+  /// Returns the host wall and CPU time, in microseconds, spent handling
+  /// syscalls since the current processor was selected.
+  static long long syscallWallTimeUs() { return get()->m_syscallWallTimeUs; }
+  static long long syscallCPUTimeUs() { return get()->m_syscallCPUTimeUs; }
+
+  /**
+   * @brief setRunCallback
+   * Registers a @p callback which is called from the simulation thread while
+   * the processor is running through run(). The callback is called every
+   * @p cycleInterval cycles (if nonzero), and on the next cycle after
+   * requestRunCallback() has been called. An empty callback removes any
+   * registered callback. Must not be called while running.
+   */
+  static void setRunCallback(std::function<void()> callback,
+                             long long cycleInterval = 0) {
+    get()->m_runCallback = callback;
+    get()->m_runCallbackInterval = cycleInterval;
+  }
+
+  /**
+   * @brief requestRunCallback
+   * Requests the run callback to be called on the next cycle. May be called
+   * from any thread.
+   */
+  static void requestRunCallback() {
+    get()->m_runCallbackRequested.store(true, std::memory_order_relaxed);
+  }
+
 signals:
 
   /**
@@ -288,7 +363,8 @@ private:
                               bool doPlaceAndRoute = false);
   void _selectProcessor(
       const ProcessorID &id, const QStringList &extensions = {},
-      const RegisterInitialization &setup = RegisterInitialization());
+      const RegisterInitialization &setup = RegisterInitialization(),
+      ProcessorEngine engine = ProcessorEngine::VSRTL);
   bool _isExecutableAddress(AInt address) const;
   int _getCurrentProgramSize() const;
   AInt _getTextStart() const;
@@ -297,6 +373,9 @@ private:
   const vsrtl::core::AddressSpace &_getRegisters() const;
   void _setRegisterValue(RegisterFileType rfid, const unsigned idx, VInt value);
   void _writeMem(AInt address, VInt value, int size = sizeof(VInt));
+  void _readMemBlock(AInt address, char *data, size_t size);
+  void _writeMemBlock(AInt address, const char *data, size_t size);
+  QByteArray _readMemString(AInt address);
   VInt _getRegisterValue(RegisterFileType rfid, const unsigned idx) const;
   bool _checkBreakpoint();
   void _setBreakpoint(const AInt address, bool enabled);
@@ -337,6 +416,17 @@ private:
   bool m_stopRunningFlag = false;
   std::mutex m_clockLock;
 
+  long long m_maxCycles = 0;
+  long long m_maxInstructions = 0;
+  bool m_runLimitReached = false;
+
+  long long m_syscallWallTimeUs = 0;
+  long long m_syscallCPUTimeUs = 0;
+
+  std::function<void()> m_runCallback;
+  long long m_runCallbackInterval = 0;
+  std::atomic<bool> m_runCallbackRequested{false};
+
   /**
    * @brief To avoid excessive UI updates due to things relying on
    * procStateChangedNonRun, the m_procStateChangeTimer ensures that the signal
@@ -3,11 +3,13 @@
 #include <QPolygonF>
 
 #include "processors/RISC-V/rv5s/rv5s.h"
+#include "processors/RISC-V/rv5s_compiled/rv5s_compiled.h"
 #include "processors/RISC-V/rv5s_no_fw/rv5s_no_fw.h"
 #include "processors/RISC-V/rv5s_no_fw_hz/rv5s_no_fw_hz.h"
 #include "processors/RISC-V/rv5s_no_hz/rv5s_no_hz.h"
 #include "processors/RISC-V/rv6s_dual/rv6s_dual.h"
 #include "processors/RISC-V/rvss/rvss.h"
+#include "processors/RISC-V/rvss_compiled/rvss_compiled.h"
 
 namespace Ripes {
 
@@ -54,10 +56,10 @@ ProcessorRegistry::ProcessorRegistry() {
               ":/layouts/RISC-V/rvss/rv_ss_extended_layout.json",
               {{{0, 0}, QPointF{0.5, 0}}}}};
   defRegVals = {{2, 0x7ffffff0}, {3, 0x10000000}};
-  addProcessor(ProcInfo<vsrtl::core::RVSS<uint32_t>>(
+  addProcessor(ProcInfo<vsrtl::core::RVSS<uint32_t>, RVSSCompiled<uint32_t>>(
       ProcessorID::RV32_SS, "Single-cycle processor",
       "A single cycle processor", layouts, defRegVals));
-  addProcessor(ProcInfo<vsrtl::core::RVSS<uint64_t>>(
+  addProcessor(ProcInfo<vsrtl::core::RVSS<uint64_t>, RVSSCompiled<uint64_t>>(
       ProcessorID::RV64_SS, "Single-cycle processor",
       "A single cycle processor", layouts, defRegVals));
 
@@ -149,10 +151,10 @@ ProcessorRegistry::ProcessorRegistry() {
                {{0, 3}, QPointF{0.78, 0}},
                {{0, 4}, QPointF{0.9, 0}}}}};
   defRegVals = {{2, 0x7ffffff0}, {3, 0x10000000}};
-  addProcessor(ProcInfo<vsrtl::core::RV5S<uint32_t>>(
+  addProcessor(ProcInfo<vsrtl::core::RV5S<uint32_t>, RV5SCompiled<uint32_t>>(
       ProcessorID::RV32_5S, "5-stage processor", rv5s_desc, layouts,
       defRegVals));
-  addProcessor(ProcInfo<vsrtl::core::RV5S<uint64_t>>(
+  addProcessor(ProcInfo<vsrtl::core::RV5S<uint64_t>, RV5SCompiled<uint64_t>>(
       ProcessorID::RV64_5S, "5-stage processor", rv5s_desc, layouts,
       defRegVals));
 
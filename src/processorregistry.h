@@ -5,6 +5,7 @@
 #include <QPointF>
 #include <map>
 #include <memory>
+#include <type_traits>
 
 #include "processors/interface/ripesprocessor.h"
 
@@ -38,6 +39,14 @@ enum ProcessorID {
 Q_ENUM_NS(ProcessorID); // Register with the metaobject system
 // ============================================================================
 
+/// Simulation engines of the processor models. Every processor is simulated
+/// through its VSRTL design, whereas some processors additionally provide a
+/// compiled model which is architecturally equivalent, but which cannot be
+/// visualized nor reversed. The translated engine is the compiled model, with
+/// hot code additionally translated to host machine code; only the compiled
+/// models of the single-cycle processors translate.
+enum class ProcessorEngine { VSRTL, Compiled, Translated };
+
 using RegisterInitialization = std::map<unsigned, VInt>;
 struct Layout {
   QString name;
@@ -73,15 +82,42 @@ public:
   virtual ProcessorISAInfo isaInfo() const = 0;
   virtual std::unique_ptr<RipesProcessor>
   construct(const QStringList &extensions) = 0;
+  /// Returns true if the processor provides a compiled model.
+  virtual bool hasCompiledEngine() const = 0;
+  /// Returns true if the compiled model of the processor translates hot code
+  /// to host machine code.
+  virtual bool hasTranslatedEngine() const = 0;
+  /// Constructs the compiled model of the processor, or returns nullptr if the
+  /// processor does not provide one. If @p translate is set, the model
+  /// translates hot code to host machine code.
+  virtual std::unique_ptr<RipesProcessor>
+  constructCompiled(const QStringList &extensions, bool translate) = 0;
 };
 
-template <typename T>
+/// Processor information of the VSRTL processor T. TCompiled is the compiled
+/// model of T, if any, and declares whether it translates through
+/// TCompiled::supportsTranslation.
+template <typename T, typename TCompiled = void>
 class ProcInfo : public ProcInfoBase {
 public:
   using ProcInfoBase::ProcInfoBase;
   std::unique_ptr<RipesProcessor> construct(const QStringList &extensions) {
     return std::make_unique<T>(extensions);
   }
+  bool hasCompiledEngine() const { return !std::is_void_v<TCompiled>; }
+  bool hasTranslatedEngine() const {
+    if constexpr (std::is_void_v<TCompiled>)
+      return false;
+    else
+      return TCompiled::supportsTranslation;
+  }
+  std::unique_ptr<RipesProcessor>
+  constructCompiled(const QStringList &extensions, bool translate) {
+    if constexpr (std::is_void_v<TCompiled>)
+      return nullptr;
+    else
+      return std::make_unique<TCompiled>(extensions, translate);
+  }
   // At this point we force the processor type T to implement a static function
   // identifying its supported ISA.
   ProcessorISAInfo isaInfo() const { return T::supportsISA(); }
@@ -101,18 +137,27 @@ public:
     return *desc->second;
   }
   static std::unique_ptr<RipesProcessor>
-  constructProcessor(ProcessorID id, const QStringList &extensions) {
+  constructProcessor(ProcessorID id, const QStringList &extensions,
+                     ProcessorEngine engine = ProcessorEngine::VSRTL) {
     auto &_this = instance();
     auto it = _this.m_descriptions.find(id);
     Q_ASSERT(it != _this.m_descriptions.end());
+    if (engine != ProcessorEngine::VSRTL) {
+      Q_ASSERT(engine == ProcessorEngine::Translated
+                   ? it->second->hasTranslatedEngine()
+                   : it->second->hasCompiledEngine());
+      return it->second->constructCompiled(
+          extensions, engine == ProcessorEngine::Translated);
+    }
     return it->second->construct(extensions);
   }
 
 private:
-  template <typename T>
-  void addProcessor(const ProcInfo<T> &pinfo) {
+  template <typename T, typename TCompiled>
+  void addProcessor(const ProcInfo<T, TCompiled> &pinfo) {
     Q_ASSERT(m_descriptions.count(pinfo.id) == 0);
-    m_descriptions[pinfo.id] = std::make_unique<ProcInfo<T>>(pinfo);
+    m_descriptions[pinfo.id] =
+        std::make_unique<ProcInfo<T, TCompiled>>(pinfo);
   }
 
   ProcessorRegistry();
@@ -35,15 +35,18 @@ Enum(RVInstr, NOP,
      ADDIW, SLLIW, SRLIW, SRAIW, ADDW, SUBW, SLLW, SRLW, SRAW, LWU, LD, SD,
 
      /* RV64M Standard Extension */
-     MULW, DIVW, DIVUW, REMW, REMUW);
+     MULW, DIVW, DIVUW, REMW, REMUW,
+
+     /* Zicsr Standard Extension */
+     CSRRW, CSRRS, CSRRC, CSRRWI, CSRRSI, CSRRCI);
 
 /** Datapath enumerations */
 Enum(ALUOp, NOP, ADD, SUB, MUL, DIV, AND, OR, XOR, SL, SRA, SRL, LUI, LT, LTU,
      EQ, MULH, MULHU, MULHSU, DIVU, REM, REMU, SLW, SRLW, SRAW, ADDW, SUBW,
-     MULW, DIVW, DIVUW, REMW, REMUW);
+     MULW, DIVW, DIVUW, REMW, REMUW, CSR);
 Enum(RegWrSrc, MEMREAD, ALURES, PC4);
 Enum(AluSrc1, REG1, PC);
-Enum(AluSrc2, REG2, IMM);
+Enum(AluSrc2, REG2, IMM, CSR);
 Enum(CompOp, NOP, EQ, NE, LT, LTU, GE, GEU);
 Enum(MemOp, NOP, LB, LH, LW, LBU, LHU, SB, SH, SW, LWU, LD, SD);
 Enum(ECALL, none, print_int = 1, print_char = 2, print_string = 4, exit = 10);
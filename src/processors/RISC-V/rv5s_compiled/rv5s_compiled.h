@@ -0,0 +1,519 @@
+#pragma once
+
+#include "VSRTL/core/vsrtl_addressspace.h"
+
+#include "../../interface/ripesprocessor.h"
+
+#include "../riscv.h"
+#include "../rv_control.h"
+#include "../rv_csrfile.h"
+#include "../rv_decodecache.h"
+#include "../rv_executor.h"
+#include "../rv_uncompress.h"
+
+namespace Ripes {
+
+/**
+ * @brief The RV5SCompiled class
+ * Compiled model of the 5-stage processor with forwarding and hazard detection
+ * (vsrtl::core::RV5S). The stage separating registers of RV5S are plain
+ * structs, and a clock cycle evaluates the logic in between them as a single
+ * function, rather than propagating signals through the VSRTL circuit. Control
+ * signals are generated by vsrtl::core::Control, and forwarding, hazard
+ * detection and ecall handling follow the respective units of RV5S, such that
+ * the two models are cycle-equivalent. Arithmetic is shared with RVExecutor.
+ *
+ * The model is intended for headless simulation; it cannot be visualized nor
+ * reversed. Pipelined models are not translated to host machine code, and
+ * @p translate is ignored.
+ */
+template <typename XLEN_T>
+class RV5SCompiled : public RipesProcessor {
+  static constexpr unsigned XLEN = sizeof(XLEN_T) * CHAR_BIT;
+  using Executor = RVExecutor<XLEN_T>;
+  using Instr = RVDecodeTable::Instr;
+  using Control = vsrtl::core::Control;
+
+public:
+  enum Stage { IF = 0, ID = 1, EX = 2, MEM = 3, WB = 4, STAGECOUNT };
+  static constexpr bool supportsTranslation = false;
+
+  RV5SCompiled(const QStringList &extensions, bool translate = false)
+      : m_enabledISA(
+            std::make_shared<ISAInfo<XLenToRVISA<XLEN>()>>(extensions)) {
+    Q_UNUSED(translate);
+    m_features = Features::hasDCacheInterface | Features::hasICacheInterface;
+    m_decodeCache.setISA(m_enabledISA);
+    if (m_enabledISA->extensionEnabled("C"))
+      m_expansionTable = &RVCExpansionTable::get(m_enabledISA->isaID());
+  }
+
+  static ProcessorISAInfo supportsISA() {
+    return ProcessorISAInfo{
+        std::make_shared<ISAInfo<XLenToRVISA<XLEN>()>>(QStringList()),
+        {"M", "C"},
+        {"M"}};
+  }
+  const ISAInfoBase *implementsISA() const override {
+    return m_enabledISA.get();
+  }
+  const std::set<RegisterFileType> registerFiles() const override {
+    return {RegisterFileType::GPR};
+  }
+
+  const ProcessorStructure &structure() const override { return m_structure; }
+  unsigned int getPcForStage(StageIndex idx) const override {
+    switch (idx.index()) {
+    case IF:
+      return m_pc;
+    case ID:
+      return m_ifid.pc;
+    case EX:
+      return m_idex.pc;
+    case MEM:
+      return m_exmem.pc;
+    case WB:
+      return m_memwb.pc;
+    default:
+      assert(false && "Processor does not contain stage");
+    }
+    Q_UNREACHABLE();
+  }
+  AInt nextFetchedAddress() const override {
+    return m_wires.controlflow ? m_wires.alures : m_wires.pc4;
+  }
+  QString stageName(StageIndex idx) const override {
+    switch (idx.index()) {
+    case IF:
+      return "IF";
+    case ID:
+      return "ID";
+    case EX:
+      return "EX";
+    case MEM:
+      return "MEM";
+    case WB:
+      return "WB";
+    default:
+      assert(false && "Processor does not contain stage");
+    }
+    Q_UNREACHABLE();
+  }
+  StageInfo stageInfo(StageIndex stage) const override {
+    const unsigned idx = stage.index();
+    // Has the pipeline stage been filled?
+    bool stageValid = static_cast<long long>(idx) <= m_cycleCount;
+
+    // Has the stage been cleared?
+    bool cleared = false;
+    bool stalled = false;
+    switch (idx) {
+    case ID:
+      cleared = !m_ifid.valid;
+      break;
+    case EX:
+      cleared = !m_idex.valid;
+      stalled = m_idex.stalled;
+      break;
+    case MEM:
+      cleared = !m_exmem.valid;
+      stalled = m_exmem.stalled;
+      break;
+    case WB:
+      cleared = !m_memwb.valid;
+      stalled = m_memwb.stalled;
+      break;
+    default:
+      break;
+    }
+    stageValid &= !cleared;
+
+    // Is the stage carrying a valid (executable) PC?
+    stageValid &= isExecutableAddress(getPcForStage(stage));
+
+    // Stages before EX are cleared while exiting through a syscall.
+    if (idx < EX)
+      stageValid &= !m_syscallExiting;
+
+    StageInfo::State state = StageInfo::State::None;
+    if (stalled)
+      state = StageInfo::State::Stalled;
+    else if (m_cycleCount > static_cast<long long>(idx) && cleared)
+      state = StageInfo::State::Flushed;
+    return StageInfo({getPcForStage(stage), stageValid, state});
+  }
+  const std::vector<StageIndex> breakpointTriggeringStages() const override {
+    return {{0, IF}};
+  }
+
+  vsrtl::core::AddressSpaceMM &getMemory() override { return *m_memory; }
+  MemoryAccess dataMemAccess() const override {
+    MemoryAccess access;
+    if (Control::do_do_read_ctrl(m_exmem.opcode))
+      access.type = MemoryAccess::Read;
+    else if (Control::do_do_mem_write_ctrl(m_exmem.opcode))
+      access.type = MemoryAccess::Write;
+    else
+      return access;
+    access.address = m_exmem.alures;
+    access.bytes = Executor::accessBytes(m_exmem.opcode);
+    return access;
+  }
+  MemoryAccess instrMemAccess() const override {
+    return {MemoryAccess::Read, m_pc, 4};
+  }
+
+  VInt getRegister(RegisterFileType, unsigned i) const override {
+    return m_regs.at(i);
+  }
+  void setRegister(RegisterFileType, unsigned i, VInt v) override {
+    // x0 is hardwired to zero.
+    if (i != 0)
+      m_regs.at(i) = static_cast<XLEN_T>(v);
+    propagate();
+  }
+  void setProgramCounter(AInt address) override {
+    m_pc = static_cast<XLEN_T>(address);
+    propagate();
+  }
+  void setPCInitialValue(AInt address) override {
+    m_pcInitialValue = static_cast<XLEN_T>(address);
+  }
+
+  void resetProcessor() override {
+    m_memory->reset();
+    m_regs.fill(0);
+    m_pc = m_pcInitialValue;
+    m_ifid = IFID();
+    m_idex = IDEX();
+    m_exmem = EXMEM();
+    m_memwb = MEMWB();
+    m_cycleCount = 0;
+    m_instructionsRetired = 0;
+    m_perfEvents.fill(0);
+    m_syscallExiting = false;
+    propagate();
+    if (m_emitsSignals)
+      processorWasReset.Emit();
+  }
+
+  void finalize(FinalizeReason fr) override {
+    m_syscallExiting |= (fr & FinalizeReason::exitSyscall) != 0;
+  }
+  bool finished() const override {
+    // The processor is finished when there are no more valid instructions in
+    // the pipeline
+    for (int stage = IF; stage < STAGECOUNT; stage++) {
+      if (stageInfo({0, stage}).stage_valid)
+        return false;
+    }
+    return true;
+  }
+
+  long long getInstructionsRetired() const override {
+    return m_instructionsRetired;
+  }
+  long long getCycleCount() const override { return m_cycleCount; }
+  long long getPerfEventCount(PerfEvent event) const override {
+    return m_perfEvents.at(static_cast<unsigned>(event));
+  }
+
+protected:
+  void clockProcessor() override {
+    const Wires &w = m_wires;
+    const bool frontEndEnable = !(w.loadUseHazard || w.ecallHazard);
+
+    // An instruction has been retired if the instruction in the WB stage is
+    // valid and the PC is within the executable range of the program
+    if (m_memwb.valid && isExecutableAddress(m_memwb.pc))
+      m_instructionsRetired++;
+    if (w.branchTaken)
+      countPerfEvent(PerfEvent::TakenBranches);
+    if (!frontEndEnable)
+      countPerfEvent(PerfEvent::StallCycles);
+    if (w.controlflow)
+      countPerfEvent(PerfEvent::Flushes);
+
+    // Clock the register file and data memory.
+    if (w.wbWrite && m_memwb.wrIdx != 0)
+      m_regs[m_memwb.wrIdx] = w.wbValue;
+    if (Control::do_do_mem_write_ctrl(m_exmem.opcode))
+      m_memory->writeMem(m_exmem.alures, m_exmem.r2,
+                         Executor::accessBytes(m_exmem.opcode));
+
+    // Clock the stage separating registers, from the back of the pipeline,
+    // such that each register latches the previous state of its predecessor.
+    // Stalling state is never cleared.
+    m_memwb.pc = m_exmem.pc;
+    m_memwb.pc4 = m_exmem.pc4;
+    m_memwb.alures = m_exmem.alures;
+    m_memwb.memRead = w.memRead;
+    m_memwb.opcode = m_exmem.opcode;
+    m_memwb.wrIdx = m_exmem.wrIdx;
+    m_memwb.valid = m_exmem.valid;
+    m_memwb.stalled = m_exmem.stalled;
+
+    const bool idexStalled = m_idex.stalled;
+    if (w.ecallHazard) {
+      m_exmem = EXMEM();
+    } else {
+      m_exmem.pc = m_idex.pc;
+      m_exmem.pc4 = m_idex.pc4;
+      m_exmem.alures = w.alures;
+      m_exmem.r2 = w.fw2;
+      m_exmem.opcode = m_idex.opcode;
+      m_exmem.wrIdx = m_idex.wrIdx;
+      m_exmem.valid = m_idex.valid;
+    }
+    m_exmem.stalled = w.ecallHazard || idexStalled;
+
+    if (w.controlflow || w.syscallExit || w.loadUseHazard) {
+      m_idex = IDEX();
+    } else if (!w.ecallHazard) {
+      m_idex.pc = m_ifid.pc;
+      m_idex.pc4 = m_ifid.pc4;
+      m_idex.r1 = w.r1;
+      m_idex.r2 = w.r2;
+      m_idex.imm = w.imm;
+      m_idex.opcode = w.opcode;
+      m_idex.wrIdx = w.wrIdx;
+      m_idex.rdIdx1 = w.rdIdx1;
+      m_idex.rdIdx2 = w.rdIdx2;
+      m_idex.valid = m_ifid.valid;
+    }
+    m_idex.stalled = w.loadUseHazard;
+
+    if (w.controlflow || w.syscallExit) {
+      m_ifid = IFID();
+    } else if (frontEndEnable) {
+      m_ifid.pc = m_pc;
+      m_ifid.pc4 = w.pc4;
+      m_ifid.instr = w.instr;
+      m_ifid.valid = true;
+    }
+
+    if (frontEndEnable)
+      m_pc = w.controlflow ? w.alures : w.pc4;
+
+    propagate();
+    m_cycleCount++;
+
+    if (m_emitsSignals)
+      processorWasClocked.Emit();
+  }
+
+private:
+  // Stage separating registers. The control signals of an instruction are
+  // generated from its opcode in each stage; a cleared register holds a NOP,
+  // for which all control signals are deasserted.
+  struct IFID {
+    XLEN_T pc = 0;
+    XLEN_T pc4 = 0;
+    uint32_t instr = 0;
+    bool valid = false;
+  };
+  struct IDEX {
+    XLEN_T pc = 0;
+    XLEN_T pc4 = 0;
+    XLEN_T r1 = 0;
+    XLEN_T r2 = 0;
+    XLEN_T imm = 0;
+    Instr opcode = RVInstr::NOP;
+    unsigned wrIdx = 0;
+    unsigned rdIdx1 = 0;
+    unsigned rdIdx2 = 0;
+    bool valid = false;
+    bool stalled = false;
+  };
+  struct EXMEM {
+    XLEN_T pc = 0;
+    XLEN_T pc4 = 0;
+    XLEN_T alures = 0;
+    XLEN_T r2 = 0;
+    Instr opcode = RVInstr::NOP;
+    unsigned wrIdx = 0;
+    bool valid = false;
+    bool stalled = false;
+  };
+  struct MEMWB {
+    XLEN_T pc = 0;
+    XLEN_T pc4 = 0;
+    XLEN_T alures = 0;
+    XLEN_T memRead = 0;
+    Instr opcode = RVInstr::NOP;
+    unsigned wrIdx = 0;
+    bool valid = false;
+    bool stalled = false;
+  };
+
+  // Combinational signals of the current cycle, computed by propagate().
+  struct Wires {
+    // IF
+    uint32_t instr = 0;
+    XLEN_T pc4 = 0;
+    // ID
+    Instr opcode = RVInstr::NOP;
+    unsigned wrIdx = 0;
+    unsigned rdIdx1 = 0;
+    unsigned rdIdx2 = 0;
+    XLEN_T imm = 0;
+    XLEN_T r1 = 0;
+    XLEN_T r2 = 0;
+    // EX
+    XLEN_T fw1 = 0;
+    XLEN_T fw2 = 0;
+    XLEN_T alures = 0;
+    bool branchTaken = false;
+    bool controlflow = false;
+    // MEM
+    XLEN_T memRead = 0;
+    // WB
+    XLEN_T wbValue = 0;
+    bool wbWrite = false;
+    // Hazard detection
+    bool loadUseHazard = false;
+    bool ecallHazard = false;
+    bool syscallExit = false;
+  };
+
+  /// Evaluates the combinational logic of the processor for the current state
+  /// of its registers and memories.
+  void propagate() {
+    Wires &w = m_wires;
+    const bool memDoRegWrite = Control::do_reg_do_write_ctrl(m_exmem.opcode);
+    w.wbWrite = Control::do_reg_do_write_ctrl(m_memwb.opcode);
+
+    // An ecall depends on all registers, and is handled once all outstanding
+    // register writes have been committed (see vsrtl::core::HazardUnit). The
+    // trap handler may write registers, which repropagates the processor;
+    // the ecall must not be handled again.
+    w.ecallHazard =
+        m_idex.opcode == RVInstr::ECALL && (memDoRegWrite || w.wbWrite);
+    if (m_idex.opcode == RVInstr::ECALL && !w.ecallHazard &&
+        !m_handlingEcall) {
+      assert(trapHandler && "No syscall callback was set!");
+      m_handlingEcall = true;
+      trapHandler();
+      m_handlingEcall = false;
+    }
+    // Handling an exit syscall clears the front-end of the pipeline in the
+    // same cycle.
+    w.syscallExit = m_syscallExiting;
+
+    // WB
+    const auto wbSrc = Control::do_reg_wr_src_ctrl(m_memwb.opcode);
+    if (wbSrc == +RegWrSrc::MEMREAD)
+      w.wbValue = m_memwb.memRead;
+    else if (wbSrc == +RegWrSrc::PC4)
+      w.wbValue = m_memwb.pc4;
+    else
+      w.wbValue = m_memwb.alures;
+
+    // MEM
+    w.memRead = 0;
+    if (Control::do_do_read_ctrl(m_exmem.opcode)) {
+      const unsigned bytes = Executor::accessBytes(m_exmem.opcode);
+      w.memRead = Executor::load(m_exmem.opcode,
+                                 m_memory->readMem(m_exmem.alures, bytes));
+    }
+
+    // EX
+    const Instr exOpcode = m_idex.opcode;
+    w.fw1 = forward(m_idex.rdIdx1, m_idex.r1, memDoRegWrite);
+    w.fw2 = forward(m_idex.rdIdx2, m_idex.r2, memDoRegWrite);
+    w.branchTaken = Control::do_branch_ctrl(exOpcode) &&
+                    Executor::branchTaken(exOpcode, w.fw1, w.fw2);
+    w.controlflow = w.branchTaken || Control::do_jump_ctrl(exOpcode);
+
+    const XLEN_T op1 = Control::do_alu_op1_ctrl(exOpcode) == +AluSrc1::PC
+                           ? m_idex.pc
+                           : w.fw1;
+    const auto op2Src = Control::do_alu_op2_ctrl(exOpcode);
+    XLEN_T op2 = w.fw2;
+    if (op2Src == +AluSrc2::IMM)
+      op2 = m_idex.imm;
+    else if (op2Src == +AluSrc2::CSR)
+      op2 = static_cast<XLEN_T>(rvReadCSR(*this, m_idex.imm & 0xFFF));
+    w.alures = alu(exOpcode, op1, op2);
+
+    // IF
+    const VInt word = m_memory->readMem(m_pc, 4);
+    const bool isCompressed = (word & 0b11) != 0b11 && word != 0;
+    w.instr = static_cast<uint32_t>(
+        m_expansionTable ? m_expansionTable->expand(word) : word);
+    w.pc4 = m_pc + (m_expansionTable && isCompressed ? 2 : 4);
+
+    // ID
+    const auto &decoded = m_decodeCache.lookup(m_ifid.instr);
+    w.opcode = static_cast<Instr>(decoded.opcode);
+    w.wrIdx = decoded.rd;
+    w.rdIdx1 = decoded.rs1;
+    w.rdIdx2 = decoded.rs2;
+    w.imm = static_cast<XLEN_T>(decoded.imm);
+    w.r1 = readRegister(w.rdIdx1);
+    w.r2 = readRegister(w.rdIdx2);
+
+    w.loadUseHazard = Control::do_do_read_ctrl(m_idex.opcode) &&
+                      (m_idex.wrIdx == w.rdIdx1 || m_idex.wrIdx == w.rdIdx2);
+  }
+
+  /// Reads register @p idx in the ID stage. The register file bypasses the
+  /// value being written back in the same cycle.
+  XLEN_T readRegister(unsigned idx) const {
+    if (idx == 0)
+      return 0;
+    if (m_wires.wbWrite && m_memwb.wrIdx == idx)
+      return m_wires.wbValue;
+    return m_regs[idx];
+  }
+
+  /// Returns the EX stage operand of register @p idx, which was read as
+  /// @p value in the ID stage (see vsrtl::core::ForwardingUnit).
+  XLEN_T forward(unsigned idx, XLEN_T value, bool memDoRegWrite) const {
+    if (idx == 0)
+      return value;
+    if (memDoRegWrite && m_exmem.wrIdx == idx)
+      return m_exmem.alures;
+    if (m_wires.wbWrite && m_memwb.wrIdx == idx)
+      return m_wires.wbValue;
+    return value;
+  }
+
+  static XLEN_T alu(Instr opcode, XLEN_T op1, XLEN_T op2) {
+    const auto ctrl = Control::do_alu_ctrl(opcode);
+    if (ctrl == +ALUOp::ADD)
+      return op1 + op2;
+    if (ctrl == +ALUOp::LUI || ctrl == +ALUOp::CSR)
+      return op2;
+    return Executor::compute(opcode, op1, op2);
+  }
+
+  void countPerfEvent(PerfEvent event) {
+    m_perfEvents.at(static_cast<unsigned>(event))++;
+  }
+
+  std::shared_ptr<ISAInfoBase> m_enabledISA;
+  vsrtl::core::RVDecodeCache<XLEN> m_decodeCache;
+  const RVCExpansionTable *m_expansionTable = nullptr;
+  std::shared_ptr<vsrtl::core::AddressSpaceMM> m_memory =
+      std::make_shared<vsrtl::core::AddressSpaceMM>();
+
+  std::array<XLEN_T, 32> m_regs{};
+  XLEN_T m_pc = 0;
+  XLEN_T m_pcInitialValue = 0;
+  IFID m_ifid;
+  IDEX m_idex;
+  EXMEM m_exmem;
+  MEMWB m_memwb;
+  Wires m_wires;
+
+  long long m_cycleCount = 0;
+  long long m_instructionsRetired = 0;
+  std::array<long long, static_cast<unsigned>(PerfEvent::NumEvents)>
+      m_perfEvents{};
+  bool m_syscallExiting = false;
+  bool m_handlingEcall = false;
+  ProcessorStructure m_structure = {{0, 5}};
+};
+
+} // namespace Ripes
@@ -13,6 +13,7 @@
 #include "../rv_alu.h"
 #include "../rv_branch.h"
 #include "../rv_control.h"
+#include "../rv_csrfile.h"
 #include "../rv_decode.h"
 #include "../rv_ecallchecker.h"
 #include "../rv_immediate.h"
@@ -46,6 +47,8 @@ public:
       : RipesVSRTLProcessor(
             "5-Stage RISC-V Processor without forwarding unit") {
     m_enabledISA = std::make_shared<ISAInfo<XLenToRVISA<XLEN>()>>(extensions);
+    decode->setDecodeCache(m_decodeCache);
+    immediate->setDecodeCache(m_decodeCache);
     decode->setISA(m_enabledISA);
     uncompress->setISA(m_enabledISA);
 
@@ -127,6 +130,7 @@ public:
 
     idex_reg->r2_out >> alu_op2_src->get(AluSrc2::REG2);
     idex_reg->imm_out >> alu_op2_src->get(AluSrc2::IMM);
+    csrFile->out >> alu_op2_src->get(AluSrc2::CSR);
     idex_reg->alu_op2_ctrl_out >> alu_op2_src->select;
 
     alu_op1_src->out >> alu->op1;
@@ -134,6 +138,11 @@ public:
 
     idex_reg->alu_ctrl_out >> alu->ctrl;
 
+    // -----------------------------------------------------------------------
+    // CSRs
+    idex_reg->imm_out >> csrFile->csr;
+    csrFile->setProcessor(this);
+
     // -----------------------------------------------------------------------
     // Data memory
     exmem_reg->alures_out >> data_mem->addr;
@@ -264,6 +273,7 @@ public:
   SUBCOMPONENT(branch, TYPE(Branch<XLEN>));
   SUBCOMPONENT(pc_4, Adder<XLEN>);
   SUBCOMPONENT(uncompress, TYPE(Uncompress<XLEN>));
+  SUBCOMPONENT(csrFile, TYPE(CSRFile<XLEN>));
 
   // Registers
   SUBCOMPONENT(pc_reg, RegisterClEn<XLEN>);
@@ -461,6 +471,7 @@ public:
         isExecutableAddress(memwb_reg->pc_out.uValue())) {
       m_instructionsRetired++;
     }
+    countPerfEvents(1);
 
     Design::clock();
   }
@@ -477,6 +488,7 @@ public:
         isExecutableAddress(memwb_reg->pc_out.uValue())) {
       m_instructionsRetired--;
     }
+    countPerfEvents(-1);
   }
 
   void reset() override {
@@ -506,6 +518,17 @@ public:
   }
 
 private:
+  /// Counts (n = 1) or un-counts (n = -1) the performance events of the
+  /// current cycle. Taken branches and jumps flush the IF and ID stages.
+  void countPerfEvents(long long n) {
+    if (br_and->out.uValue())
+      countPerfEvent(PerfEvent::TakenBranches, n);
+    if (!hzunit->hazardFEEnable.uValue())
+      countPerfEvent(PerfEvent::StallCycles, n);
+    if (controlflow_or->out.uValue())
+      countPerfEvent(PerfEvent::Flushes, n);
+  }
+
   /**
    * @brief m_syscallExitCycle
    * The variable will contain the cycle of which an exit system call was
@@ -514,6 +537,8 @@ private:
    */
   long long m_syscallExitCycle = -1;
   std::shared_ptr<ISAInfoBase> m_enabledISA;
+  std::shared_ptr<RVDecodeCache<XLEN>> m_decodeCache =
+      std::make_shared<RVDecodeCache<XLEN>>();
   ProcessorStructure m_structure = {{0, 5}};
 };
 
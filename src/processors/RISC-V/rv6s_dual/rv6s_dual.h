@@ -11,6 +11,7 @@
 #include "../riscv.h"
 #include "../rv_alu.h"
 #include "../rv_control.h"
+#include "../rv_csrfile.h"
 #include "../rv_decode.h"
 #include "../rv_ecallchecker.h"
 #include "../rv_immediate.h"
@@ -52,6 +53,10 @@ public:
   RV6S_DUAL(const QStringList &extensions)
       : RipesVSRTLProcessor("6-Stage dual-issue RISC-V Processor") {
     m_enabledISA = std::make_shared<ISAInfo<XLenToRVISA<XLEN>()>>(extensions);
+    decode_way2->setDecodeCache(m_decodeCache);
+    decode_way1->setDecodeCache(m_decodeCache);
+    imm_exec->setDecodeCache(m_decodeCache);
+    imm_data->setDecodeCache(m_decodeCache);
     decode_way2->setISA(m_enabledISA);
     decode_way1->setISA(m_enabledISA);
     uncompress_dual->setISA(m_enabledISA);
@@ -260,6 +265,7 @@ public:
 
     exec_reg2_fw_src->out >> alu_op2_exec_src->get(AluSrc2::REG2);
     iiex_reg->imm_out >> alu_op2_exec_src->get(AluSrc2::IMM);
+    csr_exec->out >> alu_op2_exec_src->get(AluSrc2::CSR);
     iiex_reg->alu_op2_ctrl_out >> alu_op2_exec_src->select;
 
     alu_op1_exec_src->out >> alu->op1;
@@ -294,6 +300,7 @@ public:
     // ALU operand multiplexers
     data_reg2_fw_src->out >> alu_op2_data_src->get(AluSrc2::REG2); // Todo: fix
     iiex_reg->imm_data_out >> alu_op2_data_src->get(AluSrc2::IMM);
+    csr_data->out >> alu_op2_data_src->get(AluSrc2::CSR);
     iiex_reg->alu_op2_ctrl_data_out >> alu_op2_data_src->select;
 
     // ALU inputs
@@ -301,6 +308,13 @@ public:
     alu_op2_data_src->out >> alu_data->op2;
     iiex_reg->alu_ctrl_data_out >> alu_data->ctrl;
 
+    // -----------------------------------------------------------------------
+    // CSRs
+    iiex_reg->imm_out >> csr_exec->csr;
+    iiex_reg->imm_data_out >> csr_data->csr;
+    csr_exec->setProcessor(this);
+    csr_data->setProcessor(this);
+
     // -----------------------------------------------------------------------
     // Data memory
     exmem_reg->alures_data_out >> data_mem->addr;
@@ -528,6 +542,8 @@ public:
   SUBCOMPONENT(waycontrol, WayControl);
   SUBCOMPONENT(imm_exec, TYPE(Immediate<XLEN>));
   SUBCOMPONENT(imm_data, TYPE(Immediate<XLEN>));
+  SUBCOMPONENT(csr_exec, TYPE(CSRFile<XLEN>));
+  SUBCOMPONENT(csr_data, TYPE(CSRFile<XLEN>));
   SUBCOMPONENT(decode_way2, TYPE(Decode<XLEN>));
   SUBCOMPONENT(decode_way1, TYPE(Decode<XLEN>));
   SUBCOMPONENT(branch, TYPE(Branch_DUAL<XLEN>));
@@ -858,6 +874,7 @@ public:
     // An instruction has been retired if the instruction in the WB stage is
     // valid and the PC is within the executable range of the program
     m_instructionsRetired += instructionsRetired();
+    countPerfEvents(1);
 
     Design::clock();
   }
@@ -871,6 +888,7 @@ public:
     }
     Design::reverse();
     m_instructionsRetired -= instructionsRetired();
+    countPerfEvents(-1);
   }
 
   void reset() override {
@@ -900,6 +918,18 @@ public:
   }
 
 private:
+  /// Counts (n = 1) or un-counts (n = -1) the performance events of the
+  /// current cycle. Control flow in the EX stage flushes the earlier stages.
+  void countPerfEvents(long long n) {
+    const bool controlflow = branch->did_controlflow.uValue();
+    if (controlflow && !branch->do_jump.uValue())
+      countPerfEvent(PerfEvent::TakenBranches, n);
+    if (!fe_en_or->out.uValue())
+      countPerfEvent(PerfEvent::StallCycles, n);
+    if (controlflow)
+      countPerfEvent(PerfEvent::Flushes, n);
+  }
+
   /**
    * @brief m_syscallExitCycle
    * The variable will contain the cycle of which an exit system call was
@@ -908,6 +938,8 @@ private:
    */
   long long m_syscallExitCycle = -1;
   std::shared_ptr<ISAInfoBase> m_enabledISA;
+  std::shared_ptr<RVDecodeCache<XLEN>> m_decodeCache =
+      std::make_shared<RVDecodeCache<XLEN>>();
   ProcessorStructure m_structure = {{0, 6}, {1, 6}};
 };
 
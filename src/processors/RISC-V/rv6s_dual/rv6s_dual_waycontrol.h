@@ -48,6 +48,10 @@ private:
             // Jump instructions
             case RVInstr::JALR:
             case RVInstr::JAL:
+
+            // CSR instructions
+            case RVInstr::CSRRW: case RVInstr::CSRRS: case RVInstr::CSRRC:
+            case RVInstr::CSRRWI: case RVInstr::CSRRSI: case RVInstr::CSRRCI:
                 return true;
             default: return false;
         }
@@ -133,6 +133,9 @@ public:
       case ALUOp::LUI:
         return VT_U(signextend<32>(op2.uValue()));
 
+      case ALUOp::CSR:
+        return op2.uValue();
+
       case ALUOp::LT:
         return VT_U(op1.sValue() < op2.sValue() ? 1 : 0);
 
@@ -0,0 +1,506 @@
+#pragma once
+
+#include <algorithm>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../../isa/rvcsr.h"
+#include "rv_executor.h"
+
+namespace Ripes {
+
+/**
+ * @brief The RVBatchMemory class
+ * Sparse, paged memory of a single lane of an RVBatchExecutor. Copies of a
+ * memory share their pages until a page is written to, such that the lanes of
+ * a batch only duplicate the pages which they modify. Unwritten memory reads
+ * as zero.
+ */
+class RVBatchMemory {
+public:
+  static constexpr unsigned s_pageBits = 12;
+  static constexpr AInt s_pageSize = AInt(1) << s_pageBits;
+  using Page = std::array<uint8_t, s_pageSize>;
+
+  RVBatchMemory() = default;
+  RVBatchMemory(const RVBatchMemory &other) : m_pages(other.m_pages) {}
+  RVBatchMemory &operator=(const RVBatchMemory &other) {
+    m_pages = other.m_pages;
+    m_lastIndex = ~AInt(0);
+    m_lastPage = nullptr;
+    return *this;
+  }
+
+  /// Writes @p size bytes of @p data to @p address.
+  void write(AInt address, const char *data, size_t size) {
+    for (size_t i = 0; i < size; ++i)
+      writableByte(address + i) = static_cast<uint8_t>(data[i]);
+  }
+
+  VInt readMem(AInt address, unsigned bytes) {
+    VInt value = 0;
+    for (unsigned i = 0; i < bytes; ++i)
+      value |= static_cast<VInt>(readByte(address + i)) << (i * CHAR_BIT);
+    return value;
+  }
+
+  void writeMem(AInt address, VInt value, int bytes) {
+    for (int i = 0; i < bytes; ++i)
+      writableByte(address + i) = static_cast<uint8_t>(value >> (i * CHAR_BIT));
+  }
+
+private:
+  uint8_t readByte(AInt address) {
+    const AInt index = address >> s_pageBits;
+    if (index != m_lastIndex) {
+      auto it = m_pages.find(index);
+      if (it == m_pages.end())
+        return 0;
+      m_lastIndex = index;
+      m_lastPage = it->second.get();
+    }
+    return (*m_lastPage)[address & (s_pageSize - 1)];
+  }
+
+  uint8_t &writableByte(AInt address) {
+    const AInt index = address >> s_pageBits;
+    auto &page = m_pages[index];
+    if (!page) {
+      page = std::make_shared<Page>();
+      page->fill(0);
+    } else if (page.use_count() > 1) {
+      // Shared with another lane; copy on write.
+      page = std::make_shared<Page>(*page);
+    }
+    m_lastIndex = index;
+    m_lastPage = page.get();
+    return (*page)[address & (s_pageSize - 1)];
+  }
+
+  std::unordered_map<AInt, std::shared_ptr<Page>> m_pages;
+  // The most recently accessed page, which is owned by m_pages.
+  AInt m_lastIndex = ~AInt(0);
+  Page *m_lastPage = nullptr;
+};
+
+/**
+ * @brief The RVBatchExecutor class
+ * Executes a single program over many lanes, each with its own architectural
+ * state and memory, ie. to run a program for many register initializations.
+ *
+ * Lane state is held in struct-of-arrays form. Lanes with equal program
+ * counters form a group, which executes in lockstep: each instruction is
+ * fetched and decoded once per group, and arithmetic instructions are
+ * evaluated as a loop over the register arrays of all lanes. Groups are split
+ * when their lanes diverge at branches and indirect jumps, and merged once
+ * they reconverge. The group with the lowest program counter is executed
+ * first, such that diverged lanes reconverge at the end of if/else blocks and
+ * loops.
+ *
+ * Instructions are fetched from the memory of the first lane of a group, ie.
+ * the program is assumed not to modify its own code. Memory mapped I/O is not
+ * available to batch lanes.
+ */
+template <typename XLEN_T>
+class RVBatchExecutor {
+public:
+  using Exec = RVExecutor<XLEN_T>;
+  using Decoded = typename Exec::Decoded;
+  using Instr = typename Exec::Instr;
+
+  /// Trap handler invoked for each lane which executes an ecall.
+  using TrapHandler = std::function<void(unsigned lane)>;
+
+  /// Why a lane stopped executing.
+  enum class LaneStatus { Running, Exited, LeftText, Error, Limit };
+
+  /// Creates @p lanes lanes, each starting at @p entryPoint with a copy of
+  /// @p memory.
+  RVBatchExecutor(const ISAInfoBase *isa, unsigned lanes,
+                  const RVBatchMemory &memory, XLEN_T entryPoint)
+      : m_exec(isa), m_lanes(lanes), m_regs(32 * lanes, 0),
+        m_memory(lanes, memory), m_status(lanes, LaneStatus::Running),
+        m_retired(lanes, 0), m_takenBranches(lanes, 0), m_exitCode(lanes, 0),
+        m_output(lanes), m_input(lanes), m_inputPos(lanes, 0) {
+    Lanes &group = m_groups[entryPoint];
+    for (unsigned l = 0; l < lanes; ++l)
+      group.push_back(l);
+  }
+
+  unsigned lanes() const { return m_lanes; }
+
+  XLEN_T getRegister(unsigned lane, unsigned i) const {
+    return m_regs[i * m_lanes + lane];
+  }
+  void setRegister(unsigned lane, unsigned i, XLEN_T value) {
+    if (i != 0)
+      m_regs[i * m_lanes + lane] = value;
+  }
+  RVBatchMemory &memory(unsigned lane) { return m_memory[lane]; }
+
+  LaneStatus status(unsigned lane) const { return m_status[lane]; }
+  long long instructionsRetired(unsigned lane) const {
+    return m_retired[lane];
+  }
+  /// Exit code of a lane which exited through an exit syscall.
+  int exitCode(unsigned lane) const { return m_exitCode[lane]; }
+  /// Output of the print and write syscalls of a lane.
+  const std::string &output(unsigned lane) const { return m_output[lane]; }
+  /// Sets the console input of a lane, which is read by read syscalls from
+  /// stdin.
+  void setInput(unsigned lane, std::string input) {
+    m_input[lane] = std::move(input);
+    m_inputPos[lane] = 0;
+  }
+
+  /// Stops a lane once its current instruction has executed.
+  void stopLane(unsigned lane, LaneStatus status) { m_status[lane] = status; }
+
+  /// Runs until all lanes have stopped. Lanes stop when executing an exit
+  /// syscall, when leaving the addresses for which @p isExecutable holds, or
+  /// after @p maxInstructions instructions if nonzero. Ecalls are handled by
+  /// @p trapHandler if set, and otherwise by handleSyscall.
+  void run(const std::function<bool(XLEN_T)> &isExecutable,
+           const TrapHandler &trapHandler = {},
+           long long maxInstructions = 0) {
+    while (!m_groups.empty()) {
+      // Execute the group with the lowest program counter.
+      const XLEN_T pc = m_groups.begin()->first;
+      Lanes lanes = std::move(m_groups.begin()->second);
+      m_groups.erase(m_groups.begin());
+
+      if (!isExecutable(pc)) {
+        for (const unsigned l : lanes)
+          m_status[l] = LaneStatus::LeftText;
+        continue;
+      }
+
+      step(pc, lanes, trapHandler);
+
+      if (maxInstructions > 0) {
+        for (const unsigned l : lanes)
+          if (m_retired[l] >= maxInstructions &&
+              m_status[l] == LaneStatus::Running)
+            m_status[l] = LaneStatus::Limit;
+      }
+      for (auto &successor : m_successors)
+        addGroup(successor.first, std::move(successor.second));
+      m_successors.clear();
+    }
+  }
+
+  /// Default trap handler, implementing the exit, print and console read and
+  /// write syscalls of the Ripes syscall ABI. Unsupported syscalls stop the
+  /// lane with an error.
+  void handleSyscall(unsigned lane) {
+    const XLEN_T a0 = getRegister(lane, 10);
+    switch (getRegister(lane, 17)) {
+    case RVABI::PrintInt: {
+      const auto value = static_cast<typename Exec::SXLEN_T>(a0);
+      m_output[lane] += value < 0 ? "-" + toString(XLEN_T(0) - a0, 10, 1)
+                                  : toString(a0, 10, 1);
+      break;
+    }
+    case RVABI::PrintIntUnsigned:
+      m_output[lane] += toString(a0, 10, 1);
+      break;
+    case RVABI::PrintIntHex:
+      m_output[lane] += "0x" + toString(a0, 16, sizeof(XLEN_T));
+      break;
+    case RVABI::PrintIntBinary:
+      m_output[lane] += "0b" + toString(a0, 2, Exec::XLEN);
+      break;
+    case RVABI::PrintChar:
+      m_output[lane] += static_cast<char>(a0);
+      break;
+    case RVABI::PrintStr: {
+      auto &mem = m_memory[lane];
+      XLEN_T address = a0;
+      while (const char c = static_cast<char>(mem.readMem(address++, 1)))
+        m_output[lane] += c;
+      break;
+    }
+    case RVABI::Read: {
+      // Only stdin is available to lanes.
+      if (a0 != 0) {
+        setRegister(lane, 10, XLEN_T(-1));
+        break;
+      }
+      const std::string &input = m_input[lane];
+      size_t &pos = m_inputPos[lane];
+      const size_t n = std::min<size_t>(getRegister(lane, 12),
+                                        input.size() - pos);
+      m_memory[lane].write(getRegister(lane, 11), input.data() + pos, n);
+      pos += n;
+      setRegister(lane, 10, static_cast<XLEN_T>(n));
+      break;
+    }
+    case RVABI::Write: {
+      // stdout and stderr are both written to the output of the lane.
+      if (a0 != 1 && a0 != 2) {
+        setRegister(lane, 10, XLEN_T(-1));
+        break;
+      }
+      auto &mem = m_memory[lane];
+      const XLEN_T address = getRegister(lane, 11);
+      const XLEN_T n = getRegister(lane, 12);
+      for (XLEN_T i = 0; i < n; ++i)
+        m_output[lane] += static_cast<char>(mem.readMem(address + i, 1));
+      setRegister(lane, 10, n);
+      break;
+    }
+    case RVABI::Exit:
+      stopLane(lane, LaneStatus::Exited);
+      break;
+    case RVABI::Exit2:
+      m_exitCode[lane] = static_cast<int>(a0);
+      stopLane(lane, LaneStatus::Exited);
+      break;
+    default:
+      stopLane(lane, LaneStatus::Error);
+      break;
+    }
+  }
+
+private:
+  /// Formats @p value in @p base, left-padded with zeroes to @p width digits.
+  static std::string toString(XLEN_T value, unsigned base, size_t width) {
+    static const char digits[] = "0123456789abcdef";
+    std::string str;
+    do {
+      str.insert(str.begin(), digits[value % base]);
+      value /= base;
+    } while (value != 0);
+    if (str.size() < width)
+      str.insert(0, width - str.size(), '0');
+    return str;
+  }
+
+  // Indices of the lanes of a group.
+  using Lanes = std::vector<unsigned>;
+
+  XLEN_T *reg(unsigned i) { return &m_regs[i * m_lanes]; }
+
+  /// Adds the running lanes of @p lanes to the group at @p pc.
+  void addGroup(XLEN_T pc, Lanes &&lanes) {
+    lanes.erase(std::remove_if(lanes.begin(), lanes.end(),
+                               [&](unsigned l) {
+                                 return m_status[l] != LaneStatus::Running;
+                               }),
+                lanes.end());
+    if (lanes.empty())
+      return;
+    auto &group = m_groups[pc];
+    if (group.empty())
+      group = std::move(lanes);
+    else
+      group.insert(group.end(), lanes.begin(), lanes.end());
+  }
+
+  /// Applies @p f to each lane of @p lanes. If @p lanes contains all lanes,
+  /// the lanes are visited in order, such that loops over the register arrays
+  /// may be vectorized.
+  template <typename F>
+  void forLanes(const Lanes &lanes, F f) {
+    if (lanes.size() == m_lanes) {
+      for (unsigned l = 0; l < m_lanes; ++l)
+        f(l);
+    } else {
+      for (const unsigned l : lanes)
+        f(l);
+    }
+  }
+
+  /// Evaluates the arithmetic instruction @p opcode for @p lanes.
+  template <Instr opcode>
+  void computeLanes(const Lanes &lanes, const Decoded &d) {
+    if (d.rd == 0)
+      return;
+    XLEN_T *dst = reg(d.rd);
+    const XLEN_T *a = reg(d.rs1);
+    const XLEN_T *b = reg(d.rs2);
+    if (d.immOperand) {
+      const XLEN_T imm = d.imm;
+      forLanes(lanes, [&](unsigned l) {
+        dst[l] = Exec::template compute<opcode>(a[l], imm);
+      });
+    } else {
+      forLanes(lanes, [&](unsigned l) {
+        dst[l] = Exec::template compute<opcode>(a[l], b[l]);
+      });
+    }
+  }
+
+  /// Returns the value of CSR @p csr of @p lane, as read by the instruction
+  /// currently being executed. Lanes are single cycle harts, so the cycle and
+  /// instret counters are equal, and hpmcounter3 counts taken branches (see
+  /// rvCounterValue).
+  XLEN_T readCSR(unsigned lane, unsigned csr) const {
+    return static_cast<XLEN_T>(
+        RVISA::readCounterCSR(csr, Exec::XLEN, [&](unsigned counter) {
+          switch (counter) {
+          case RVISA::CycleCounter:
+          case RVISA::InstRetCounter:
+            // m_retired already includes the current instruction.
+            return static_cast<uint64_t>(m_retired[lane] - 1);
+          case RVISA::TimeCounter:
+            return RVISA::timeCounter();
+          case RVISA::FirstHPMCounter:
+            return static_cast<uint64_t>(m_takenBranches[lane]);
+          default:
+            return uint64_t(0);
+          }
+        }));
+  }
+
+  /// Adds the successor group of @p lanes which continues at @p nextPc.
+  void addSuccessor(XLEN_T nextPc, unsigned lane) {
+    for (auto &successor : m_successors) {
+      if (successor.first == nextPc) {
+        successor.second.push_back(lane);
+        return;
+      }
+    }
+    m_successors.push_back({nextPc, {lane}});
+  }
+
+  /// Executes the instruction at @p pc for @p lanes, and adds the groups
+  /// continuing execution to m_successors.
+  void step(XLEN_T pc, Lanes &lanes, const TrapHandler &trapHandler) {
+    const Decoded d = m_exec.fetch(m_memory[lanes.front()], pc);
+    XLEN_T nextPc = pc + d.size;
+
+    forLanes(lanes, [&](unsigned l) { m_retired[l]++; });
+
+    switch (d.opcode) {
+    case RVInstr::NOP:
+      break;
+    case RVInstr::ECALL:
+      for (const unsigned l : lanes) {
+        if (trapHandler)
+          trapHandler(l);
+        else
+          handleSyscall(l);
+      }
+      break;
+    case RVInstr::LUI:
+    case RVInstr::AUIPC:
+    case RVInstr::JAL: {
+      if (d.rd != 0) {
+        XLEN_T *dst = reg(d.rd);
+        const XLEN_T value = d.opcode == RVInstr::LUI     ? d.imm
+                             : d.opcode == RVInstr::AUIPC ? pc + d.imm
+                                                          : nextPc;
+        forLanes(lanes, [&](unsigned l) { dst[l] = value; });
+      }
+      if (d.opcode == RVInstr::JAL)
+        nextPc = pc + d.imm;
+      break;
+    }
+    case RVInstr::JALR: {
+      for (const unsigned l : lanes) {
+        addSuccessor((getRegister(l, d.rs1) + d.imm) & ~XLEN_T(1), l);
+        setRegister(l, d.rd, nextPc);
+      }
+      return;
+    }
+    case RVInstr::BEQ:
+    case RVInstr::BNE:
+    case RVInstr::BLT:
+    case RVInstr::BGE:
+    case RVInstr::BLTU:
+    case RVInstr::BGEU: {
+      Lanes taken, notTaken;
+      for (const unsigned l : lanes) {
+        if (Exec::branchTaken(d.opcode, getRegister(l, d.rs1),
+                              getRegister(l, d.rs2)))
+          taken.push_back(l);
+        else
+          notTaken.push_back(l);
+      }
+      for (const unsigned l : taken)
+        m_takenBranches[l]++;
+      if (!taken.empty())
+        m_successors.push_back({pc + d.imm, std::move(taken)});
+      if (!notTaken.empty())
+        m_successors.push_back({nextPc, std::move(notTaken)});
+      return;
+    }
+    case RVInstr::CSRRW:
+    case RVInstr::CSRRS:
+    case RVInstr::CSRRC:
+    case RVInstr::CSRRWI:
+    case RVInstr::CSRRSI:
+    case RVInstr::CSRRCI:
+      for (const unsigned l : lanes)
+        setRegister(l, d.rd, readCSR(l, static_cast<unsigned>(d.imm)));
+      break;
+    case RVInstr::LB:
+    case RVInstr::LH:
+    case RVInstr::LW:
+    case RVInstr::LBU:
+    case RVInstr::LHU:
+    case RVInstr::LWU:
+    case RVInstr::LD: {
+      const unsigned bytes = Exec::accessBytes(d.opcode);
+      for (const unsigned l : lanes) {
+        const XLEN_T address = getRegister(l, d.rs1) + d.imm;
+        setRegister(l, d.rd,
+                    Exec::load(d.opcode, m_memory[l].readMem(address, bytes)));
+      }
+      break;
+    }
+    case RVInstr::SB:
+    case RVInstr::SH:
+    case RVInstr::SW:
+    case RVInstr::SD: {
+      const unsigned bytes = Exec::accessBytes(d.opcode);
+      for (const unsigned l : lanes) {
+        const XLEN_T address = getRegister(l, d.rs1) + d.imm;
+        m_memory[l].writeMem(address, getRegister(l, d.rs2), bytes);
+      }
+      break;
+    }
+    default:
+      switch (d.opcode) {
+#define RV_COMPUTE_LANES_CASE(name, ...)                                       \
+  case RVInstr::name:                                                          \
+    computeLanes<RVInstr::name>(lanes, d);                                     \
+    break;
+        RV_INSTRUCTIONS(RV_COMPUTE_LANES_CASE)
+#undef RV_COMPUTE_LANES_CASE
+      default:
+        break;
+      }
+      break;
+    }
+    m_successors.push_back({nextPc, std::move(lanes)});
+  }
+
+  Exec m_exec;
+  unsigned m_lanes;
+
+  // Register file; register i of lane l is m_regs[i * m_lanes + l].
+  std::vector<XLEN_T> m_regs;
+  std::vector<RVBatchMemory> m_memory;
+  std::vector<LaneStatus> m_status;
+  std::vector<long long> m_retired;
+  std::vector<long long> m_takenBranches;
+  std::vector<int> m_exitCode;
+  std::vector<std::string> m_output;
+  std::vector<std::string> m_input;
+  // Number of bytes of m_input which have been read by each lane.
+  std::vector<size_t> m_inputPos;
+
+  // Groups of lanes, keyed by their program counter.
+  std::map<XLEN_T, Lanes> m_groups;
+  // Groups continuing execution after the most recently executed step.
+  std::vector<std::pair<XLEN_T, Lanes>> m_successors;
+};
+
+} // namespace Ripes
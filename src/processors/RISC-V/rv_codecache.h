@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+namespace Ripes {
+
+/**
+ * @brief The RVCodeCache class
+ * Region of executable host memory holding translated code. Code is appended
+ * to the region until it is full, after which the owner must clear the cache.
+ * The region is only writable while code is being added to it (W^X).
+ */
+class RVCodeCache {
+public:
+  explicit RVCodeCache(size_t size) : m_size(size) {
+#ifdef _WIN32
+    m_base = static_cast<uint8_t *>(
+        VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+#else
+    void *base = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                      MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    m_base = base == MAP_FAILED ? nullptr : static_cast<uint8_t *>(base);
+#endif
+    if (m_base && !protect(false))
+      release();
+  }
+  ~RVCodeCache() { release(); }
+  RVCodeCache(const RVCodeCache &) = delete;
+  RVCodeCache &operator=(const RVCodeCache &) = delete;
+
+  /// Returns false if executable memory could not be allocated.
+  bool valid() const { return m_base != nullptr; }
+
+  /// Copies @p code into the cache and returns its executable address, or
+  /// nullptr if the cache is full.
+  const void *add(const std::vector<uint8_t> &code) {
+    if (!valid() || m_used + code.size() > m_size)
+      return nullptr;
+    if (!protect(true))
+      return nullptr;
+    uint8_t *dst = m_base + m_used;
+    std::memcpy(dst, code.data(), code.size());
+    m_used += code.size();
+    if (!protect(false))
+      return nullptr;
+    return dst;
+  }
+
+  /// Discards all code in the cache.
+  void clear() { m_used = 0; }
+
+private:
+  bool protect(bool writable) {
+#ifdef _WIN32
+    DWORD old;
+    const bool ok = VirtualProtect(m_base, m_size,
+                                   writable ? PAGE_READWRITE
+                                            : PAGE_EXECUTE_READ,
+                                   &old);
+    if (ok && !writable)
+      FlushInstructionCache(GetCurrentProcess(), m_base, m_size);
+    return ok;
+#else
+    return mprotect(m_base, m_size,
+                    writable ? PROT_READ | PROT_WRITE
+                             : PROT_READ | PROT_EXEC) == 0;
+#endif
+  }
+
+  void release() {
+    if (!m_base)
+      return;
+#ifdef _WIN32
+    VirtualFree(m_base, 0, MEM_RELEASE);
+#else
+    munmap(m_base, m_size);
+#endif
+    m_base = nullptr;
+  }
+
+  uint8_t *m_base = nullptr;
+  size_t m_size;
+  size_t m_used = 0;
+};
+
+} // namespace Ripes
@@ -86,6 +86,10 @@ public:
             // Jump instructions
             case RVInstr::JALR:
             case RVInstr::JAL:
+
+            // CSR instructions
+            case RVInstr::CSRRW: case RVInstr::CSRRS: case RVInstr::CSRRC:
+            case RVInstr::CSRRWI: case RVInstr::CSRRSI: case RVInstr::CSRRCI:
                 return 1;
             default: return 0;
         }
@@ -158,6 +162,11 @@ public:
         case RVInstr::JAL:
             return AluSrc2::IMM;
 
+        // CSR instructions
+        case RVInstr::CSRRW: case RVInstr::CSRRS: case RVInstr::CSRRC:
+        case RVInstr::CSRRWI: case RVInstr::CSRRSI: case RVInstr::CSRRCI:
+            return AluSrc2::CSR;
+
         default:
             return AluSrc2::REG2;
         }
@@ -216,6 +225,10 @@ public:
             case RVInstr::REMW  : return ALUOp::REMW ;
             case RVInstr::REMUW : return ALUOp::REMUW;
 
+            case RVInstr::CSRRW: case RVInstr::CSRRS: case RVInstr::CSRRC:
+            case RVInstr::CSRRWI: case RVInstr::CSRRSI: case RVInstr::CSRRCI:
+                return ALUOp::CSR;
+
             default: return ALUOp::NOP;
         }
     }
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "VSRTL/core/vsrtl_component.h"
+
+#include "../../isa/rvcsr.h"
+#include "../interface/ripesprocessor.h"
+#include "riscv.h"
+
+namespace Ripes {
+
+/**
+ * Returns the value of the counter @p counter (see isa/rvcsr.h) of @p proc.
+ * The hpmcounters are bound to a fixed set of events: hpmcounter3 counts taken
+ * branches, hpmcounter4 stall cycles and hpmcounter5 pipeline flushes. All
+ * other hpmcounters read as zero.
+ */
+inline uint64_t rvCounterValue(const RipesProcessor &proc, unsigned counter) {
+  using PerfEvent = RipesProcessor::PerfEvent;
+  switch (counter) {
+  case RVISA::CycleCounter:
+    return proc.getCycleCount();
+  case RVISA::TimeCounter:
+    return RVISA::timeCounter();
+  case RVISA::InstRetCounter:
+    return proc.getInstructionsRetired();
+  case RVISA::FirstHPMCounter:
+    return proc.getPerfEventCount(PerfEvent::TakenBranches);
+  case RVISA::FirstHPMCounter + 1:
+    return proc.getPerfEventCount(PerfEvent::StallCycles);
+  case RVISA::FirstHPMCounter + 2:
+    return proc.getPerfEventCount(PerfEvent::Flushes);
+  default:
+    return 0;
+  }
+}
+
+/// Returns the value of the CSR @p csr of @p proc.
+inline uint64_t rvReadCSR(const RipesProcessor &proc, unsigned csr) {
+  return RVISA::readCounterCSR(
+      csr, proc.implementsISA()->bits(),
+      [&](unsigned counter) { return rvCounterValue(proc, counter); });
+}
+
+} // namespace Ripes
+
+namespace vsrtl {
+namespace core {
+using namespace Ripes;
+
+/**
+ * @brief The CSRFile class
+ * Read port of the counter CSRs. The counters are maintained by the processor
+ * (see rvReadCSR), such that a CSR reads the state of the processor at the
+ * time the instruction is executed. Writes to CSRs are ignored.
+ */
+template <unsigned XLEN>
+class CSRFile : public Component {
+public:
+  CSRFile(const std::string &name, SimComponent *parent)
+      : Component(name, parent) {
+    setDescription("Counter CSRs");
+    out << [=] {
+      return m_proc ? VT_U(rvReadCSR(*m_proc, csr.uValue() & 0xFFF)) : VT_U(0);
+    };
+  }
+
+  void setProcessor(const RipesProcessor *proc) { m_proc = proc; }
+
+  INPUTPORT(csr, XLEN);
+  OUTPUTPORT(out, XLEN);
+
+private:
+  const RipesProcessor *m_proc = nullptr;
+};
+
+} // namespace core
+} // namespace vsrtl
@@ -0,0 +1,151 @@
+#pragma once
+
+#include <array>
+#include <memory>
+
+#include "VSRTL/core/vsrtl_component.h"
+
+#include "riscv.h"
+#include "rv_decodetable.h"
+
+namespace vsrtl {
+namespace core {
+using namespace Ripes;
+
+/// Returns the immediate encoded in the instruction word @p instr, which
+/// decodes to the instruction @p opc.
+template <unsigned XLEN>
+VSRTL_VT_U decodeImmediate(const VSRTL_VT_U &opc, const VSRTL_VT_U &instr) {
+  switch (opc) {
+  case RVInstr::LUI:
+  case RVInstr::AUIPC:
+    return VT_U(signextend<32>(instr & 0xfffff000));
+  case RVInstr::JAL: {
+    return VT_U(signextend<21>(((instr >> 31) & 0b1) << 20 |
+                               ((instr >> 21) & 0x3FF) << 1 |
+                               ((instr >> 20) & 0b1) << 11 |
+                               ((instr >> 12) & 0xFF) << 12));
+  }
+  case RVInstr::JALR: {
+    return VT_U(signextend<12>((instr >> 20)));
+  }
+  case RVInstr::BEQ:
+  case RVInstr::BNE:
+  case RVInstr::BLT:
+  case RVInstr::BGE:
+  case RVInstr::BLTU:
+  case RVInstr::BGEU: {
+    return VT_U(signextend<13>(((instr >> 31) & 0b1) << 12 |
+                               ((instr >> 25) & 0x3F) << 5 |
+                               ((instr >> 8) & 0xF) << 1 |
+                               ((instr >> 7) & 0b1) << 11));
+  }
+  case RVInstr::LB:
+  case RVInstr::LH:
+  case RVInstr::LW:
+  case RVInstr::LBU:
+  case RVInstr::LHU:
+  case RVInstr::LWU:
+  case RVInstr::LD:
+  case RVInstr::ADDI:
+  case RVInstr::SLTI:
+  case RVInstr::SLTIU:
+  case RVInstr::XORI:
+  case RVInstr::ORI:
+  case RVInstr::ANDI:
+  case RVInstr::ADDIW:
+    return VT_U(signextend<12>((instr >> 20)));
+  case RVInstr::SLLI:
+  case RVInstr::SRLI:
+  case RVInstr::SRAI: {
+    if constexpr (XLEN == 32) {
+      return VT_U((instr >> 20) & 0b11111);
+    } else {
+      return VT_U((instr >> 20) & 0b111111);
+    }
+  }
+  case RVInstr::SLLIW:
+  case RVInstr::SRLIW:
+  case RVInstr::SRAIW:
+    return VT_U((instr >> 20) & 0b11111);
+  case RVInstr::SB:
+  case RVInstr::SH:
+  case RVInstr::SW:
+  case RVInstr::SD: {
+    return VT_U(signextend<12>(((instr & 0xfe000000)) >> 20) |
+                ((instr & 0xf80) >> 7));
+  }
+  case RVInstr::CSRRW:
+  case RVInstr::CSRRS:
+  case RVInstr::CSRRC:
+  case RVInstr::CSRRWI:
+  case RVInstr::CSRRSI:
+  case RVInstr::CSRRCI:
+    // The CSR number
+    return VT_U((instr >> 20) & 0xFFF);
+  default:
+    return VT_U(0xDEADBEEF);
+  }
+}
+
+/**
+ * @brief The RVDecodeCache class
+ * Per-processor cache of decoded instruction words. Each entry holds the
+ * decoded instruction, its register indices and its immediate, such that an
+ * instruction word which is executed many times over (ie. in a loop) is only
+ * decoded once. The cache is shared by the decode and immediate components of
+ * a processor, including both ways of a dual-issue processor, and is
+ * direct-mapped on the instruction word.
+ */
+template <unsigned XLEN>
+class RVDecodeCache {
+public:
+  struct Entry {
+    bool valid = false;
+    uint32_t instr = 0;
+    VSRTL_VT_U opcode = RVInstr::NOP;
+    VSRTL_VT_U rd = 0;
+    VSRTL_VT_U rs1 = 0;
+    VSRTL_VT_U rs2 = 0;
+    VSRTL_VT_U imm = 0;
+  };
+
+  /// Selects the decode table of @p isa, and clears the cache.
+  void setISA(const std::shared_ptr<ISAInfoBase> &isa) {
+    if (isa && isa->extensionEnabled("M"))
+      m_decodeTable = &RVDecodeTable::get<XLEN, true>();
+    else
+      m_decodeTable = &RVDecodeTable::get<XLEN, false>();
+    m_entries.fill(Entry());
+  }
+
+  /// Returns the decoded fields of the instruction word @p instr.
+  const Entry &lookup(uint32_t instr) {
+    Entry &entry = m_entries[index(instr)];
+    if (!entry.valid || entry.instr != instr) {
+      entry.valid = true;
+      entry.instr = instr;
+      entry.opcode = m_decodeTable->decode(instr);
+      entry.rd = (instr >> 7) & 0b11111;
+      entry.rs1 = (instr >> 15) & 0b11111;
+      entry.rs2 = (instr >> 20) & 0b11111;
+      entry.imm = decodeImmediate<XLEN>(entry.opcode, instr);
+    }
+    return entry;
+  }
+
+private:
+  static constexpr unsigned s_indexBits = 10;
+
+  static unsigned index(uint32_t instr) {
+    // Fibonacci hashing, to spread instruction words which only differ in
+    // their upper bits.
+    return (instr * 2654435769u) >> (32 - s_indexBits);
+  }
+
+  const RVDecodeTable *m_decodeTable = &RVDecodeTable::get<XLEN, false>();
+  std::array<Entry, 1 << s_indexBits> m_entries;
+};
+
+} // namespace core
+} // namespace vsrtl
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "../../isa/rvinstrtable.h"
+#include "riscv.h"
+
+namespace Ripes {
+
+/**
+ * @brief The RVDecodeTable class
+ * Dense lookup table from 32-bit instruction words to RVInstr values, generated
+ * from the RISC-V instruction table (see isa/rvinstrtable.h). The table is
+ * indexed by all bits of an instruction word which may identify an
+ * instruction: opcode[6:2], funct3 and funct7. A table is specialized for each
+ * register width and set of enabled extensions, such that instructions which
+ * are not available in an ISA decode to RVInstr::NOP.
+ */
+class RVDecodeTable {
+public:
+  using Instr = decltype(RVInstr::NOP);
+
+  /// Returns the decode table of an XLEN-bit ISA, with or without the M
+  /// extension enabled.
+  template <unsigned XLEN, bool ExtM>
+  static const RVDecodeTable &get() {
+    static const RVDecodeTable table(XLEN, ExtM);
+    return table;
+  }
+
+  /// Returns the instruction encoded by @p instr, or RVInstr::NOP if the word
+  /// does not encode any instruction of the ISA.
+  Instr decode(uint32_t instr) const {
+    if ((instr & 0b11) != 0b11)
+      return RVInstr::NOP;
+    return static_cast<Instr>(m_table[index(instr)]);
+  }
+
+private:
+  static constexpr unsigned s_indexBits = 5 + 3 + 7;
+
+  static constexpr unsigned index(uint32_t instr) {
+    return ((instr >> 2) & 0b11111) | (((instr >> 12) & 0b111) << 5) |
+           ((instr >> 25) << 8);
+  }
+
+  /// Returns the instruction word with all identifying bits set as per
+  /// @p idx and all other bits cleared.
+  static constexpr uint32_t instrWord(unsigned idx) {
+    return 0b11 | ((idx & 0b11111) << 2) | (((idx >> 5) & 0b111) << 12) |
+           ((idx >> 8) << 25);
+  }
+
+  RVDecodeTable(unsigned xlen, bool extM) {
+#define RV_INSTR_ENUMERATOR(name, ...) RVInstr::name,
+    static constexpr Instr instrs[] = {RV_INSTRUCTIONS(RV_INSTR_ENUMERATOR)};
+#undef RV_INSTR_ENUMERATOR
+    static_assert(std::size(instrs) == std::size(RVISA::Instructions));
+
+    m_table.fill(static_cast<uint8_t>(RVInstr::NOP));
+    for (unsigned i = 0; i < std::size(instrs); ++i) {
+      const auto &enc = RVISA::Instructions[i];
+      if (!enc.availableIn(xlen, extM))
+        continue;
+      for (unsigned idx = 0; idx < m_table.size(); ++idx) {
+        if ((instrWord(idx) & enc.mask()) == enc.match())
+          m_table[idx] = static_cast<uint8_t>(instrs[i]);
+      }
+    }
+  }
+
+  std::array<uint8_t, 1 << s_indexBits> m_table;
+};
+
+} // namespace Ripes
@@ -0,0 +1,447 @@
+#pragma once
+
+#include <array>
+#include <climits>
+#include <cstdint>
+#include <type_traits>
+
+#include "../interface/ripesprocessor.h"
+#include "riscv.h"
+#include "rv_decodecache.h"
+#include "rv_decodetable.h"
+#include "rv_uncompress.h"
+
+namespace Ripes {
+
+/// Architectural state of a RISC-V hart.
+template <typename XLEN_T>
+struct RVHartState {
+  XLEN_T pc = 0;
+  std::array<XLEN_T, 32> regs{};
+};
+
+/// An instruction word, decoded into the fields which are required for
+/// executing it.
+template <typename XLEN_T>
+struct RVDecodedInstr {
+  RVDecodeTable::Instr opcode = RVInstr::NOP;
+  uint8_t rd = 0;
+  uint8_t rs1 = 0;
+  uint8_t rs2 = 0;
+  // Size of the instruction word in bytes; 2 for compressed instructions.
+  uint8_t size = 4;
+  // Whether the second operand of the instruction is its immediate rather
+  // than rs2.
+  bool immOperand = false;
+  XLEN_T imm = 0;
+};
+
+/// Side effects of executing an instruction, which the environment of the
+/// hart must act upon.
+struct RVExecResult {
+  // The instruction was an environment call; the trap has not been handled.
+  bool ecall = false;
+  // The instruction reads a CSR; the environment must write the value of CSR
+  // d.imm to d.rd. Writes to CSRs are ignored.
+  bool csr = false;
+  MemoryAccess dataAccess;
+};
+
+/**
+ * @brief The RVExecutor class
+ * Functional model of the RV32/64 IM(C) instruction set, executing decoded
+ * instructions directly on an RVHartState. In contrast to the VSRTL processor
+ * models, no datapath is simulated; each instruction is a single switch over
+ * its opcode.
+ *
+ * Memory accesses are performed through the @p Memory type, which must
+ * provide readMem(AInt, unsigned) and writeMem(AInt, VInt, int) as does
+ * vsrtl::core::AddressSpace.
+ */
+template <typename XLEN_T>
+class RVExecutor {
+  static_assert(std::is_same<uint32_t, XLEN_T>::value ||
+                    std::is_same<uint64_t, XLEN_T>::value,
+                "Only supports 32- and 64-bit variants");
+
+public:
+  static constexpr unsigned XLEN = sizeof(XLEN_T) * CHAR_BIT;
+  using SXLEN_T = std::make_signed_t<XLEN_T>;
+  using Instr = RVDecodeTable::Instr;
+  using Decoded = RVDecodedInstr<XLEN_T>;
+  using State = RVHartState<XLEN_T>;
+
+  /// Creates an executor for the ISA @p isa; only the M and C extensions of
+  /// the ISA are considered.
+  explicit RVExecutor(const ISAInfoBase *isa) {
+    if (isa->extensionEnabled("M"))
+      m_decodeTable = &RVDecodeTable::get<XLEN, true>();
+    if (isa->extensionEnabled("C"))
+      m_expansionTable = &RVCExpansionTable::get(isa->isaID());
+  }
+
+  /// Decodes the (possibly compressed) instruction word @p word.
+  Decoded decode(uint32_t word) const {
+    Decoded d;
+    if (m_expansionTable && (word & 0b11) != 0b11 && word != 0) {
+      d.size = 2;
+      word = static_cast<uint32_t>(m_expansionTable->expand(word));
+    }
+    d.opcode = m_decodeTable->decode(word);
+    d.rd = (word >> 7) & 0b11111;
+    d.rs1 = (word >> 15) & 0b11111;
+    d.rs2 = (word >> 20) & 0b11111;
+    d.immOperand = immOperand(d.opcode);
+    d.imm = static_cast<XLEN_T>(
+        vsrtl::core::decodeImmediate<XLEN>(d.opcode, word));
+    return d;
+  }
+
+  /// Fetches and decodes the instruction at @p address.
+  template <typename Memory>
+  Decoded fetch(Memory &mem, XLEN_T address) const {
+    return decode(static_cast<uint32_t>(mem.readMem(address, 4)));
+  }
+
+  /// Executes @p d on @p state, advancing its program counter.
+  template <typename Memory>
+  static RVExecResult execute(const Decoded &d, State &state, Memory &mem) {
+    RVExecResult res;
+    const XLEN_T pc = state.pc;
+    const XLEN_T op1 = state.regs[d.rs1];
+    const XLEN_T op2 = d.immOperand ? d.imm : state.regs[d.rs2];
+    XLEN_T nextPc = pc + d.size;
+    XLEN_T wrValue = 0;
+    bool wrEnable = true;
+
+    switch (d.opcode) {
+    case RVInstr::NOP:
+      wrEnable = false;
+      break;
+    case RVInstr::ECALL:
+      res.ecall = true;
+      wrEnable = false;
+      break;
+    case RVInstr::CSRRW:
+    case RVInstr::CSRRS:
+    case RVInstr::CSRRC:
+    case RVInstr::CSRRWI:
+    case RVInstr::CSRRSI:
+    case RVInstr::CSRRCI:
+      res.csr = true;
+      wrEnable = false;
+      break;
+    case RVInstr::LUI:
+      wrValue = d.imm;
+      break;
+    case RVInstr::AUIPC:
+      wrValue = pc + d.imm;
+      break;
+    case RVInstr::JAL:
+      wrValue = nextPc;
+      nextPc = pc + d.imm;
+      break;
+    case RVInstr::JALR:
+      wrValue = nextPc;
+      nextPc = (op1 + d.imm) & ~XLEN_T(1);
+      break;
+    case RVInstr::BEQ:
+    case RVInstr::BNE:
+    case RVInstr::BLT:
+    case RVInstr::BGE:
+    case RVInstr::BLTU:
+    case RVInstr::BGEU:
+      if (branchTaken(d.opcode, op1, op2))
+        nextPc = pc + d.imm;
+      wrEnable = false;
+      break;
+    case RVInstr::LB:
+    case RVInstr::LH:
+    case RVInstr::LW:
+    case RVInstr::LBU:
+    case RVInstr::LHU:
+    case RVInstr::LWU:
+    case RVInstr::LD: {
+      const XLEN_T address = op1 + d.imm;
+      const unsigned bytes = accessBytes(d.opcode);
+      wrValue = load(d.opcode, mem.readMem(address, bytes));
+      res.dataAccess = {MemoryAccess::Read, address, bytes};
+      break;
+    }
+    case RVInstr::SB:
+    case RVInstr::SH:
+    case RVInstr::SW:
+    case RVInstr::SD: {
+      const XLEN_T address = op1 + d.imm;
+      const unsigned bytes = accessBytes(d.opcode);
+      mem.writeMem(address, state.regs[d.rs2], bytes);
+      res.dataAccess = {MemoryAccess::Write, address, bytes};
+      wrEnable = false;
+      break;
+    }
+    default:
+      wrValue = compute(d.opcode, op1, op2);
+      break;
+    }
+
+    if (wrEnable && d.rd != 0)
+      state.regs[d.rd] = wrValue;
+    state.pc = nextPc;
+    return res;
+  }
+
+  /// Returns the program counter following the execution of @p d on
+  /// @p state, without executing it.
+  static XLEN_T nextPc(const Decoded &d, const State &state) {
+    const XLEN_T op1 = state.regs[d.rs1];
+    switch (d.opcode) {
+    case RVInstr::JAL:
+      return state.pc + d.imm;
+    case RVInstr::JALR:
+      return (op1 + d.imm) & ~XLEN_T(1);
+    case RVInstr::BEQ:
+    case RVInstr::BNE:
+    case RVInstr::BLT:
+    case RVInstr::BGE:
+    case RVInstr::BLTU:
+    case RVInstr::BGEU:
+      if (branchTaken(d.opcode, op1, state.regs[d.rs2]))
+        return state.pc + d.imm;
+      [[fallthrough]];
+    default:
+      return state.pc + d.size;
+    }
+  }
+
+  /// Computes the result of the arithmetic instruction @p opcode. The opcode
+  /// is a template argument, such that loops over many operands (ie. in
+  /// RVBatchExecutor) are specialized for a single operation.
+  template <Instr opcode>
+  static XLEN_T compute(XLEN_T a, XLEN_T b) {
+    constexpr XLEN_T shamtMask = XLEN - 1;
+    switch (opcode) {
+    case RVInstr::ADD:
+    case RVInstr::ADDI:
+      return a + b;
+    case RVInstr::SUB:
+      return a - b;
+    case RVInstr::SLL:
+    case RVInstr::SLLI:
+      return a << (b & shamtMask);
+    case RVInstr::SLT:
+    case RVInstr::SLTI:
+      return static_cast<SXLEN_T>(a) < static_cast<SXLEN_T>(b);
+    case RVInstr::SLTU:
+    case RVInstr::SLTIU:
+      return a < b;
+    case RVInstr::XOR:
+    case RVInstr::XORI:
+      return a ^ b;
+    case RVInstr::SRL:
+    case RVInstr::SRLI:
+      return a >> (b & shamtMask);
+    case RVInstr::SRA:
+    case RVInstr::SRAI:
+      return static_cast<SXLEN_T>(a) >> (b & shamtMask);
+    case RVInstr::OR:
+    case RVInstr::ORI:
+      return a | b;
+    case RVInstr::AND:
+    case RVInstr::ANDI:
+      return a & b;
+    case RVInstr::MUL:
+      return a * b;
+    case RVInstr::MULH:
+      return mulhu(a, b) - (static_cast<SXLEN_T>(a) < 0 ? b : 0) -
+             (static_cast<SXLEN_T>(b) < 0 ? a : 0);
+    case RVInstr::MULHSU:
+      return mulhu(a, b) - (static_cast<SXLEN_T>(a) < 0 ? b : 0);
+    case RVInstr::MULHU:
+      return mulhu(a, b);
+    case RVInstr::DIV:
+      return div(a, b);
+    case RVInstr::DIVU:
+      return divu(a, b);
+    case RVInstr::REM:
+      return rem(a, b);
+    case RVInstr::REMU:
+      return remu(a, b);
+
+    // RV64 word instructions operate on, and sign-extend, the lower 32 bits.
+    case RVInstr::ADDW:
+    case RVInstr::ADDIW:
+      return sext32(a + b);
+    case RVInstr::SUBW:
+      return sext32(a - b);
+    case RVInstr::SLLW:
+    case RVInstr::SLLIW:
+      return sext32(static_cast<uint32_t>(a) << (b & 0b11111));
+    case RVInstr::SRLW:
+    case RVInstr::SRLIW:
+      return sext32(static_cast<uint32_t>(a) >> (b & 0b11111));
+    case RVInstr::SRAW:
+    case RVInstr::SRAIW:
+      return sext32(static_cast<int32_t>(a) >> (b & 0b11111));
+    case RVInstr::MULW:
+      return sext32(static_cast<uint32_t>(a) * static_cast<uint32_t>(b));
+    case RVInstr::DIVW:
+      return sext32(div<uint32_t>(a, b));
+    case RVInstr::DIVUW:
+      return sext32(divu<uint32_t>(a, b));
+    case RVInstr::REMW:
+      return sext32(rem<uint32_t>(a, b));
+    case RVInstr::REMUW:
+      return sext32(remu<uint32_t>(a, b));
+    default:
+      return 0;
+    }
+  }
+
+  /// Computes the result of the arithmetic instruction @p opcode.
+  static XLEN_T compute(Instr opcode, XLEN_T a, XLEN_T b) {
+    switch (opcode) {
+#define RV_COMPUTE_CASE(name, ...)                                             \
+  case RVInstr::name:                                                          \
+    return compute<RVInstr::name>(a, b);
+      RV_INSTRUCTIONS(RV_COMPUTE_CASE)
+#undef RV_COMPUTE_CASE
+    default:
+      return 0;
+    }
+  }
+
+  /// Returns whether the branch instruction @p opcode is taken.
+  static bool branchTaken(Instr opcode, XLEN_T a, XLEN_T b) {
+    switch (opcode) {
+    case RVInstr::BEQ:
+      return a == b;
+    case RVInstr::BNE:
+      return a != b;
+    case RVInstr::BLT:
+      return static_cast<SXLEN_T>(a) < static_cast<SXLEN_T>(b);
+    case RVInstr::BGE:
+      return static_cast<SXLEN_T>(a) >= static_cast<SXLEN_T>(b);
+    case RVInstr::BLTU:
+      return a < b;
+    case RVInstr::BGEU:
+      return a >= b;
+    default:
+      return false;
+    }
+  }
+
+  /// Returns the number of bytes accessed by the load or store @p opcode.
+  static unsigned accessBytes(Instr opcode) {
+    switch (opcode) {
+    case RVInstr::LB:
+    case RVInstr::LBU:
+    case RVInstr::SB:
+      return 1;
+    case RVInstr::LH:
+    case RVInstr::LHU:
+    case RVInstr::SH:
+      return 2;
+    case RVInstr::LW:
+    case RVInstr::LWU:
+    case RVInstr::SW:
+      return 4;
+    default:
+      return 8;
+    }
+  }
+
+  /// Extends the loaded value @p value as per the load instruction @p opcode.
+  static XLEN_T load(Instr opcode, VInt value) {
+    switch (opcode) {
+    case RVInstr::LB:
+      return static_cast<SXLEN_T>(static_cast<int8_t>(value));
+    case RVInstr::LH:
+      return static_cast<SXLEN_T>(static_cast<int16_t>(value));
+    case RVInstr::LW:
+      return static_cast<SXLEN_T>(static_cast<int32_t>(value));
+    case RVInstr::LBU:
+      return static_cast<uint8_t>(value);
+    case RVInstr::LHU:
+      return static_cast<uint16_t>(value);
+    case RVInstr::LWU:
+      return static_cast<uint32_t>(value);
+    default:
+      return static_cast<XLEN_T>(value);
+    }
+  }
+
+  /// Returns whether the second operand of @p opcode is its immediate.
+  static bool immOperand(Instr opcode) {
+    switch (opcode) {
+    case RVInstr::ADDI:
+    case RVInstr::SLTI:
+    case RVInstr::SLTIU:
+    case RVInstr::XORI:
+    case RVInstr::ORI:
+    case RVInstr::ANDI:
+    case RVInstr::SLLI:
+    case RVInstr::SRLI:
+    case RVInstr::SRAI:
+    case RVInstr::ADDIW:
+    case RVInstr::SLLIW:
+    case RVInstr::SRLIW:
+    case RVInstr::SRAIW:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+private:
+  static XLEN_T sext32(uint32_t value) {
+    return static_cast<SXLEN_T>(static_cast<int32_t>(value));
+  }
+
+  /// Upper XLEN bits of the unsigned 2*XLEN-bit product of @p a and @p b.
+  static XLEN_T mulhu(XLEN_T a, XLEN_T b) {
+    if constexpr (XLEN == 32) {
+      return (static_cast<uint64_t>(a) * b) >> 32;
+    } else {
+      const uint64_t aLo = a & 0xFFFFFFFF, aHi = a >> 32;
+      const uint64_t bLo = b & 0xFFFFFFFF, bHi = b >> 32;
+      const uint64_t lh = aLo * bHi, hl = aHi * bLo;
+      const uint64_t mid =
+          ((aLo * bLo) >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+      return aHi * bHi + (lh >> 32) + (hl >> 32) + (mid >> 32);
+    }
+  }
+
+  // Division and remainder; division by zero and signed overflow yield the
+  // results mandated by the RISC-V specification rather than trapping.
+  template <typename T>
+  static T div(T a, T b) {
+    using S = std::make_signed_t<T>;
+    if (b == 0)
+      return ~T(0);
+    if (static_cast<S>(b) == -1)
+      return T(0) - a;
+    return static_cast<S>(a) / static_cast<S>(b);
+  }
+  template <typename T>
+  static T divu(T a, T b) {
+    return b == 0 ? ~T(0) : a / b;
+  }
+  template <typename T>
+  static T rem(T a, T b) {
+    using S = std::make_signed_t<T>;
+    if (b == 0)
+      return a;
+    if (static_cast<S>(b) == -1)
+      return 0;
+    return static_cast<S>(a) % static_cast<S>(b);
+  }
+  template <typename T>
+  static T remu(T a, T b) {
+    return b == 0 ? a : a % b;
+  }
+
+  const RVDecodeTable *m_decodeTable = &RVDecodeTable::get<XLEN, false>();
+  const RVCExpansionTable *m_expansionTable = nullptr;
+};
+
+} // namespace Ripes
@@ -0,0 +1,744 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "rv_codecache.h"
+#include "rv_executor.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define RIPES_RV_TRANSLATOR_HOST 1
+#else
+#define RIPES_RV_TRANSLATOR_HOST 0
+#endif
+
+namespace Ripes {
+
+/**
+ * @brief The X86Emitter class
+ * Encoder for the small subset of x86-64 instructions emitted by
+ * RVTranslator. Operations take a 64-bit flag; when unset, the 32-bit form of
+ * the operation is encoded, which zero-extends its result to 64 bits.
+ */
+class X86Emitter {
+public:
+  enum Reg : uint8_t {
+    RAX,
+    RCX,
+    RDX,
+    RBX,
+    RSP,
+    RBP,
+    RSI,
+    RDI,
+    R8,
+    R9,
+    R12 = 12
+  };
+  enum Cond : uint8_t {
+    B = 0x2,
+    AE = 0x3,
+    E = 0x4,
+    NE = 0x5,
+    L = 0xC,
+    GE = 0xD
+  };
+  enum AluOp : uint8_t {
+    ADD = 0x01,
+    OR = 0x09,
+    AND = 0x21,
+    SUB = 0x29,
+    XOR = 0x31,
+    CMP = 0x39
+  };
+  enum ShiftOp : uint8_t { SHL = 4, SHR = 5, SAR = 7 };
+
+  std::vector<uint8_t> &code() { return m_code; }
+  size_t size() const { return m_code.size(); }
+
+  void push(Reg r) {
+    rex(false, 0, r);
+    byte(0x50 + (r & 7));
+  }
+  void pop(Reg r) {
+    rex(false, 0, r);
+    byte(0x58 + (r & 7));
+  }
+  void ret() { byte(0xC3); }
+
+  /// dst = src
+  void mov(bool w, Reg dst, Reg src) {
+    rex(w, src, dst);
+    byte(0x89);
+    modrm(3, src, dst);
+  }
+  /// dst = imm
+  void movImm(Reg dst, uint64_t imm) {
+    if (imm <= UINT32_MAX) {
+      rex(false, 0, dst);
+      byte(0xB8 + (dst & 7));
+      imm32(static_cast<uint32_t>(imm));
+    } else {
+      rex(true, 0, dst);
+      byte(0xB8 + (dst & 7));
+      for (unsigned i = 0; i < 8; ++i)
+        byte(static_cast<uint8_t>(imm >> (i * 8)));
+    }
+  }
+  /// dst = [base + disp]
+  void load(bool w, Reg dst, Reg base, int32_t disp) {
+    rex(w, dst, base);
+    byte(0x8B);
+    modrm(2, dst, base);
+    imm32(static_cast<uint32_t>(disp));
+  }
+  /// [base + disp] = src
+  void store(bool w, Reg base, int32_t disp, Reg src) {
+    rex(w, src, base);
+    byte(0x89);
+    modrm(2, src, base);
+    imm32(static_cast<uint32_t>(disp));
+  }
+  /// dst = dst <op> src
+  void alu(AluOp op, bool w, Reg dst, Reg src) {
+    rex(w, src, dst);
+    byte(op);
+    modrm(3, src, dst);
+  }
+  /// dst = dst <op> cl
+  void shift(ShiftOp op, bool w, Reg dst) {
+    rex(w, 0, dst);
+    byte(0xD3);
+    modrm(3, op, dst);
+  }
+  /// dst = dst & imm
+  void andImm8(bool w, Reg dst, int8_t imm) {
+    rex(w, 0, dst);
+    byte(0x83);
+    modrm(3, 4, dst);
+    byte(static_cast<uint8_t>(imm));
+  }
+  /// rsp = rsp +/- imm
+  void addRsp(int8_t imm) {
+    rex(true, 0, RSP);
+    byte(0x83);
+    modrm(3, imm < 0 ? 5 : 0, RSP);
+    byte(static_cast<uint8_t>(imm < 0 ? -imm : imm));
+  }
+  /// dst = dst * src
+  void imul(bool w, Reg dst, Reg src) {
+    rex(w, dst, src);
+    byte(0x0F);
+    byte(0xAF);
+    modrm(3, dst, src);
+  }
+  /// rax = sign-extend(eax)
+  void movsxdRaxEax() {
+    byte(0x48);
+    byte(0x63);
+    byte(0xC0);
+  }
+  /// rax = <cond> ? 1 : 0
+  void setccRax(Cond cc) {
+    byte(0x0F);
+    byte(0x90 + cc);
+    byte(0xC0);
+    // movzx eax, al
+    byte(0x0F);
+    byte(0xB6);
+    byte(0xC0);
+  }
+  /// dst = <cond> ? src : dst
+  void cmov(Cond cc, Reg dst, Reg src) {
+    rex(true, dst, src);
+    byte(0x0F);
+    byte(0x40 + cc);
+    modrm(3, dst, src);
+  }
+  void testEaxEax() {
+    byte(0x85);
+    byte(0xC0);
+  }
+  void callRax() {
+    byte(0xFF);
+    byte(0xD0);
+  }
+  /// Emits a forward jz with an unresolved target; returns the patch offset.
+  size_t jz() {
+    byte(0x0F);
+    byte(0x84);
+    imm32(0);
+    return m_code.size();
+  }
+  /// Resolves the forward jump with patch offset @p at to the current offset.
+  void bind(size_t at) {
+    const uint32_t rel = static_cast<uint32_t>(m_code.size() - at);
+    for (unsigned i = 0; i < 4; ++i)
+      m_code[at - 4 + i] = static_cast<uint8_t>(rel >> (i * 8));
+  }
+
+private:
+  void byte(uint8_t b) { m_code.push_back(b); }
+  void imm32(uint32_t v) {
+    for (unsigned i = 0; i < 4; ++i)
+      byte(static_cast<uint8_t>(v >> (i * 8)));
+  }
+  void rex(bool w, unsigned reg, unsigned rm) {
+    const uint8_t r = 0x40 | (w << 3) | ((reg >> 3) << 2) | (rm >> 3);
+    if (r != 0x40)
+      byte(r);
+  }
+  void modrm(unsigned mod, unsigned reg, unsigned rm) {
+    byte(static_cast<uint8_t>((mod << 6) | ((reg & 7) << 3) | (rm & 7)));
+  }
+
+  std::vector<uint8_t> m_code;
+};
+
+/**
+ * @brief The RVTranslator class
+ * Dynamic binary translator from RISC-V to x86-64, layered on top of
+ * RVExecutor. The translator counts how often each program counter is
+ * reached through interpretation; once a program counter turns hot, the basic
+ * block starting at it is translated to host code and placed in an
+ * RVCodeCache. Subsequent executions of the block run the host code directly
+ * on the RVHartState.
+ *
+ * Arithmetic instructions are translated to native code, while loads, stores
+ * and infrequent operations (ie. division) call back into the translator.
+ * Control flow instructions terminate a block, and ecalls are never
+ * translated, such that traps are always handled by the interpreter.
+ *
+ * Translations are invalidated whenever memory which they were translated
+ * from is written: stores within translated code are checked by the
+ * translator itself, stores which are interpreted must be reported through
+ * notifyWrite(), and any other modification of memory (ie. by syscalls) must
+ * be reported through notifyExternalWrite(), after which blocks are
+ * revalidated against memory before being executed again.
+ *
+ * Translation is only supported on x86-64 hosts; elsewhere, run() never
+ * executes any instructions and all instructions are interpreted.
+ */
+template <typename XLEN_T, typename Memory>
+class RVTranslator {
+  using Exec = RVExecutor<XLEN_T>;
+  using Instr = typename Exec::Instr;
+  using Decoded = typename Exec::Decoded;
+  using State = typename Exec::State;
+  using Reg = X86Emitter::Reg;
+  using BlockFn = uint64_t (*)(State *, RVTranslator *);
+
+  static constexpr bool W = sizeof(XLEN_T) == 8;
+  // Number of executions after which a program counter is translated.
+  static constexpr unsigned s_hotThreshold = 32;
+  static constexpr unsigned s_maxBlockInstructions = 64;
+  static constexpr size_t s_cacheSize = 16 * 1024 * 1024;
+  static constexpr unsigned s_pageBits = 12;
+  // Hotness count of program counters which cannot be translated.
+  static constexpr unsigned s_untranslatable = UINT32_MAX;
+
+public:
+  static constexpr bool supported = RIPES_RV_TRANSLATOR_HOST;
+  using IsExecutable = std::function<bool(AInt)>;
+
+  RVTranslator(const Exec &executor, IsExecutable isExecutable)
+      : m_executor(executor), m_isExecutable(std::move(isExecutable)) {}
+
+  /// Executes the translated block at the program counter of @p state,
+  /// translating it if it has turned hot. Returns the number of executed
+  /// instructions; if 0, the instruction at the program counter must be
+  /// interpreted.
+  unsigned run(State &state, Memory &mem) {
+    if constexpr (!supported) {
+      return 0;
+    } else {
+      if (!m_cache.valid())
+        return 0;
+      m_memory = &mem;
+      auto it = m_blocks.find(state.pc);
+      if (it == m_blocks.end()) {
+        unsigned &hotness = m_hotness[state.pc];
+        if (hotness == s_untranslatable || ++hotness < s_hotThreshold)
+          return 0;
+        it = translate(state.pc);
+        if (it == m_blocks.end()) {
+          hotness = s_untranslatable;
+          return 0;
+        }
+      } else if (it->second.epoch !=
+                 m_epoch.load(std::memory_order_relaxed)) {
+        if (!revalidate(it->second)) {
+          invalidate(it);
+          return 0;
+        }
+      }
+      // The block may be invalidated by its own stores while running.
+      const Decoded exit = it->second.exit;
+      const size_t size = it->second.words.size();
+      const unsigned n = static_cast<unsigned>(it->second.fn(&state, this));
+      // A terminating branch does not write registers, so its operands are
+      // still present in the hart state.
+      m_branchTaken = n == size && Exec::branchTaken(exit.opcode,
+                                                     state.regs[exit.rs1],
+                                                     state.regs[exit.rs2]);
+      return n;
+    }
+  }
+
+  /// Returns whether the block executed by the most recent call to run()
+  /// ended in a taken branch.
+  bool branchTaken() const { return m_branchTaken; }
+
+  /// Reports an interpreted store of @p bytes bytes to @p address. Returns
+  /// whether any translations were invalidated.
+  bool notifyWrite(AInt address, unsigned bytes) {
+    if (m_pages.empty())
+      return false;
+    const AInt first = address >> s_pageBits;
+    const AInt last = (address + bytes - 1) >> s_pageBits;
+    bool invalidated = false;
+    for (AInt page = first; page <= last; ++page) {
+      if (m_pages.count(page) != 0) {
+        invalidatePage(page);
+        invalidated = true;
+      }
+    }
+    return invalidated;
+  }
+
+  /// Reports that memory may have been modified outside of the executed
+  /// program. May be called from any thread.
+  void notifyExternalWrite() {
+    m_epoch.fetch_add(1, std::memory_order_release);
+  }
+
+  /// Discards all translations and profiling information.
+  void clear() {
+    m_blocks.clear();
+    m_pages.clear();
+    m_hotness.clear();
+    m_cache.clear();
+  }
+
+private:
+  struct Block {
+    BlockFn fn;
+    XLEN_T start;
+    XLEN_T end;
+    // Instruction words which the block was translated from.
+    std::vector<std::pair<XLEN_T, uint32_t>> words;
+    uint64_t epoch;
+    // The control flow instruction terminating the block, if any.
+    Decoded exit;
+  };
+  using BlockMap = std::unordered_map<XLEN_T, Block>;
+
+  bool revalidate(Block &block) {
+    // The epoch is read first, such that writes concurrent with the check are
+    // caught by the next one.
+    const uint64_t epoch = m_epoch.load(std::memory_order_acquire);
+    for (const auto &[address, word] : block.words) {
+      if (static_cast<uint32_t>(m_memory->readMem(address, 4)) != word)
+        return false;
+    }
+    block.epoch = epoch;
+    return true;
+  }
+
+  typename BlockMap::iterator invalidate(typename BlockMap::iterator it) {
+    const Block &block = it->second;
+    for (AInt page = block.start >> s_pageBits;
+         page <= (AInt(block.end) - 1) >> s_pageBits; ++page) {
+      auto pageIt = m_pages.find(page);
+      if (--pageIt->second == 0)
+        m_pages.erase(pageIt);
+    }
+    // The block may be translated anew once it turns hot again.
+    m_hotness.erase(block.start);
+    return m_blocks.erase(it);
+  }
+
+  void invalidatePage(AInt page) {
+    for (auto it = m_blocks.begin(); it != m_blocks.end();) {
+      const Block &block = it->second;
+      if ((block.start >> s_pageBits) <= page &&
+          page <= ((AInt(block.end) - 1) >> s_pageBits))
+        it = invalidate(it);
+      else
+        ++it;
+    }
+  }
+
+  // Callbacks from translated code.
+  static uint64_t loadCallback(RVTranslator *self, uint64_t address,
+                               uint64_t opcode) {
+    const auto op = static_cast<Instr>(opcode);
+    return Exec::load(op, self->m_memory->readMem(static_cast<XLEN_T>(address),
+                                                  Exec::accessBytes(op)));
+  }
+  static uint64_t storeCallback(RVTranslator *self, uint64_t address,
+                                uint64_t value, uint64_t opcode) {
+    const unsigned bytes = Exec::accessBytes(static_cast<Instr>(opcode));
+    self->m_memory->writeMem(static_cast<XLEN_T>(address), value, bytes);
+    return self->notifyWrite(static_cast<XLEN_T>(address), bytes);
+  }
+  static uint64_t computeCallback(uint64_t opcode, uint64_t a, uint64_t b) {
+    return Exec::compute(static_cast<Instr>(opcode), static_cast<XLEN_T>(a),
+                         static_cast<XLEN_T>(b));
+  }
+
+  // Translated blocks are called as BlockFn. rbx holds the hart state and r12
+  // the translator throughout the block.
+#ifdef _WIN32
+  static constexpr Reg s_args[] = {Reg::RCX, Reg::RDX, Reg::R8, Reg::R9};
+  // Shadow space for callbacks, and alignment of the stack to 16 bytes.
+  static constexpr int8_t s_frameSize = 40;
+#else
+  static constexpr Reg s_args[] = {Reg::RDI, Reg::RSI, Reg::RDX, Reg::RCX};
+  static constexpr int8_t s_frameSize = 8;
+#endif
+
+  static int32_t regOffset(unsigned i) {
+    return static_cast<int32_t>(offsetof(State, regs) + i * sizeof(XLEN_T));
+  }
+  static int32_t pcOffset() { return offsetof(State, pc); }
+
+  void loadReg(Reg dst, unsigned i) {
+    m_emit.load(W, dst, Reg::RBX, regOffset(i));
+  }
+  void storeRax(unsigned rd) {
+    if (rd != 0)
+      m_emit.store(W, Reg::RBX, regOffset(rd), Reg::RAX);
+  }
+  void storePc(Reg src) { m_emit.store(W, Reg::RBX, pcOffset(), src); }
+  void call(const void *fn) {
+    m_emit.movImm(Reg::RAX, reinterpret_cast<uint64_t>(fn));
+    m_emit.callRax();
+  }
+
+  void emitPrologue() {
+    m_emit.push(Reg::RBX);
+    m_emit.push(Reg::R12);
+    m_emit.addRsp(-s_frameSize);
+    m_emit.mov(true, Reg::RBX, s_args[0]);
+    m_emit.mov(true, Reg::R12, s_args[1]);
+  }
+  /// Exits the block with @p pc as the next program counter, having executed
+  /// @p count instructions.
+  void emitExit(XLEN_T pc, unsigned count) {
+    m_emit.movImm(Reg::RAX, pc);
+    storePc(Reg::RAX);
+    m_emit.movImm(Reg::RAX, count);
+    m_emit.addRsp(s_frameSize);
+    m_emit.pop(Reg::R12);
+    m_emit.pop(Reg::RBX);
+    m_emit.ret();
+  }
+
+  /// rax = rs1, rcx = rs2 or immediate.
+  void emitOperands(const Decoded &d) {
+    loadReg(Reg::RAX, d.rs1);
+    if (d.immOperand)
+      m_emit.movImm(Reg::RCX, d.imm);
+    else
+      loadReg(Reg::RCX, d.rs2);
+  }
+
+  /// rax = rs1 + imm
+  void emitAddress(const Decoded &d) {
+    loadReg(Reg::RAX, d.rs1);
+    m_emit.movImm(Reg::RCX, d.imm);
+    m_emit.alu(X86Emitter::ADD, W, Reg::RAX, Reg::RCX);
+  }
+
+  /// Emits the arithmetic instruction @p d, leaving its result in rax.
+  void emitCompute(const Decoded &d) {
+    emitOperands(d);
+    switch (d.opcode) {
+    case RVInstr::ADD:
+    case RVInstr::ADDI:
+      return m_emit.alu(X86Emitter::ADD, W, Reg::RAX, Reg::RCX);
+    case RVInstr::SUB:
+      return m_emit.alu(X86Emitter::SUB, W, Reg::RAX, Reg::RCX);
+    case RVInstr::XOR:
+    case RVInstr::XORI:
+      return m_emit.alu(X86Emitter::XOR, W, Reg::RAX, Reg::RCX);
+    case RVInstr::OR:
+    case RVInstr::ORI:
+      return m_emit.alu(X86Emitter::OR, W, Reg::RAX, Reg::RCX);
+    case RVInstr::AND:
+    case RVInstr::ANDI:
+      return m_emit.alu(X86Emitter::AND, W, Reg::RAX, Reg::RCX);
+    // x86 masks shift amounts to the operand width, as does RISC-V.
+    case RVInstr::SLL:
+    case RVInstr::SLLI:
+      return m_emit.shift(X86Emitter::SHL, W, Reg::RAX);
+    case RVInstr::SRL:
+    case RVInstr::SRLI:
+      return m_emit.shift(X86Emitter::SHR, W, Reg::RAX);
+    case RVInstr::SRA:
+    case RVInstr::SRAI:
+      return m_emit.shift(X86Emitter::SAR, W, Reg::RAX);
+    case RVInstr::SLT:
+    case RVInstr::SLTI:
+      m_emit.alu(X86Emitter::CMP, W, Reg::RAX, Reg::RCX);
+      return m_emit.setccRax(X86Emitter::L);
+    case RVInstr::SLTU:
+    case RVInstr::SLTIU:
+      m_emit.alu(X86Emitter::CMP, W, Reg::RAX, Reg::RCX);
+      return m_emit.setccRax(X86Emitter::B);
+    case RVInstr::MUL:
+      return m_emit.imul(W, Reg::RAX, Reg::RCX);
+    case RVInstr::ADDW:
+    case RVInstr::ADDIW:
+      m_emit.alu(X86Emitter::ADD, false, Reg::RAX, Reg::RCX);
+      return m_emit.movsxdRaxEax();
+    case RVInstr::SUBW:
+      m_emit.alu(X86Emitter::SUB, false, Reg::RAX, Reg::RCX);
+      return m_emit.movsxdRaxEax();
+    case RVInstr::SLLW:
+    case RVInstr::SLLIW:
+      m_emit.shift(X86Emitter::SHL, false, Reg::RAX);
+      return m_emit.movsxdRaxEax();
+    case RVInstr::SRLW:
+    case RVInstr::SRLIW:
+      m_emit.shift(X86Emitter::SHR, false, Reg::RAX);
+      return m_emit.movsxdRaxEax();
+    case RVInstr::SRAW:
+    case RVInstr::SRAIW:
+      m_emit.shift(X86Emitter::SAR, false, Reg::RAX);
+      return m_emit.movsxdRaxEax();
+    case RVInstr::MULW:
+      m_emit.imul(false, Reg::RAX, Reg::RCX);
+      return m_emit.movsxdRaxEax();
+    default:
+      // Operations without a native translation are computed by RVExecutor.
+      m_emit.mov(true, s_args[1], Reg::RAX);
+      m_emit.mov(true, s_args[2], Reg::RCX);
+      m_emit.movImm(s_args[0], d.opcode);
+      return call(reinterpret_cast<const void *>(&computeCallback));
+    }
+  }
+
+  void emitLoad(const Decoded &d) {
+    emitAddress(d);
+    m_emit.mov(true, s_args[1], Reg::RAX);
+    m_emit.mov(true, s_args[0], Reg::R12);
+    m_emit.movImm(s_args[2], d.opcode);
+    call(reinterpret_cast<const void *>(&loadCallback));
+    storeRax(d.rd);
+  }
+
+  /// Emits the store @p d at @p pc. If the store invalidates any translation,
+  /// the block is exited, given that it may itself have been invalidated.
+  void emitStore(const Decoded &d, XLEN_T pc, unsigned count) {
+    emitAddress(d);
+    loadReg(Reg::RCX, d.rs2);
+    // Arguments are assigned such that no source register is overwritten
+    // before being read; on Win64, rcx is both the value and the first
+    // argument.
+    m_emit.mov(true, s_args[1], Reg::RAX);
+    m_emit.mov(true, s_args[2], Reg::RCX);
+    m_emit.mov(true, s_args[0], Reg::R12);
+    m_emit.movImm(s_args[3], d.opcode);
+    call(reinterpret_cast<const void *>(&storeCallback));
+    m_emit.testEaxEax();
+    const size_t cont = m_emit.jz();
+    emitExit(pc + d.size, count);
+    m_emit.bind(cont);
+  }
+
+  /// Emits the control flow instruction @p d at @p pc, which terminates the
+  /// block.
+  void emitControlFlow(const Decoded &d, XLEN_T pc, unsigned count) {
+    const XLEN_T next = pc + d.size;
+    switch (d.opcode) {
+    case RVInstr::JAL:
+      m_emit.movImm(Reg::RAX, next);
+      storeRax(d.rd);
+      return emitExit(pc + d.imm, count);
+    case RVInstr::JALR:
+      // rs1 is read before rd is written, since they may be the same.
+      emitAddress(d);
+      m_emit.andImm8(W, Reg::RAX, -2);
+      m_emit.mov(true, Reg::RDX, Reg::RAX);
+      m_emit.movImm(Reg::RAX, next);
+      storeRax(d.rd);
+      storePc(Reg::RDX);
+      break;
+    default: {
+      X86Emitter::Cond cc;
+      switch (d.opcode) {
+      case RVInstr::BEQ:
+        cc = X86Emitter::E;
+        break;
+      case RVInstr::BNE:
+        cc = X86Emitter::NE;
+        break;
+      case RVInstr::BLT:
+        cc = X86Emitter::L;
+        break;
+      case RVInstr::BGE:
+        cc = X86Emitter::GE;
+        break;
+      case RVInstr::BLTU:
+        cc = X86Emitter::B;
+        break;
+      default:
+        cc = X86Emitter::AE;
+        break;
+      }
+      loadReg(Reg::RAX, d.rs1);
+      loadReg(Reg::RCX, d.rs2);
+      m_emit.alu(X86Emitter::CMP, W, Reg::RAX, Reg::RCX);
+      // Moves do not affect the flags set by the comparison.
+      m_emit.movImm(Reg::RAX, next);
+      m_emit.movImm(Reg::RDX, static_cast<XLEN_T>(pc + d.imm));
+      m_emit.cmov(cc, Reg::RAX, Reg::RDX);
+      storePc(Reg::RAX);
+      break;
+    }
+    }
+    m_emit.movImm(Reg::RAX, count);
+    m_emit.addRsp(s_frameSize);
+    m_emit.pop(Reg::R12);
+    m_emit.pop(Reg::RBX);
+    m_emit.ret();
+  }
+
+  static bool isControlFlow(Instr opcode) {
+    switch (opcode) {
+    case RVInstr::JAL:
+    case RVInstr::JALR:
+    case RVInstr::BEQ:
+    case RVInstr::BNE:
+    case RVInstr::BLT:
+    case RVInstr::BGE:
+    case RVInstr::BLTU:
+    case RVInstr::BGEU:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  static bool isCSRAccess(Instr opcode) {
+    switch (opcode) {
+    case RVInstr::CSRRW:
+    case RVInstr::CSRRS:
+    case RVInstr::CSRRC:
+    case RVInstr::CSRRWI:
+    case RVInstr::CSRRSI:
+    case RVInstr::CSRRCI:
+      return true;
+    default:
+      return false;
+    }
+  }
+
+  /// Translates the basic block starting at @p start. Returns m_blocks.end()
+  /// if no instruction of the block could be translated.
+  typename BlockMap::iterator translate(XLEN_T start) {
+    m_emit = X86Emitter();
+    emitPrologue();
+    Block block{nullptr, start, start, {},
+                m_epoch.load(std::memory_order_relaxed), {}};
+    XLEN_T pc = start;
+    unsigned count = 0;
+    bool terminated = false;
+    while (count < s_maxBlockInstructions && m_isExecutable(pc)) {
+      const uint32_t word = static_cast<uint32_t>(m_memory->readMem(pc, 4));
+      const Decoded d = m_executor.decode(word);
+      // Traps, CSR accesses and illegal instructions are left to the
+      // interpreter.
+      if (d.opcode == RVInstr::ECALL || d.opcode == RVInstr::NOP ||
+          isCSRAccess(d.opcode))
+        break;
+      block.words.push_back({pc, word});
+      count++;
+      switch (d.opcode) {
+      case RVInstr::LUI:
+        m_emit.movImm(Reg::RAX, d.imm);
+        storeRax(d.rd);
+        break;
+      case RVInstr::AUIPC:
+        m_emit.movImm(Reg::RAX, static_cast<XLEN_T>(pc + d.imm));
+        storeRax(d.rd);
+        break;
+      case RVInstr::LB:
+      case RVInstr::LH:
+      case RVInstr::LW:
+      case RVInstr::LBU:
+      case RVInstr::LHU:
+      case RVInstr::LWU:
+      case RVInstr::LD:
+        emitLoad(d);
+        break;
+      case RVInstr::SB:
+      case RVInstr::SH:
+      case RVInstr::SW:
+      case RVInstr::SD:
+        emitStore(d, pc, count);
+        break;
+      default:
+        if (isControlFlow(d.opcode)) {
+          emitControlFlow(d, pc, count);
+          block.exit = d;
+          terminated = true;
+        } else {
+          emitCompute(d);
+          storeRax(d.rd);
+        }
+        break;
+      }
+      pc += d.size;
+      if (terminated)
+        break;
+    }
+    if (count == 0)
+      return m_blocks.end();
+    if (!terminated)
+      emitExit(pc, count);
+    // The block spans up to the end of its last fetched instruction word.
+    block.end = block.words.back().first + 4;
+
+    const void *code = m_cache.add(m_emit.code());
+    if (!code) {
+      // The code cache is full; start over.
+      m_blocks.clear();
+      m_pages.clear();
+      m_cache.clear();
+      code = m_cache.add(m_emit.code());
+      if (!code)
+        return m_blocks.end();
+    }
+    block.fn = reinterpret_cast<BlockFn>(const_cast<void *>(code));
+    for (AInt page = start >> s_pageBits;
+         page <= (AInt(block.end) - 1) >> s_pageBits; ++page)
+      m_pages[page]++;
+    return m_blocks.emplace(start, std::move(block)).first;
+  }
+
+  const Exec &m_executor;
+  IsExecutable m_isExecutable;
+  Memory *m_memory = nullptr;
+  RVCodeCache m_cache{s_cacheSize};
+  X86Emitter m_emit;
+
+  BlockMap m_blocks;
+  std::unordered_map<XLEN_T, unsigned> m_hotness;
+  // Number of translated blocks within each page of memory.
+  std::unordered_map<AInt, unsigned> m_pages;
+  // Incremented on external writes, which may be reported from other threads
+  // (ie. by peripherals); blocks translated or validated at an earlier epoch
+  // are revalidated before being executed.
+  std::atomic<uint64_t> m_epoch{0};
+  bool m_branchTaken = false;
+};
+
+} // namespace Ripes
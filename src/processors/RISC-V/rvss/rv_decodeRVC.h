@@ -17,6 +17,11 @@ public:
     uncompress->setISA(isa);
   }
 
+  /// Sets the decode cache of the processor which this component is part of.
+  void setDecodeCache(const std::shared_ptr<RVDecodeCache<XLEN>> &cache) {
+    decode->setDecodeCache(cache);
+  }
+
   DecodeRVC(std::string name, SimComponent *parent) : Component(name, parent) {
     instr >> uncompress->instr;
 
@@ -12,6 +12,7 @@
 #include "../rv_alu.h"
 #include "../rv_branch.h"
 #include "../rv_control.h"
+#include "../rv_csrfile.h"
 #include "../rv_ecallchecker.h"
 #include "../rv_immediate.h"
 #include "../rv_memory.h"
@@ -33,6 +34,8 @@ public:
   RVSS(const QStringList &extensions)
       : RipesVSRTLProcessor("Single Cycle RISC-V Processor") {
     m_enabledISA = std::make_shared<ISAInfo<XLenToRVISA<XLEN>()>>(extensions);
+    decode->setDecodeCache(m_decodeCache);
+    immediate->setDecodeCache(m_decodeCache);
     decode->setISA(m_enabledISA);
 
     // -----------------------------------------------------------------------
@@ -104,6 +107,7 @@ public:
 
     registerFile->r2_out >> alu_op2_src->get(AluSrc2::REG2);
     immediate->imm >> alu_op2_src->get(AluSrc2::IMM);
+    csrFile->out >> alu_op2_src->get(AluSrc2::CSR);
     control->alu_op2_ctrl >> alu_op2_src->select;
 
     alu_op1_src->out >> alu->op1;
@@ -111,6 +115,11 @@ public:
 
     control->alu_ctrl >> alu->ctrl;
 
+    // -----------------------------------------------------------------------
+    // CSRs
+    immediate->imm >> csrFile->csr;
+    csrFile->setProcessor(this);
+
     // -----------------------------------------------------------------------
     // Data memory
     alu->res >> data_mem->addr;
@@ -134,6 +143,7 @@ public:
   SUBCOMPONENT(decode, TYPE(DecodeRVC<XLEN>));
   SUBCOMPONENT(branch, TYPE(Branch<XLEN>));
   SUBCOMPONENT(pc_4, Adder<XLEN>);
+  SUBCOMPONENT(csrFile, TYPE(CSRFile<XLEN>));
 
   // Registers
   SUBCOMPONENT(pc_reg, Register<XLEN>);
@@ -211,6 +221,8 @@ public:
   void clockProcessor() override {
     // Single cycle processor; 1 instruction retired per cycle!
     m_instructionsRetired++;
+    if (br_and->out.uValue())
+      countPerfEvent(PerfEvent::TakenBranches);
 
     // m_finishInNextCycle may be set during Design::clock(). Store the value
     // before clocking the processor, and emit finished if this was the final
@@ -225,6 +237,8 @@ public:
   void reverse() override {
     m_instructionsRetired--;
     Design::reverse();
+    if (br_and->out.uValue())
+      countPerfEvent(PerfEvent::TakenBranches, -1);
     // Ensure that reverses performed when we expected to finish in the
     // following cycle, clears this expectation.
     m_finishInNextCycle = false;
@@ -261,6 +275,8 @@ private:
   bool m_finishInNextCycle = false;
   bool m_finished = false;
   std::shared_ptr<ISAInfoBase> m_enabledISA;
+  std::shared_ptr<RVDecodeCache<XLEN>> m_decodeCache =
+      std::make_shared<RVDecodeCache<XLEN>>();
   ProcessorStructure m_structure = {{0, 1}};
 };
 
@@ -0,0 +1,209 @@
+#pragma once
+
+#include "VSRTL/core/vsrtl_addressspace.h"
+
+#include "../../interface/ripesprocessor.h"
+
+#include "../riscv.h"
+#include "../rv_csrfile.h"
+#include "../rv_executor.h"
+#include "../rv_translator.h"
+
+namespace Ripes {
+
+/**
+ * @brief The RVSSCompiled class
+ * Compiled model of the single cycle processor (vsrtl::core::RVSS). Whereas
+ * RVSS evaluates its VSRTL circuit component by component, this model
+ * executes each instruction as a single function over the architectural
+ * state, through RVExecutor. Given that RVSS retires exactly one instruction
+ * per cycle, the two models are cycle-equivalent.
+ *
+ * The model is intended for headless simulation; it cannot be visualized nor
+ * reversed. Data and instruction memory accesses refer to the most recently
+ * executed instruction.
+ *
+ * If constructed with @p translate set, hot basic blocks are translated to host
+ * machine code through RVTranslator (on x86-64 hosts only). A clock cycle then
+ * executes an entire translated block, such that breakpoints only trigger at
+ * block boundaries, and memory accesses of translated instructions are not
+ * reported.
+ */
+template <typename XLEN_T>
+class RVSSCompiled : public RipesProcessor {
+  static constexpr unsigned XLEN = sizeof(XLEN_T) * CHAR_BIT;
+
+public:
+  static constexpr bool supportsTranslation = true;
+
+  RVSSCompiled(const QStringList &extensions, bool translate = false)
+      : m_enabledISA(
+            std::make_shared<ISAInfo<XLenToRVISA<XLEN>()>>(extensions)),
+        m_executor(m_enabledISA.get()) {
+    m_features = Features::hasDCacheInterface | Features::hasICacheInterface;
+    if (translate && Translator::supported) {
+      m_translator = std::make_unique<Translator>(
+          m_executor, [this](AInt address) {
+            return isExecutableAddress && isExecutableAddress(address);
+          });
+    }
+  }
+
+  static ProcessorISAInfo supportsISA() {
+    return ProcessorISAInfo{
+        std::make_shared<ISAInfo<XLenToRVISA<XLEN>()>>(QStringList()),
+        {"M", "C"},
+        {"M"}};
+  }
+  const ISAInfoBase *implementsISA() const override {
+    return m_enabledISA.get();
+  }
+  const std::set<RegisterFileType> registerFiles() const override {
+    return {RegisterFileType::GPR};
+  }
+
+  const ProcessorStructure &structure() const override { return m_structure; }
+  unsigned int getPcForStage(StageIndex) const override { return m_state.pc; }
+  AInt nextFetchedAddress() const override {
+    return RVExecutor<XLEN_T>::nextPc(
+        m_executor.fetch(*m_memory, m_state.pc), m_state);
+  }
+  QString stageName(StageIndex) const override { return "•"; }
+  StageInfo stageInfo(StageIndex) const override {
+    return StageInfo({m_state.pc, isExecutableAddress(m_state.pc),
+                      StageInfo::State::None});
+  }
+  const std::vector<StageIndex> breakpointTriggeringStages() const override {
+    return {{0, 0}};
+  }
+
+  vsrtl::core::AddressSpaceMM &getMemory() override { return *m_memory; }
+  void memoryWritten(AInt, size_t) override {
+    // Translations are checked against memory before they next execute.
+    if (m_translator)
+      m_translator->notifyExternalWrite();
+  }
+  MemoryAccess dataMemAccess() const override { return m_dataAccess; }
+  MemoryAccess instrMemAccess() const override { return m_instrAccess; }
+
+  VInt getRegister(RegisterFileType, unsigned i) const override {
+    return m_state.regs.at(i);
+  }
+  void setRegister(RegisterFileType, unsigned i, VInt v) override {
+    // x0 is hardwired to zero.
+    if (i != 0)
+      m_state.regs.at(i) = static_cast<XLEN_T>(v);
+  }
+  void setProgramCounter(AInt address) override {
+    m_state.pc = static_cast<XLEN_T>(address);
+  }
+  void setPCInitialValue(AInt address) override {
+    m_pcInitialValue = static_cast<XLEN_T>(address);
+  }
+
+  void resetProcessor() override {
+    m_memory->reset();
+    if (m_translator)
+      m_translator->clear();
+    m_state = RVHartState<XLEN_T>();
+    m_state.pc = m_pcInitialValue;
+    m_dataAccess = MemoryAccess();
+    m_instrAccess = MemoryAccess();
+    m_cycleCount = 0;
+    m_instructionsRetired = 0;
+    m_takenBranches = 0;
+    m_finishInNextCycle = false;
+    m_finished = false;
+    if (m_emitsSignals)
+      processorWasReset.Emit();
+  }
+
+  void finalize(FinalizeReason fr) override {
+    if (fr == FinalizeReason::exitSyscall) {
+      // Finish once the exiting ecall has been executed.
+      m_finishInNextCycle = true;
+    }
+  }
+  bool finished() const override {
+    return m_finished || !isExecutableAddress(m_state.pc);
+  }
+
+  long long getInstructionsRetired() const override {
+    return m_instructionsRetired;
+  }
+  long long getCycleCount() const override { return m_cycleCount; }
+  long long getPerfEventCount(PerfEvent event) const override {
+    return event == PerfEvent::TakenBranches ? m_takenBranches : 0;
+  }
+
+protected:
+  void clockProcessor() override {
+    if (m_translator) {
+      if (const unsigned n = m_translator->run(m_state, *m_memory)) {
+        m_instrAccess = MemoryAccess();
+        m_dataAccess = MemoryAccess();
+        m_cycleCount += n;
+        m_instructionsRetired += n;
+        if (m_translator->branchTaken())
+          m_takenBranches++;
+        if (m_emitsSignals)
+          processorWasClocked.Emit();
+        return;
+      }
+    }
+
+    m_instrAccess = {MemoryAccess::Read, m_state.pc, 4};
+    const auto instr = m_executor.fetch(*m_memory, m_state.pc);
+    if (RVExecutor<XLEN_T>::branchTaken(instr.opcode, m_state.regs[instr.rs1],
+                                        m_state.regs[instr.rs2]))
+      m_takenBranches++;
+    const auto res = RVExecutor<XLEN_T>::execute(instr, m_state, *m_memory);
+    // CSRs are read before the counters account for this instruction.
+    if (res.csr && instr.rd != 0)
+      m_state.regs[instr.rd] = static_cast<XLEN_T>(
+          rvReadCSR(*this, static_cast<unsigned>(instr.imm)));
+    m_dataAccess = res.dataAccess;
+    if (m_translator && res.dataAccess.type == MemoryAccess::Write)
+      m_translator->notifyWrite(res.dataAccess.address, res.dataAccess.bytes);
+
+    // The trap handler inspects the syscall argument registers, which are
+    // unaffected by executing the ecall.
+    if (res.ecall && trapHandler) {
+      trapHandler();
+      // Syscalls may write to memory.
+      if (m_translator)
+        m_translator->notifyExternalWrite();
+    }
+
+    m_cycleCount++;
+    m_instructionsRetired++;
+    if (m_finishInNextCycle)
+      m_finished = true;
+
+    if (m_emitsSignals)
+      processorWasClocked.Emit();
+  }
+
+private:
+  using Translator = RVTranslator<XLEN_T, vsrtl::core::AddressSpaceMM>;
+
+  std::shared_ptr<ISAInfoBase> m_enabledISA;
+  RVExecutor<XLEN_T> m_executor;
+  std::shared_ptr<vsrtl::core::AddressSpaceMM> m_memory =
+      std::make_shared<vsrtl::core::AddressSpaceMM>();
+  std::unique_ptr<Translator> m_translator;
+
+  RVHartState<XLEN_T> m_state;
+  XLEN_T m_pcInitialValue = 0;
+  MemoryAccess m_dataAccess;
+  MemoryAccess m_instrAccess;
+
+  long long m_cycleCount = 0;
+  long long m_instructionsRetired = 0;
+  long long m_takenBranches = 0;
+  bool m_finishInNextCycle = false;
+  bool m_finished = false;
+  ProcessorStructure m_structure = {{0, 1}};
+};
+
+} // namespace Ripes
@@ -219,6 +219,15 @@ public:
    */
   virtual vsrtl::core::AddressSpaceMM &getMemory() = 0;
 
+  /**
+   * @brief memoryWritten
+   * Called after @p bytes bytes at @p address have been written through
+   * getMemory() by anything but the processor itself (ie. by syscalls or
+   * peripherals). May be called from threads other than the one clocking the
+   * processor.
+   */
+  virtual void memoryWritten(AInt /*address*/, size_t /*bytes*/) {}
+
   /**
    * @brief dataMemAccess/instrMemAccess
    * @returns the state of a current access to the instruction or data memory.
@@ -304,6 +313,21 @@ public:
    */
   virtual long long getCycleCount() const = 0;
 
+  /**
+   * @brief The PerfEvent enum
+   * Microarchitectural events which a processor may count.
+   */
+  enum class PerfEvent { TakenBranches, StallCycles, Flushes, NumEvents };
+  /**
+   * @brief getPerfEventCount
+   * @returns the number of times @p event has occurred. Processors which do
+   * not model an event report 0.
+   */
+  virtual long long getPerfEventCount(PerfEvent event) const {
+    Q_UNUSED(event);
+    return 0;
+  }
+
   /** ======================= Signals and callbacks ======================= */
   /**
    * @brief clocked, reversed & reset signals
@@ -314,6 +338,13 @@ public:
   Gallant::Signal0<> processorWasReversed;
   Gallant::Signal0<> processorWasReset;
 
+  /**
+   * @brief setEmitsSignals
+   * Enables or disables the emission of the above signals, ie. while running
+   * the processor without observing each cycle.
+   */
+  void setEmitsSignals(bool enabled) { m_emitsSignals = enabled; }
+
   /**
    * @brief isExecutableAddress
    * Callback that the processor can use to query the Ripes environment. Returns
@@ -4,6 +4,8 @@
  * Interface for all VSRTL-based Ripes processors
  */
 
+#include <array>
+
 #include "RISC-V/riscv.h"
 #include "VSRTL/core/vsrtl_design.h"
 #include "interface/ripesprocessor.h"
@@ -25,6 +27,7 @@ public:
 
   virtual void resetProcessor() override {
     m_instructionsRetired = 0;
+    m_perfEvents.fill(0);
     reset();
   }
 
@@ -34,6 +37,9 @@ public:
     return m_instructionsRetired;
   }
   long long getCycleCount() const override { return m_cycleCount; }
+  long long getPerfEventCount(PerfEvent event) const override {
+    return m_perfEvents.at(static_cast<unsigned>(event));
+  }
   void setMaxReverseCycles(unsigned cycles) override {
     setReverseStackSize(cycles);
   }
@@ -104,9 +110,17 @@ protected:
     return access;
   }
 
+  /// Adds @p n occurrences of @p event. Processors should count events when
+  /// clocked, and un-count them (n = -1) when reversed.
+  void countPerfEvent(PerfEvent event, long long n = 1) {
+    m_perfEvents.at(static_cast<unsigned>(event)) += n;
+  }
+
   // m_instructionsRetired should be modified by the processor when it retires
   // (or "un-retires", while reversing) an instruction
   long long m_instructionsRetired = 0;
+  std::array<long long, static_cast<unsigned>(PerfEvent::NumEvents)>
+      m_perfEvents{};
 };
 
 } // namespace Ripes
@@ -0,0 +1,318 @@
+#include "programcache.h"
+
+#include "processorhandler.h"
+#include "ripessettings.h"
+#include "version/version.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+namespace Ripes {
+
+/// Bumped whenever the serialized program format changes, invalidating all
+/// previously cached entries.
+static constexpr quint32 s_cacheFormatVersion = 2;
+/// Version of the QDataStream encoding of cache entries.
+static constexpr QDataStream::Version s_dataStreamVersion = QDataStream::Qt_6_0;
+
+/// Marks the open cache entry @p file as recently used.
+static void touch(QFile &file) {
+  file.setFileTime(QDateTime::currentDateTime(),
+                   QFileDevice::FileModificationTime);
+}
+
+ProgramCache::ProgramCache() {
+  m_dir = QDir(
+      QStandardPaths::writableLocation(QStandardPaths::CacheLocation) +
+      QDir::separator() + "programs");
+  m_dir.mkpath(".");
+}
+
+bool ProgramCache::enabled() {
+  return RipesSettings::value(RIPES_SETTING_BUILD_CACHE).toBool();
+}
+
+static void hashString(QCryptographicHash &hasher, const QString &str) {
+  hasher.addData(str.toUtf8());
+  // Delimit fields to avoid ambiguous concatenations.
+  hasher.addData(QByteArray(1, '\0'));
+}
+
+/// Adds the cache format and Ripes version to the hash, such that cache entries
+/// do not outlive the program version which generated them.
+static void hashVersion(QCryptographicHash &hasher) {
+  hashString(hasher, QString::number(s_cacheFormatVersion));
+  hashString(hasher, getRipesVersion());
+}
+
+QString ProgramCache::assemblyKey(const QByteArray &source,
+                                  const Assembler::SymbolMap *symbols) const {
+  QCryptographicHash hasher(QCryptographicHash::Sha1);
+  hashVersion(hasher);
+  hasher.addData(source);
+
+  const auto *isa = ProcessorHandler::currentISA();
+  hashString(hasher, isa->name());
+  QStringList extensions = isa->enabledExtensions();
+  extensions.sort();
+  hashString(hasher, extensions.join(","));
+
+  for (const auto &setting :
+       {RIPES_SETTING_ASSEMBLER_TEXTSTART, RIPES_SETTING_ASSEMBLER_DATASTART,
+        RIPES_SETTING_ASSEMBLER_BSSSTART})
+    hashString(hasher, RipesSettings::value(setting).toString());
+
+  if (symbols) {
+    // The absolute symbol map is unordered; sort the symbols to obtain a
+    // stable key.
+    QStringList symbolStrings;
+    for (const auto &symbol : symbols->abs)
+      symbolStrings << symbol.first.v + "=" + QString::number(symbol.second) +
+                           ":" + QString::number(symbol.first.type);
+    symbolStrings.sort();
+    hashString(hasher, symbolStrings.join(","));
+  }
+
+  return hasher.result().toHex();
+}
+
+QString ProgramCache::compileKey(const CCManager::CompileCommand &cc,
+                                 const QStringList &files,
+                                 const QString &outname) const {
+  QCryptographicHash hasher(QCryptographicHash::Sha1);
+  hashVersion(hasher);
+
+  // Identify the compiler by its path and modification time, to invalidate
+  // entries if the compiler is updated.
+  hashString(hasher, cc.bin.absoluteFilePath());
+  hashString(hasher, cc.bin.lastModified().toString(Qt::ISODate));
+
+  // Input files are identified by their contents rather than their (possibly
+  // temporary) names, and the output file does not affect the result.
+  for (const auto &arg : cc.args) {
+    if (arg == outname)
+      continue;
+    if (files.contains(arg)) {
+      QFile file(arg);
+      if (!file.open(QIODevice::ReadOnly))
+        return QString();
+      hasher.addData(QCryptographicHash::hash(file.readAll(),
+                                              QCryptographicHash::Sha1));
+      continue;
+    }
+    hashString(hasher, arg);
+  }
+
+  return hasher.result().toHex();
+}
+
+QString ProgramCache::cachedExecutable(const CCManager::CompileCommand &cc,
+                                       const QStringList &files,
+                                       const QString &outname) const {
+  if (!enabled())
+    return QString();
+
+  const QString key = compileKey(cc, files, outname);
+  if (key.isEmpty())
+    return QString();
+
+  QFile file(m_dir.filePath(key + ".elf"));
+  if (!file.open(QIODevice::ReadOnly))
+    return QString();
+  touch(file);
+  return file.fileName();
+}
+
+void ProgramCache::storeExecutable(const CCManager::CompileCommand &cc,
+                                   const QStringList &files,
+                                   const QString &outname,
+                                   const QString &path) {
+  if (!enabled())
+    return;
+
+  const QString key = compileKey(cc, files, outname);
+  if (key.isEmpty())
+    return;
+
+  // Copy through a temporary file, such that concurrent Ripes processes never
+  // observe a partially written cache entry.
+  const QString cachePath = m_dir.filePath(key + ".elf");
+  QFile in(path);
+  QSaveFile out(cachePath);
+  if (!in.open(QIODevice::ReadOnly) || !out.open(QIODevice::WriteOnly))
+    return;
+  out.write(in.readAll());
+  if (out.commit())
+    evict();
+}
+
+Assembler::AssembleResult
+ProgramCache::assemble(const QString &source,
+                       const Assembler::SymbolMap *symbols) {
+  auto assembler = ProcessorHandler::getAssembler();
+  if (!enabled())
+    return assembler->assembleRaw(source, symbols);
+
+  return assembleCached(assemblyKey(source.toUtf8(), symbols), [&] {
+    return assembler->assembleRaw(source, symbols);
+  });
+}
+
+Assembler::AssembleResult
+ProgramCache::assembleUnits(const std::vector<Assembler::AssemblyUnit> &units,
+                            const Assembler::SymbolMap *symbols) {
+  if (units.size() == 1)
+    return assemble(units.front().source, symbols);
+
+  auto assembler = ProcessorHandler::getAssembler();
+  if (!enabled())
+    return assembler->assembleUnits(units, symbols);
+
+  // The linked program depends on the order of the units but not on their
+  // names, which are only used for error reporting.
+  QByteArray sources = "units:" + QByteArray::number(units.size());
+  for (const auto &unit : units) {
+    sources.append('\0');
+    sources.append(unit.source.toUtf8());
+  }
+  return assembleCached(assemblyKey(sources, symbols), [&] {
+    return assembler->assembleUnits(units, symbols);
+  });
+}
+
+Assembler::AssembleResult ProgramCache::assembleCached(
+    const QString &key,
+    const std::function<Assembler::AssembleResult()> &assemble) {
+  if (auto program = loadProgram(key); program.has_value()) {
+    Assembler::AssembleResult res;
+    res.program = std::move(program.value());
+    return res;
+  }
+
+  auto res = assemble();
+  if (res.errors.empty())
+    storeProgram(key, res.program);
+  return res;
+}
+
+std::optional<Program> ProgramCache::loadProgram(const QString &key) const {
+  QFile file(m_dir.filePath(key + ".prog"));
+  if (!file.open(QIODevice::ReadOnly))
+    return std::nullopt;
+
+  QDataStream in(&file);
+  auto program = readProgram(in);
+  if (program.has_value())
+    touch(file);
+  return program;
+}
+
+std::optional<Program> ProgramCache::readProgram(QDataStream &in) {
+  in.setVersion(s_dataStreamVersion);
+  quint32 version;
+  in >> version;
+  if (version != s_cacheFormatVersion)
+    return std::nullopt;
+
+  Program program;
+  quint64 entryPoint;
+  in >> entryPoint >> program.sourceHash;
+  program.entryPoint = entryPoint;
+
+  quint32 nSections;
+  in >> nSections;
+  for (quint32 i = 0; i < nSections && in.status() == QDataStream::Ok; ++i) {
+    ProgramSection section;
+    quint64 address;
+    quint32 alignment;
+    in >> section.name >> address >> section.data >> alignment;
+    section.address = address;
+    section.alignment = alignment;
+    program.sections[section.name] = section;
+  }
+
+  quint32 nSymbols;
+  in >> nSymbols;
+  for (quint32 i = 0; i < nSymbols && in.status() == QDataStream::Ok; ++i) {
+    quint64 address;
+    Symbol symbol;
+    quint32 type;
+    in >> address >> symbol.v >> type;
+    symbol.type = type;
+    program.symbols[address] = symbol;
+  }
+
+  quint32 nMappings;
+  in >> nMappings;
+  for (quint32 i = 0; i < nMappings && in.status() == QDataStream::Ok; ++i) {
+    quint64 address;
+    quint32 nLines;
+    in >> address >> nLines;
+    auto &lines = program.sourceMapping[address];
+    for (quint32 j = 0; j < nLines && in.status() == QDataStream::Ok; ++j) {
+      quint32 line;
+      in >> line;
+      lines.insert(line);
+    }
+  }
+
+  if (in.status() != QDataStream::Ok)
+    return std::nullopt;
+  return program;
+}
+
+void ProgramCache::storeProgram(const QString &key,
+                                const Program &program) const {
+  QSaveFile file(m_dir.filePath(key + ".prog"));
+  if (!file.open(QIODevice::WriteOnly))
+    return;
+
+  QDataStream out(&file);
+  writeProgram(out, program);
+  if (file.commit())
+    evict();
+}
+
+void ProgramCache::writeProgram(QDataStream &out, const Program &program) {
+  out.setVersion(s_dataStreamVersion);
+  out << s_cacheFormatVersion;
+  out << static_cast<quint64>(program.entryPoint) << program.sourceHash;
+
+  out << static_cast<quint32>(program.sections.size());
+  for (const auto &section : program.sections)
+    out << section.second.name << static_cast<quint64>(section.second.address)
+        << section.second.data
+        << static_cast<quint32>(section.second.alignment);
+
+  out << static_cast<quint32>(program.symbols.size());
+  for (const auto &symbol : program.symbols)
+    out << static_cast<quint64>(symbol.first) << symbol.second.v
+        << static_cast<quint32>(symbol.second.type);
+
+  out << static_cast<quint32>(program.sourceMapping.size());
+  for (const auto &mapping : program.sourceMapping) {
+    out << static_cast<quint64>(mapping.first)
+        << static_cast<quint32>(mapping.second.size());
+    for (const auto line : mapping.second)
+      out << static_cast<quint32>(line);
+  }
+}
+
+void ProgramCache::evict() const {
+  // Entries are ordered from most to least recently used; see touch().
+  const QFileInfoList entries = m_dir.entryInfoList(
+      {"*.prog", "*.elf"}, QDir::Files, QDir::Time);
+  qint64 size = 0;
+  for (const auto &entry : entries) {
+    size += entry.size();
+    if (size > s_maxCacheBytes)
+      QFile::remove(entry.absoluteFilePath());
+  }
+}
+
+} // namespace Ripes
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <QDataStream>
+#include <QDir>
+#include <QString>
+
+#include <functional>
+#include <optional>
+
+#include "assembler/assemblerbase.h"
+#include "assembler/program.h"
+#include "ccmanager.h"
+
+namespace Ripes {
+
+/**
+ * @brief The ProgramCache class
+ * Persistent, on-disk cache of assembled programs and compiled executables.
+ * Cache entries are keyed on a hash of everything which influences the
+ * produced output: the source code, the ISA and its enabled extensions, the
+ * assembler segment settings and predefined symbols, or, for compiled
+ * programs, the compiler and its arguments. Rerunning a CLI job or
+ * recompiling a C program over the same inputs thereby skips assembly and
+ * compilation. The cache is bounded to s_maxCacheBytes, evicting the least
+ * recently used entries first. In the GUI, only sources which are loaded (ie.
+ * an opened file, or the source restored at startup) are looked up; sources
+ * being edited are assembled directly, since nearly every edit yields a new
+ * source.
+ *
+ * Note: Files #include'd by a compiled C source are not part of the compile
+ * cache key.
+ */
+class ProgramCache {
+public:
+  static ProgramCache &get() {
+    static ProgramCache cache;
+    return cache;
+  }
+
+  /// Assembles @p source with the current assembler. If the same source has
+  /// previously been assembled under the same configuration, the cached
+  /// program is returned instead.
+  Assembler::AssembleResult
+  assemble(const QString &source, const Assembler::SymbolMap *symbols);
+
+  /// Assembles and links @p units with the current assembler, or returns the
+  /// cached program if the same units have previously been linked under the
+  /// same configuration.
+  Assembler::AssembleResult
+  assembleUnits(const std::vector<Assembler::AssemblyUnit> &units,
+                const Assembler::SymbolMap *symbols);
+
+  /// Returns the path of a cached executable for the compile command @p cc, or
+  /// an empty string if no such executable has been cached.
+  QString cachedExecutable(const CCManager::CompileCommand &cc,
+                           const QStringList &files,
+                           const QString &outname) const;
+
+  /// Stores the executable @p path compiled through @p cc in the cache.
+  void storeExecutable(const CCManager::CompileCommand &cc,
+                       const QStringList &files, const QString &outname,
+                       const QString &path);
+
+  /// Returns true if the cache is enabled in the settings.
+  static bool enabled();
+
+  /// Serializes @p program to @p out, in the format of cached programs.
+  static void writeProgram(QDataStream &out, const Program &program);
+  /// Deserializes a program written through writeProgram, or returns
+  /// std::nullopt if @p in does not contain a program of the current format.
+  static std::optional<Program> readProgram(QDataStream &in);
+
+  /// Maximum total size of the cache entries, in bytes.
+  static constexpr qint64 s_maxCacheBytes = 64 * 1024 * 1024;
+
+private:
+  ProgramCache();
+
+  QString assemblyKey(const QByteArray &source,
+                      const Assembler::SymbolMap *symbols) const;
+  QString compileKey(const CCManager::CompileCommand &cc,
+                     const QStringList &files, const QString &outname) const;
+
+  /// Returns the program cached under @p key, or otherwise assembles the
+  /// program through @p assemble and caches the result.
+  Assembler::AssembleResult
+  assembleCached(const QString &key,
+                 const std::function<Assembler::AssembleResult()> &assemble);
+
+  std::optional<Program> loadProgram(const QString &key) const;
+  void storeProgram(const QString &key, const Program &program) const;
+  /// Removes the least recently used cache entries until the cache fits within
+  /// s_maxCacheBytes.
+  void evict() const;
+
+  QDir m_dir;
+};
+
+} // namespace Ripes
@@ -27,6 +27,7 @@ const std::map<QString, QVariant> s_defaultSettings = {
     {RIPES_SETTING_CONSOLEFONT, QColorConstants::Black},
     {RIPES_SETTING_INDENTAMT, 4},
     {RIPES_SETTING_UIUPDATEPS, 25},
+    {RIPES_SETTING_BUILD_CACHE, true},
 
     {RIPES_SETTING_ASSEMBLER_TEXTSTART, 0x0},
     {RIPES_SETTING_ASSEMBLER_DATASTART, 0x10000000},
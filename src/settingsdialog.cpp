@@ -273,6 +273,11 @@ QWidget *SettingsDialog::createCompilerPage() {
       createSettingsWidgets<HexSpinBox>(RIPES_SETTING_ASSEMBLER_BSSSTART,
                                         ".bss section start address:"),
       ASMLayout);
+  appendToLayout(
+      createSettingsWidgets<QCheckBox>(
+          RIPES_SETTING_BUILD_CACHE,
+          "Cache assembled and compiled programs on disk:"),
+      ASMLayout);
 
   pageLayout->addWidget(ASMGroupBox);
 
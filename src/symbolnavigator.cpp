@@ -25,9 +25,15 @@ SymbolNavigator::SymbolNavigator(const ReverseSymbolMap &symbolmap,
       QHeaderView::ResizeToContents);
   m_ui->buttonBox->button(QDialogButtonBox::Ok)->setText("Go to symbol");
 
+  // Size the table once up front; growing it one row at a time is quadratic
+  // for programs with many symbols.
+  m_ui->symbolTable->setUpdatesEnabled(false);
+  m_ui->symbolTable->setRowCount(symbolmap.size());
+  int row = 0;
   for (const auto &iter : symbolmap) {
-    addSymbol(iter.first, iter.second);
+    setSymbol(row++, iter.first, iter.second);
   }
+  m_ui->symbolTable->setUpdatesEnabled(true);
   m_ui->symbolTable->selectRow(0);
 }
 
@@ -39,8 +45,8 @@ AInt SymbolNavigator::getSelectedSymbolAddress() const {
   return 0;
 }
 
-void SymbolNavigator::addSymbol(const AInt address, const QString &label) {
-  m_ui->symbolTable->setRowCount(m_ui->symbolTable->rowCount() + 1);
+void SymbolNavigator::setSymbol(int row, const AInt address,
+                                const QString &label) {
   QTableWidgetItem *addrItem = new QTableWidgetItem();
   QTableWidgetItem *labelItem = new QTableWidgetItem();
 
@@ -55,7 +61,6 @@ void SymbolNavigator::addSymbol(const AInt address, const QString &label) {
   addrItem->setData(Qt::UserRole, QVariant::fromValue(address));
   labelItem->setData(Qt::UserRole, QVariant::fromValue(address));
 
-  const int row = m_ui->symbolTable->rowCount() - 1;
   m_ui->symbolTable->setItem(row, 0, addrItem);
   m_ui->symbolTable->setItem(row, 1, labelItem);
 }
@@ -20,7 +20,7 @@ public:
   AInt getSelectedSymbolAddress() const;
 
 private:
-  void addSymbol(const AInt address, const QString &label);
+  void setSymbol(int row, const AInt address, const QString &label);
 
   Ui::SymbolNavigator *m_ui;
 };
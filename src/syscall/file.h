@@ -21,14 +21,7 @@ public:
   void execute() {
     const AInt arg0 = BaseSyscall::getArg(RegisterFileType::GPR, 0);
     const AInt arg1 = BaseSyscall::getArg(RegisterFileType::GPR, 1);
-    QByteArray string;
-    char byte;
-    unsigned int address = arg0;
-    do {
-      byte = static_cast<char>(
-          ProcessorHandler::getMemory().readMemConst(address++, 1) & 0xFF);
-      string.append(byte);
-    } while (byte != '\0');
+    const QByteArray string = ProcessorHandler::readMemString(arg0);
 
     int ret = SystemIO::openFile(QString::fromUtf8(string), arg1);
 
@@ -84,23 +77,18 @@ public:
                     {{0, "number of read bytes or -1 if an error occurred"}}) {}
   void execute() {
     const int fd = BaseSyscall::getArg(RegisterFileType::GPR, 0);
-    int byteAddress = BaseSyscall::getArg(
+    const AInt byteAddress = BaseSyscall::getArg(
         RegisterFileType::GPR, 1); // destination of characters read from file
     const int length = BaseSyscall::getArg(RegisterFileType::GPR, 2);
     QByteArray buffer;
 
-    int retLength = SystemIO::readFromFile(fd, buffer, length);
+    const int retLength = SystemIO::readFromFile(fd, buffer, length);
     BaseSyscall::setRet(RegisterFileType::GPR, 0, retLength);
 
-    if (retLength != -1) {
+    if (retLength > 0) {
       // copy bytes from returned buffer into memory
-      const char *dataptr =
-          buffer.constData(); // QString::data contains a possible null
-                              // termination '\0' character (present if reading
-                              // from stdin and not from a file)
-      while (retLength-- > 0) {
-        ProcessorHandler::writeMem(byteAddress++, *dataptr++, sizeof(char));
-      }
+      ProcessorHandler::writeMemBlock(byteAddress, buffer.constData(),
+                                      retLength);
     }
   }
 };
@@ -117,7 +105,7 @@ public:
                      {2, "number of bytes to write"}},
                     {{0, "the number of bytes written"}}) {}
   void execute() {
-    const int byteAddress = BaseSyscall::getArg(
+    const AInt byteAddress = BaseSyscall::getArg(
         RegisterFileType::GPR, 1); // source of characters to write to file
     const int reqLength =
         BaseSyscall::getArg(RegisterFileType::GPR, 2); // user-requested length
@@ -125,14 +113,8 @@ public:
       BaseSyscall::setRet(RegisterFileType::GPR, 0, -1);
       return;
     }
-    int index = 0;
-    QString myBuffer;
-
-    do {
-      myBuffer.append(static_cast<char>(
-          ProcessorHandler::getMemory().readMemConst(byteAddress + index++, 1) &
-          0xFF));
-    } while (index < reqLength);
+    QByteArray myBuffer(reqLength, Qt::Uninitialized);
+    ProcessorHandler::readMemBlock(byteAddress, myBuffer.data(), reqLength);
 
     const int retValue = SystemIO::writeToFile(
         BaseSyscall::getArg(RegisterFileType::GPR, 0), myBuffer, reqLength);
@@ -153,9 +135,8 @@ public:
              {1, "the length of the buffer"}},
             {{0, "-1 if the path is longer than the buffer"}}) {}
   void execute() {
-    const int byteAddress = BaseSyscall::getArg(
+    const AInt byteAddress = BaseSyscall::getArg(
         RegisterFileType::GPR, 0); // destination of characters read from file
-    int index = 0;
     const int bufferSize = BaseSyscall::getArg(RegisterFileType::GPR, 1);
 
     const QString pwd = QDir::currentPath();
@@ -168,10 +149,9 @@ public:
     }
 
     // copy bytes from returned buffer into memory
-    while (index < pwd.length()) {
-      ProcessorHandler::writeMem(byteAddress, pwd.at(index++).toLatin1(),
-                                 sizeof(char));
-    }
+    const QByteArray bytes = pwd.toLatin1();
+    ProcessorHandler::writeMemBlock(byteAddress, bytes.constData(),
+                                    bytes.size());
   }
 };
 
@@ -49,15 +49,8 @@ public:
                     {{0, "address of the string"}}) {}
   void execute() {
     const VInt arg0 = BaseSyscall::getArg(RegisterFileType::GPR, 0);
-    QByteArray string;
-    char byte;
-    AInt address = arg0;
-    do {
-      byte = static_cast<char>(
-          ProcessorHandler::getMemory().readMemConst(address++, 1) & 0xFF);
-      string.append(byte);
-    } while (byte != '\0');
-    SystemIO::printString(QString::fromUtf8(string));
+    SystemIO::printString(
+        QString::fromUtf8(ProcessorHandler::readMemString(arg0)));
   }
 };
 
@@ -10,5 +10,11 @@ std::map<int, QFile> SystemIO::FileIOData::files;
 QByteArray SystemIO::FileIOData::s_stdinBuffer;
 QMutex SystemIO::FileIOData::s_stdioMutex;
 QWaitCondition SystemIO::FileIOData::s_stdinBufferEmpty;
+std::FILE *SystemIO::FileIOData::s_stdinSource = nullptr;
+bool SystemIO::FileIOData::s_stdinSourceInteractive = false;
 bool SystemIO::s_abortSyscall = false;
+QString SystemIO::s_outputBuffer;
+QMutex SystemIO::s_outputMutex;
+QElapsedTimer SystemIO::s_lastOutputFlush;
+bool SystemIO::s_flushScheduled = false;
 } // namespace Ripes
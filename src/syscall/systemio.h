@@ -2,14 +2,18 @@
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QInputDialog>
 #include <QMutex>
 #include <QObject>
 #include <QTemporaryFile>
 #include <QTextStream>
+#include <QTimer>
 #include <QWaitCondition>
 
+#include <algorithm>
+#include <cstdio>
 #include <stdexcept>
 #include <sys/stat.h>
 
@@ -71,11 +75,18 @@ private:
   // Standard I/O Channels
   enum STDIO { STDIN = 0, STDOUT = 1, STDERR = 2, STDIO_END };
 
-  // Buffer size for syscalls for file I/O
-  static constexpr int SYSCALL_BUFSIZE = 128;
   // Maximum number of files that can be open
   static constexpr int SYSCALL_MAXFILES = 32;
 
+  // Output to STDOUT and STDERR is buffered, and emitted through doPrint once
+  // OUTPUT_BUFSIZE characters are pending, or at the latest OUTPUT_FLUSH_MS
+  // after it was buffered. A newline flushes the buffer if no flush occurred
+  // within the last OUTPUT_LINE_MS, such that infrequent (ie. interactive)
+  // output is printed line by line, while bulk output is coalesced.
+  static constexpr int OUTPUT_BUFSIZE = 1 << 16;
+  static constexpr int OUTPUT_FLUSH_MS = 50;
+  static constexpr int OUTPUT_LINE_MS = 10;
+
   static constexpr int O_RDONLY = 0x00000000;
   static constexpr int O_WRONLY = 0x00000001;
   static constexpr int O_RDWR = 0x00000002;
@@ -94,7 +105,8 @@ private:
     // The flags of this file, 0=READ, 1=WRITE. Invalid if this file descriptor
     // is not in use.
     static std::map<int, unsigned> fileFlags;
-    // The streams in use, associated with the filenames
+    // The streams in use. Only STDIN is accessed through a stream; files are
+    // read and written as raw bytes through their QFile.
     static std::map<int, QTextStream> streams;
     // The file pointers in use
     static std::map<int, QFile> files;
@@ -110,6 +122,11 @@ private:
     static QMutex s_stdioMutex;
     static QWaitCondition s_stdinBufferEmpty;
 
+    // If set, reads from STDIN are served from this file rather than from
+    // s_stdinBuffer; see setStdinSource.
+    static std::FILE *s_stdinSource;
+    static bool s_stdinSourceInteractive;
+
     // Reset all file information. Closes any open files and resets the arrays
     static void resetFiles() {
       for (int i = 0; i < SYSCALL_MAXFILES; ++i) {
@@ -170,8 +187,6 @@ private:
         files.erase(fd);
         throw std::runtime_error("File could not be opened");
       }
-
-      streams.emplace(fd, &files[fd]);
     }
 
     // Retrieve a stream for use
@@ -297,21 +312,31 @@ public:
     }
     if (fd < 0 || fd >= SYSCALL_MAXFILES)
       return -1;
-    auto &stream = FileIOData::getStreamInUse(fd);
+    if (fd < STDIO_END) {
+      auto &stream = FileIOData::getStreamInUse(fd);
+      if (base == SEEK_CUR)
+        offset += stream.pos();
+      else if (base != SEEK_SET)
+        return -1;
+      if (offset < 0 || !stream.seek(offset))
+        return -1;
+      return offset;
+    }
+    auto &file = FileIOData::files[fd];
 
     if (base == SEEK_SET) {
       offset += 0;
     } else if (base == SEEK_CUR) {
-      offset += stream.pos();
+      offset += file.pos();
     } else if (base == SEEK_END) {
-      offset += FileIOData::files[fd].size();
+      offset += file.size();
     } else {
       return -1;
     }
     if (offset < 0) {
       return -1;
     }
-    stream.seek(offset);
+    file.seek(offset);
     return offset;
   }
 
@@ -337,10 +362,16 @@ public:
           "File descriptor " + QString::number(fd) + " is not open for reading";
       return -1;
     }
-    // retrieve FileInputStream from storage
-    auto &InputStream = FileIOData::getStreamInUse(fd);
+    // Make sure that any prompt is visible before waiting for input.
+    if (fd == STDIN)
+      flushOutput();
+    if (fd == STDIN && FileIOData::s_stdinSource) {
+      myBuffer = readStdinSource(lengthRequested);
+      return myBuffer.size();
+    }
 
     if (fd == STDIN) {
+      auto &InputStream = FileIOData::getStreamInUse(fd);
       // systemIO might be called from non-gui thread, so be threadsafe in
       // interacting with the ui.
       postToGUIThread([=] {
@@ -370,9 +401,8 @@ public:
           break;
       }
     } else {
-      // Reads up to lengthRequested bytes of data from this Input stream into
-      // an array of bytes.
-      myBuffer = InputStream.read(lengthRequested).toUtf8();
+      // Reads up to lengthRequested bytes of the file in a single read.
+      myBuffer = FileIOData::files[fd].read(std::max(lengthRequested, 0));
     }
 
     if (myBuffer.size() == 0) {
@@ -393,15 +423,16 @@ public:
    * Write bytes to file.
    *
    * @param fd              file descriptor
-   * @param myBuffer        byte array containing characters to write
+   * @param myBuffer        byte array containing the bytes to write
    * @param lengthRequested number of bytes to write
    * @return number of bytes written, or -1 on error
    */
 
-  static int writeToFile(int fd, const QString &myBuffer, int lengthRequested) {
+  static int writeToFile(int fd, const QByteArray &myBuffer,
+                         int lengthRequested) {
     SystemIO::get(); // Ensure that SystemIO is constructed
     if (fd == STDOUT || fd == STDERR) {
-      emit get().doPrint(myBuffer);
+      bufferOutput(QString::fromUtf8(myBuffer));
       return myBuffer.size();
     }
 
@@ -412,12 +443,16 @@ public:
           "File descriptor " + QString::number(fd) + " is not open for writing";
       return -1;
     }
-    // retrieve FileOutputStream from storage
-    auto &outputStream = FileIOData::getStreamInUse(fd);
-
-    outputStream << myBuffer;
-    outputStream.flush();
-    return lengthRequested;
+    // The buffer is written to the file in a single write.
+    auto &file = FileIOData::files[fd];
+    const qint64 written = file.write(
+        myBuffer.constData(),
+        std::clamp<qint64>(lengthRequested, 0, myBuffer.size()));
+    if (written < 0 || !file.flush()) {
+      s_fileErrorString = file.errorString();
+      return -1;
+    }
+    return static_cast<int>(written);
 
   } // end writeToFile
 
@@ -428,11 +463,49 @@ public:
    */
   static void closeFile(int fd) { FileIOData::close(fd); }
 
-  static void printString(const QString &string) { emit get().doPrint(string); }
-  static void reset() { FileIOData::resetFiles(); }
+  /**
+   * @brief setStdinSource
+   * Serves reads from STDIN from @p file instead of from the console, for
+   * headless simulation. Reads never block on user input, and return 0 at the
+   * end of @p file. If @p interactive is set (ie. @p file is a terminal), a
+   * read returns after the first newline, as when reading from the console;
+   * otherwise, reads return as many bytes as requested while available.
+   * @p file remains owned by the caller; nullptr restores console input.
+   */
+  static void setStdinSource(std::FILE *file, bool interactive) {
+    FileIOData::s_stdinSource = file;
+    FileIOData::s_stdinSourceInteractive = interactive;
+  }
+
+  static void printString(const QString &string) { bufferOutput(string); }
+
+  /**
+   * @brief flushOutput
+   * Emits any buffered output through doPrint. Output is flushed periodically,
+   * and should be flushed explicitly once a program stops executing.
+   */
+  static void flushOutput() {
+    QMutexLocker lock(&s_outputMutex);
+    s_lastOutputFlush.start();
+    s_flushScheduled = false;
+    if (s_outputBuffer.isEmpty())
+      return;
+    // Emitted while locked, to retain the order of output flushed by different
+    // threads.
+    emit get().doPrint(s_outputBuffer);
+    s_outputBuffer.clear();
+  }
+
+  static void reset() {
+    flushOutput();
+    FileIOData::resetFiles();
+  }
   static void abortSyscall() { s_abortSyscall = true; }
 
 signals:
+  /// Emitted with buffered program output; see flushOutput. Receivers must
+  /// connect through a queued connection, since output may be flushed from
+  /// any thread.
   void doPrint(const QString &);
 
 public slots:
@@ -448,7 +521,81 @@ public slots:
   }
 
 private:
-  SystemIO() { reset(); }
+  static void bufferOutput(const QString &string) {
+    bool flush;
+    bool scheduleFlush = false;
+    {
+      QMutexLocker lock(&s_outputMutex);
+      s_outputBuffer += string;
+      const qint64 sinceFlush = s_lastOutputFlush.isValid()
+                                    ? s_lastOutputFlush.elapsed()
+                                    : OUTPUT_FLUSH_MS;
+      flush = s_outputBuffer.size() >= OUTPUT_BUFSIZE ||
+              sinceFlush >= OUTPUT_FLUSH_MS ||
+              (sinceFlush >= OUTPUT_LINE_MS && string.contains('\n'));
+      // Output which is not flushed now is flushed by the flush timer, which
+      // is started once per flush.
+      if (!flush && !s_flushScheduled) {
+        s_flushScheduled = true;
+        scheduleFlush = true;
+      }
+    }
+    if (flush)
+      flushOutput();
+    else if (scheduleFlush)
+      get().startFlushTimer();
+  }
+
+  /// Starts the flush timer. May be called from any thread; the timer is
+  /// started in the application thread.
+  void startFlushTimer() {
+    QMetaObject::invokeMethod(
+        m_flushTimer, [this] { m_flushTimer->start(); }, Qt::QueuedConnection);
+  }
+
+  static QByteArray readStdinSource(int lengthRequested) {
+    QByteArray buffer;
+    if (lengthRequested <= 0)
+      return buffer;
+    std::FILE *src = FileIOData::s_stdinSource;
+    if (FileIOData::s_stdinSourceInteractive) {
+      buffer.reserve(lengthRequested);
+      int c;
+      while (buffer.size() < lengthRequested && (c = std::getc(src)) != EOF) {
+        buffer.append(static_cast<char>(c));
+        if (c == '\n')
+          break;
+      }
+    } else {
+      // A single buffered read of the entire request.
+      buffer.resize(lengthRequested);
+      buffer.resize(static_cast<qsizetype>(
+          std::fread(buffer.data(), 1, lengthRequested, src)));
+    }
+    return buffer;
+  }
+
+  SystemIO() {
+    FileIOData::resetFiles();
+
+    // Flush output which is not followed by further output. The timer is a
+    // child of SystemIO, such that it moves along with it to the application
+    // thread; SystemIO may be constructed by a syscall on a simulation
+    // thread, which has no event loop.
+    m_flushTimer = new QTimer(this);
+    m_flushTimer->setSingleShot(true);
+    m_flushTimer->setInterval(OUTPUT_FLUSH_MS);
+    connect(m_flushTimer, &QTimer::timeout, this, [] { flushOutput(); });
+    if (auto *app = QCoreApplication::instance())
+      moveToThread(app->thread());
+  }
+
+  static QString s_outputBuffer;
+  static QMutex s_outputMutex;
+  static QElapsedTimer s_lastOutputFlush;
+  // Whether the flush timer has been started for the buffered output.
+  static bool s_flushScheduled;
+  QTimer *m_flushTimer = nullptr;
 };
 
 } // namespace Ripes
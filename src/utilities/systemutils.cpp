@@ -1,6 +1,18 @@
 #include "systemutils.h"
 
 #include <QProcess>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+// Must be included after windows.h
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
 namespace Ripes {
 bool isExecutable(const QString &path, const QStringList &dummyArgs) {
 #ifdef RIPES_WITH_QPROCESS
@@ -13,4 +25,44 @@ bool isExecutable(const QString &path, const QStringList &dummyArgs) {
 #endif
 }
 
+long long processCPUTimeUs() {
+#ifdef _WIN32
+  FILETIME creation, exit, kernel, user;
+  if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+    return 0;
+  // FILETIMEs are in units of 100 ns.
+  const auto toUs = [](const FILETIME &t) {
+    return ((static_cast<long long>(t.dwHighDateTime) << 32) |
+            t.dwLowDateTime) /
+           10;
+  };
+  return toUs(kernel) + toUs(user);
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+  return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+         usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+#endif
+}
+
+long long peakResidentSetBytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    return 0;
+  return static_cast<long long>(counters.PeakWorkingSetSize);
+#else
+  rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0)
+    return 0;
+#ifdef __APPLE__
+  // Reported in bytes on macOS, and in kilobytes elsewhere.
+  return usage.ru_maxrss;
+#else
+  return usage.ru_maxrss * 1024LL;
+#endif
+#endif
+}
+
 } // namespace Ripes
@@ -6,4 +6,12 @@ namespace Ripes {
 
 bool isExecutable(const QString &path, const QStringList &dummyArgs = {});
 
+/// Returns the CPU time (user + system) consumed by all threads of this
+/// process, in microseconds.
+long long processCPUTimeUs();
+
+/// Returns the peak resident set size of this process in bytes, or 0 if
+/// unavailable on the host.
+long long peakResidentSetBytes();
+
 } // namespace Ripes
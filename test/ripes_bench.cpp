@@ -0,0 +1,577 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <set>
+
+#include "cachesim/cachesim.h"
+#include "cachesim/l1cacheshim.h"
+#include "cli/programutilities.h"
+#include "pipelinediagrammodel.h"
+#include "processorhandler.h"
+#include "processorregistry.h"
+#include "processors/RISC-V/rv_batchexecutor.h"
+#include "ripessettings.h"
+#include "utilities/systemutils.h"
+
+/**
+ * Ripes benchmarks
+ * Measures the host performance of the simulator, such that performance
+ * regressions may be caught before they are merged. Each workload is run on
+ * every processor model and simulation engine, both bare and with the cache
+ * simulator and pipeline diagram attached, as they would be in the GUI. The
+ * throughput of the assembler and disassembler is measured as well, as is
+ * the batch executor against the equivalent sequence of compiled runs.
+ * Results are printed as JSON; progress is printed to stderr.
+ */
+
+using namespace Ripes;
+
+namespace {
+
+// Matrix multiplication of two 24x24 word matrices.
+constexpr auto s_matrixmulProgram = R"(
+.data
+A: .zero 2304
+B: .zero 2304
+C: .zero 2304
+.text
+  li s0, 24
+  mul t3, s0, s0
+  la t0, A
+  la t1, B
+  li t2, 0
+init:
+  sw t2, 0(t0)
+  slli t4, t2, 1
+  sw t4, 0(t1)
+  addi t0, t0, 4
+  addi t1, t1, 4
+  addi t2, t2, 1
+  blt t2, t3, init
+  li s1, 0
+loop_i:
+  li s2, 0
+loop_j:
+  li s3, 0
+  li s4, 0
+loop_k:
+  mul t0, s1, s0
+  add t0, t0, s3
+  slli t0, t0, 2
+  la t1, A
+  add t0, t0, t1
+  lw t2, 0(t0)
+  mul t0, s3, s0
+  add t0, t0, s2
+  slli t0, t0, 2
+  la t1, B
+  add t0, t0, t1
+  lw t3, 0(t0)
+  mul t2, t2, t3
+  add s4, s4, t2
+  addi s3, s3, 1
+  blt s3, s0, loop_k
+  mul t0, s1, s0
+  add t0, t0, s2
+  slli t0, t0, 2
+  la t1, C
+  add t0, t0, t1
+  sw s4, 0(t0)
+  addi s2, s2, 1
+  blt s2, s0, loop_j
+  addi s1, s1, 1
+  blt s1, s0, loop_i
+  li a7, 10
+  ecall
+)";
+
+// A long loop of arithmetic, memory and branch instructions. The loop runs
+// for longer than the default cycle limit.
+constexpr auto s_loopProgram = R"(
+.data
+buf: .word 0
+.text
+  li t0, 0
+  li t1, 100000000
+  la s0, buf
+loop:
+  add t2, t0, t1
+  xor t3, t2, t0
+  sw t3, 0(s0)
+  lw t4, 0(s0)
+  addi t0, t0, 1
+  bne t0, t1, loop
+  li a7, 10
+  ecall
+)";
+
+// Sums the lengths of the Collatz sequences of the 64 start values from a0.
+// Batch lanes starting at different values diverge at every branch on the
+// sequence values.
+constexpr auto s_batchProgram = R"(
+  mv s0, a0
+  addi s1, a0, 64
+  li s2, 0
+  li t1, 1
+outer:
+  mv t0, s0
+inner:
+  beq t0, t1, next
+  andi t2, t0, 1
+  beqz t2, even
+  slli t3, t0, 1
+  add t0, t0, t3
+  addi t0, t0, 1
+  j count
+even:
+  srli t0, t0, 1
+count:
+  addi s2, s2, 1
+  j inner
+next:
+  addi s0, s0, 1
+  blt s0, s1, outer
+  mv a0, s2
+  li a7, 10
+  ecall
+)";
+
+struct Workload {
+  QString name;
+  /// Assembly source of the workload. If empty, the workload is the example
+  /// ELF file elfPrefix + <XLEN>.
+  QString source;
+  QString elfPrefix;
+};
+
+/// Additional consumers of the processor state which are attached to the
+/// processor during simulation.
+enum class Instrumentation { None, Caches, PipelineDiagram };
+
+struct Options {
+  QStringList procs;
+  QStringList workloads;
+  long long maxCycles = 1000000;
+  qint64 minTimeMs = 200;
+  unsigned lanes = 64;
+};
+
+QString readFile(const QString &path) {
+  QFile file(path);
+  if (!file.open(QIODevice::ReadOnly))
+    return QString();
+  return QString(file.readAll());
+}
+
+std::vector<Workload> workloads() {
+  const QString examples = RIPES_EXAMPLES_DIR;
+  return {{"ranpi", QString(), examples + "/ELF/RanPi-RV"},
+          {"factorial", readFile(examples + "/assembly/factorial.s"), {}},
+          {"matrixmul", s_matrixmulProgram, {}},
+          {"loop", s_loopProgram, {}}};
+}
+
+QString engineName(ProcessorEngine engine) {
+  switch (engine) {
+  case ProcessorEngine::VSRTL:
+    return "vsrtl";
+  case ProcessorEngine::Compiled:
+    return "compiled";
+  case ProcessorEngine::Translated:
+    return "translated";
+  }
+  Q_UNREACHABLE();
+}
+
+QString instrumentationName(Instrumentation instrumentation) {
+  switch (instrumentation) {
+  case Instrumentation::None:
+    return "none";
+  case Instrumentation::Caches:
+    return "caches";
+  case Instrumentation::PipelineDiagram:
+    return "pipelinediagram";
+  }
+  Q_UNREACHABLE();
+}
+
+void progress(const QString &msg) { std::cerr << msg.toStdString() << "\n"; }
+
+/// Loads @p workload for the current processor. Returns nullptr and sets
+/// @p err if the workload could not be loaded.
+std::shared_ptr<Program> loadWorkload(const Workload &workload, QString &err) {
+  auto program = std::make_shared<Program>();
+  if (workload.source.isEmpty()) {
+    const unsigned xlen = ProcessorHandler::currentISA()->bits();
+    err = loadElfFile(*program, workload.elfPrefix + QString::number(xlen));
+  } else {
+    auto res = ProcessorHandler::getAssembler()->assembleRaw(workload.source);
+    if (!res.errors.empty())
+      err = res.errors.toString();
+    program = std::make_shared<Program>(res.program);
+  }
+  return err.isEmpty() ? program : nullptr;
+}
+
+/// Runs the loaded program through ProcessorHandler::run(), as in CLI mode,
+/// until it finishes or reaches the run limit.
+void runToCompletion() {
+  QEventLoop loop;
+  QObject::connect(ProcessorHandler::get(), &ProcessorHandler::runFinished,
+                   &loop, &QEventLoop::quit);
+  ProcessorHandler::run();
+  loop.exec();
+}
+
+/// Simulates @p program on the current processor at least once, and for at
+/// least Options::minTimeMs, with @p instrumentation attached.
+QJsonObject benchmarkSimulation(const Options &options,
+                                const std::shared_ptr<Program> &program,
+                                Instrumentation instrumentation) {
+  ProcessorHandler::loadProgram(program);
+
+  // Attach the instrumentation, as configured by the cache and processor tabs
+  // of the GUI.
+  QObject owner;
+  std::vector<std::shared_ptr<CacheSim>> caches;
+  if (instrumentation == Instrumentation::Caches) {
+    for (auto type : {L1CacheShim::CacheType::DataCache,
+                      L1CacheShim::CacheType::InstrCache}) {
+      auto *shim = new L1CacheShim(type, &owner);
+      caches.push_back(std::make_shared<CacheSim>(nullptr));
+      shim->setNextLevelCache(caches.back());
+    }
+  } else if (instrumentation == Instrumentation::PipelineDiagram) {
+    new PipelineDiagramModel(&owner);
+  }
+
+  const auto *proc = ProcessorHandler::getProcessor();
+  long long cycles = 0;
+  long long instructions = 0;
+  int repetitions = 0;
+  bool limited = false;
+  QElapsedTimer timer;
+  timer.start();
+  do {
+    RipesSettings::getObserver(RIPES_GLOBALSIGNAL_REQRESET)->trigger();
+    runToCompletion();
+    cycles += proc->getCycleCount();
+    instructions += proc->getInstructionsRetired();
+    limited |= ProcessorHandler::runLimitReached();
+    repetitions++;
+  } while (timer.elapsed() < options.minTimeMs);
+  const qint64 wallNs = std::max<qint64>(1, timer.nsecsElapsed());
+
+  QJsonObject result;
+  result.insert("status", limited ? "limit" : "finished");
+  result.insert("repetitions", repetitions);
+  result.insert("cycles", cycles);
+  result.insert("instructionsRetired", instructions);
+  result.insert("wallMs", wallNs / 1e6);
+  result.insert("cyclesPerSec", cycles * 1e9 / wallNs);
+  result.insert("instructionsPerSec", instructions * 1e9 / wallNs);
+  return result;
+}
+
+/// Runs @p program in Options::lanes lanes of an RVBatchExecutor, and as
+/// many sequential runs on the current processor, with a0 initialized
+/// differently for each lane. Each measurement is repeated for at least
+/// Options::minTimeMs.
+template <typename XLEN_T>
+QJsonObject benchmarkBatch(const Options &options,
+                           const std::shared_ptr<Program> &program) {
+  const auto laneValue = [](unsigned lane) { return 1 + 64 * lane; };
+  RVBatchMemory memory;
+  for (const auto &section : program->sections)
+    memory.write(section.second.address, section.second.data.constData(),
+                 section.second.data.size());
+
+  long long batchInstructions = 0;
+  int batchRepetitions = 0;
+  QElapsedTimer timer;
+  timer.start();
+  do {
+    RVBatchExecutor<XLEN_T> batch(ProcessorHandler::currentISA(),
+                                  options.lanes, memory, program->entryPoint);
+    for (unsigned lane = 0; lane < options.lanes; ++lane)
+      batch.setRegister(lane, 10, laneValue(lane));
+    batch.run(
+        [](XLEN_T pc) { return ProcessorHandler::isExecutableAddress(pc); },
+        {}, options.maxCycles);
+    for (unsigned lane = 0; lane < options.lanes; ++lane)
+      batchInstructions += batch.instructionsRetired(lane);
+    batchRepetitions++;
+  } while (timer.elapsed() < options.minTimeMs);
+  const qint64 batchNs = std::max<qint64>(1, timer.nsecsElapsed());
+
+  ProcessorHandler::loadProgram(program);
+  const auto *proc = ProcessorHandler::getProcessor();
+  long long sequentialInstructions = 0;
+  int sequentialRepetitions = 0;
+  timer.restart();
+  do {
+    for (unsigned lane = 0; lane < options.lanes; ++lane) {
+      RipesSettings::getObserver(RIPES_GLOBALSIGNAL_REQRESET)->trigger();
+      ProcessorHandler::setRegisterValue(RegisterFileType::GPR, 10,
+                                         laneValue(lane));
+      runToCompletion();
+      sequentialInstructions += proc->getInstructionsRetired();
+    }
+    sequentialRepetitions++;
+  } while (timer.elapsed() < options.minTimeMs);
+  const qint64 sequentialNs = std::max<qint64>(1, timer.nsecsElapsed());
+
+  const double batchRate = batchRepetitions * 1e9 / batchNs;
+  const double sequentialRate = sequentialRepetitions * 1e9 / sequentialNs;
+  QJsonObject result;
+  result.insert("lanes", static_cast<int>(options.lanes));
+  result.insert("instructionsPerRun", batchInstructions / batchRepetitions);
+  result.insert("batchRepetitions", batchRepetitions);
+  result.insert("batchWallMs", batchNs / 1e6);
+  result.insert("batchInstructionsPerSec", batchInstructions * 1e9 / batchNs);
+  result.insert("sequentialRepetitions", sequentialRepetitions);
+  result.insert("sequentialWallMs", sequentialNs / 1e6);
+  result.insert("sequentialInstructionsPerSec",
+                sequentialInstructions * 1e9 / sequentialNs);
+  result.insert("speedup", batchRate / sequentialRate);
+  return result;
+}
+
+/// Measures the assembler throughput of the assembly workloads, and the
+/// disassembler throughput of the text section of all workloads, for the ISA
+/// of the current processor.
+void benchmarkAssembler(const Options &options,
+                        const std::vector<Workload> &selected,
+                        QJsonArray &assembler, QJsonArray &disassembler) {
+  const auto assemblerInstance = ProcessorHandler::getAssembler();
+  const QString isa = ProcessorHandler::currentISA()->name();
+  for (const auto &workload : selected) {
+    QString err;
+    const auto program = loadWorkload(workload, err);
+    if (!program) {
+      progress("ERROR: " + workload.name + ": " + err);
+      continue;
+    }
+
+    if (!workload.source.isEmpty()) {
+      const long long lines = workload.source.count('\n') + 1;
+      int repetitions = 0;
+      QElapsedTimer timer;
+      timer.start();
+      do {
+        assemblerInstance->assembleRaw(workload.source);
+        repetitions++;
+      } while (timer.elapsed() < options.minTimeMs);
+      const qint64 wallNs = std::max<qint64>(1, timer.nsecsElapsed());
+      QJsonObject result;
+      result.insert("isa", isa);
+      result.insert("workload", workload.name);
+      result.insert("lines", lines);
+      result.insert("repetitions", repetitions);
+      result.insert("wallMs", wallNs / 1e6);
+      result.insert("linesPerSec", lines * repetitions * 1e9 / wallNs);
+      assembler.append(result);
+    }
+
+    const auto *text = program->getSection(TEXT_SECTION_NAME);
+    if (!text)
+      continue;
+    const long long words = text->data.size() / 4;
+    int repetitions = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do {
+      assemblerInstance->disassemble(*program, text->address);
+      repetitions++;
+    } while (timer.elapsed() < options.minTimeMs);
+    const qint64 wallNs = std::max<qint64>(1, timer.nsecsElapsed());
+    QJsonObject result;
+    result.insert("isa", isa);
+    result.insert("workload", workload.name);
+    result.insert("words", words);
+    result.insert("repetitions", repetitions);
+    result.insert("wallMs", wallNs / 1e6);
+    result.insert("wordsPerSec", words * repetitions * 1e9 / wallNs);
+    disassembler.append(result);
+  }
+}
+
+QJsonObject runBenchmarks(const Options &options) {
+  std::vector<Workload> selected;
+  for (const auto &workload : workloads()) {
+    if (options.workloads.isEmpty() ||
+        options.workloads.contains(workload.name))
+      selected.push_back(workload);
+  }
+
+  const bool runBatch =
+      options.workloads.isEmpty() || options.workloads.contains("batch");
+
+  QJsonArray assembler, disassembler, simulation, batch;
+  std::set<QString> benchmarkedISAs;
+  ProcessorHandler::setRunLimits(options.maxCycles, 0);
+  for (const auto &it : ProcessorRegistry::getAvailableProcessors()) {
+    const auto &desc = *it.second;
+    const QString procName = enumToString<ProcessorID>(desc.id);
+    if (!options.procs.isEmpty() && !options.procs.contains(procName))
+      continue;
+    const QStringList extensions = desc.isaInfo().defaultExtensions;
+
+    std::vector<ProcessorEngine> engines = {ProcessorEngine::VSRTL};
+    if (desc.hasCompiledEngine())
+      engines.push_back(ProcessorEngine::Compiled);
+    if (desc.hasTranslatedEngine())
+      engines.push_back(ProcessorEngine::Translated);
+
+    for (const auto engine : engines) {
+      ProcessorHandler::selectProcessor(desc.id, extensions, {}, engine);
+
+      // The assembler only depends on the ISA; benchmark it once per ISA.
+      if (benchmarkedISAs.insert(ProcessorHandler::currentISA()->name())
+              .second) {
+        progress("Benchmarking assembler for " +
+                 ProcessorHandler::currentISA()->name());
+        benchmarkAssembler(options, selected, assembler, disassembler);
+      }
+
+      for (const auto &workload : selected) {
+        QString err;
+        const auto program = loadWorkload(workload, err);
+        if (!program) {
+          progress("ERROR: " + workload.name + ": " + err);
+          continue;
+        }
+        for (const auto instrumentation :
+             {Instrumentation::None, Instrumentation::Caches,
+              Instrumentation::PipelineDiagram}) {
+          // The translating engine executes a block per clock, and so does
+          // not drive per-cycle consumers such as the caches and pipeline
+          // diagram; measuring them would time a no-op.
+          if (engine == ProcessorEngine::Translated &&
+              instrumentation != Instrumentation::None)
+            continue;
+          QJsonObject result =
+              benchmarkSimulation(options, program, instrumentation);
+          result.insert("proc", procName);
+          result.insert("engine", engineName(engine));
+          result.insert("workload", workload.name);
+          result.insert("instrumentation",
+                        instrumentationName(instrumentation));
+          simulation.append(result);
+          progress(procName + " " + engineName(engine) + " " + workload.name +
+                   " " + instrumentationName(instrumentation) + ": " +
+                   QString::number(result.value("cyclesPerSec").toDouble(),
+                                   'f', 0) +
+                   " cycles/s");
+        }
+      }
+
+      // The batch executor is compared against sequential runs of the
+      // compiled single-cycle model, which it shares its instruction
+      // semantics with.
+      const bool singleCycle =
+          desc.id == ProcessorID::RV32_SS || desc.id == ProcessorID::RV64_SS;
+      if (engine == ProcessorEngine::Compiled && singleCycle && runBatch) {
+        const auto res =
+            ProcessorHandler::getAssembler()->assembleRaw(s_batchProgram);
+        if (!res.errors.empty()) {
+          progress("ERROR: batch: " + res.errors.toString());
+          continue;
+        }
+        const auto program = std::make_shared<Program>(res.program);
+        QJsonObject result = ProcessorHandler::currentISA()->bits() == 64
+                                 ? benchmarkBatch<uint64_t>(options, program)
+                                 : benchmarkBatch<uint32_t>(options, program);
+        result.insert("proc", procName);
+        batch.append(result);
+        progress(procName + " batch " + QString::number(options.lanes) +
+                 " lanes: " +
+                 QString::number(result.value("speedup").toDouble(), 'f', 2) +
+                 "x over sequential runs");
+      }
+    }
+  }
+
+  QJsonObject out;
+  out.insert("maxCycles", options.maxCycles);
+  out.insert("minTimeMs", options.minTimeMs);
+  out.insert("assembler", assembler);
+  out.insert("disassembler", disassembler);
+  out.insert("simulation", simulation);
+  out.insert("batch", batch);
+  out.insert("peakRSSBytes", peakResidentSetBytes());
+  return out;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Ripes simulator benchmarks. Results are printed as JSON.");
+  parser.addHelpOption();
+  parser.addOption(QCommandLineOption(
+      "proc", "Comma-separated list of processors to benchmark (default: all).",
+      "procs"));
+  parser.addOption(QCommandLineOption(
+      "workload",
+      "Comma-separated list of workloads to run [ranpi, factorial, "
+      "matrixmul, loop, batch] (default: all).",
+      "workloads"));
+  parser.addOption(QCommandLineOption(
+      "max-cycles", "Maximum number of cycles of each simulation run.",
+      "cycles", "1000000"));
+  parser.addOption(QCommandLineOption(
+      "min-time",
+      "Minimum time in milliseconds of each measurement. Measurements are "
+      "repeated until this time has passed.",
+      "ms", "200"));
+  parser.addOption(QCommandLineOption(
+      "lanes", "Number of lanes of the batch workload.", "lanes", "64"));
+  parser.addOption(QCommandLineOption(
+      "output", "Output file for the results (default: stdout).", "file"));
+  parser.process(app);
+
+  Options options;
+  if (parser.isSet("proc"))
+    options.procs = parser.value("proc").split(",");
+  if (parser.isSet("workload"))
+    options.workloads = parser.value("workload").split(",");
+  bool ok = true;
+  options.maxCycles = parser.value("max-cycles").toLongLong(&ok);
+  if (ok)
+    options.minTimeMs = parser.value("min-time").toLongLong(&ok);
+  if (ok)
+    options.lanes = parser.value("lanes").toUInt(&ok);
+  if (!ok || options.maxCycles <= 0 || options.minTimeMs < 0 ||
+      options.lanes == 0) {
+    std::cerr << "ERROR: Invalid --max-cycles, --min-time or --lanes"
+              << std::endl;
+    return 1;
+  }
+
+  const QByteArray json =
+      QJsonDocument(runBenchmarks(options)).toJson(QJsonDocument::Indented);
+  if (!parser.isSet("output")) {
+    std::cout << json.toStdString();
+    return 0;
+  }
+  QFile out(parser.value("output"));
+  if (!out.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+    std::cerr << "ERROR: Failed to open output file" << std::endl;
+    return 1;
+  }
+  out.write(json);
+  return 0;
+}
@@ -0,0 +1,610 @@
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <random>
+#include <set>
+#include <thread>
+
+#include "assembler/rv32i_assembler.h"
+#include "assembler/rv64i_assembler.h"
+#include "cosimulator.h"
+#include "isa/rv32isainfo.h"
+#include "isa/rv64isainfo.h"
+#include "processorregistry.h"
+
+/**
+ * Ripes differential fuzzer
+ * Generates random RV32/RV64 IMC programs and cosimulates each of them on
+ * every processor model, and on the compiled models of the pipelined
+ * processors and the translating engine of the single-cycle processor,
+ * against the compiled single-cycle model (see Cosimulator),
+ * comparing register writes as they occur as well as the final register and
+ * memory state. Cosimulations run concurrently on worker threads.
+ * Failing programs are minimized, and written to the output directory as
+ * assembly files which may be loaded in Ripes.
+ */
+
+using namespace Ripes;
+
+namespace {
+
+// Models which rely on software-scheduled code, and thus cannot execute
+// arbitrary programs correctly. These are only fuzzed when selected through
+// --proc.
+const std::set<ProcessorID> s_softwareScheduledModels = {
+    ProcessorID::RV32_5S_NO_FW_HZ, ProcessorID::RV32_5S_NO_HZ,
+    ProcessorID::RV64_5S_NO_FW_HZ, ProcessorID::RV64_5S_NO_HZ};
+
+const QStringList s_extensions = {"M", "C"};
+
+// Size of the data buffer which memory instructions access, in bytes.
+constexpr unsigned s_bufferSize = 256;
+
+// Memory instructions access the data buffer through this register, which is
+// never written by the generated instructions.
+constexpr unsigned s_baseReg = 8;
+
+// Counter of the generated loops, which is only written by the loop
+// instructions.
+constexpr unsigned s_loopReg = 31;
+
+// Range of the iteration counts of generated loops. Loops iterate more often
+// than the hot threshold of the translating engine, such that their bodies are
+// translated.
+constexpr unsigned s_minLoopIterations = 33;
+constexpr unsigned s_maxLoopIterations = 64;
+
+struct Options {
+  quint64 seed = 0;
+  long long iterations = 100;
+  long long timeLimitS = 0;
+  unsigned length = 100;
+  unsigned jobs = 1;
+  std::vector<unsigned> xlens = {32, 64};
+  QStringList procs;
+  QString outputDir = "fuzz-failures";
+  long long maxCycles = 100000;
+  bool minimize = true;
+};
+
+/// A generated program. Each instruction of the body is labelled with its
+/// index. Branches only target later labels, except for the back-edges of
+/// counted loops, which neither nest nor overlap. Every program thus
+/// terminates by running past the end of its text section. An empty
+/// instruction leaves only its label, which is how programs are minimized.
+struct FuzzProgram {
+  std::vector<QString> init;
+  std::vector<QString> body;
+
+  size_t size() const { return init.size() + body.size(); }
+  QString &at(size_t i) {
+    return i < init.size() ? init[i] : body[i - init.size()];
+  }
+
+  QString render() const {
+    QString out;
+    QTextStream s(&out);
+    s << ".data\nbuf: .zero " << s_bufferSize << "\n.text\n";
+    s << "  la x" << s_baseReg << ", buf\n";
+    for (const auto &line : init)
+      if (!line.isEmpty())
+        s << "  " << line << "\n";
+    for (size_t i = 0; i < body.size(); ++i)
+      s << "L" << i << ": " << body[i] << "\n";
+    s << "L" << body.size() << ":\n";
+    return out;
+  }
+};
+
+class ProgramGenerator {
+public:
+  ProgramGenerator(unsigned xlen, quint64 seed) : m_xlen(xlen), m_rng(seed) {}
+
+  FuzzProgram generate(unsigned length) {
+    FuzzProgram program;
+    for (unsigned r = 1; r < 32; ++r) {
+      if (!reserved(r))
+        program.init.push_back("li " + reg(r) + ", " +
+                               QString::number(value()));
+    }
+    program.init.push_back("li " + reg(s_loopReg) + ", 0");
+    while (program.body.size() < length) {
+      const unsigned i = program.body.size();
+      const unsigned bodyLength = uniform(2, 12);
+      if (i + bodyLength + 2 <= length && chance(5))
+        loop(program, bodyLength, length);
+      else
+        program.body.push_back(instruction(i, length));
+    }
+    return program;
+  }
+
+private:
+  long long uniform(long long lo, long long hi) {
+    return std::uniform_int_distribution<long long>(lo, hi)(m_rng);
+  }
+  bool chance(unsigned percent) { return uniform(0, 99) < percent; }
+  template <typename T>
+  const T &pick(const std::vector<T> &v) {
+    return v.at(uniform(0, v.size() - 1));
+  }
+
+  static QString reg(unsigned r) { return "x" + QString::number(r); }
+  /// Registers which are not written by generated instructions.
+  static bool reserved(unsigned r) { return r == s_baseReg || r == s_loopReg; }
+  /// Any register.
+  QString src() { return reg(uniform(0, 31)); }
+  /// Any register but the reserved registers.
+  QString dst() {
+    unsigned r;
+    do {
+      r = uniform(0, 31);
+    } while (reserved(r));
+    return reg(r);
+  }
+  /// A nonzero destination register.
+  QString dstNonZero() {
+    unsigned r;
+    do {
+      r = uniform(1, 31);
+    } while (reserved(r));
+    return reg(r);
+  }
+  /// A register of the compressed register set (x8-x15); @p writable excludes
+  /// the memory base register.
+  QString creg(bool writable) {
+    return reg(uniform(writable ? s_baseReg + 1 : 8, 15));
+  }
+  /// A forward branch target within reach of all branch encodings.
+  QString target(unsigned i, unsigned length) {
+    return "L" + QString::number(
+                     uniform(i + 1, std::min<long long>(i + 16, length)));
+  }
+
+  /// Appends a loop of @p bodyLength random instructions to @p program,
+  /// iterating between s_minLoopIterations and s_maxLoopIterations times. The
+  /// decrement and back-edge share a label, such that the counter is
+  /// decremented on every iteration. A loop entered by a branch past its
+  /// initialization uses the remaining count of an earlier loop, which is at
+  /// most s_maxLoopIterations.
+  void loop(FuzzProgram &program, unsigned bodyLength, unsigned length) {
+    const unsigned head = program.body.size();
+    program.body.push_back(
+        "li " + reg(s_loopReg) + ", " +
+        QString::number(uniform(s_minLoopIterations, s_maxLoopIterations)));
+    for (unsigned i = 1; i <= bodyLength; ++i)
+      program.body.push_back(instruction(head + i, length));
+    program.body.push_back("addi " + reg(s_loopReg) + ", " + reg(s_loopReg) +
+                           ", -1\n  blt x0, " + reg(s_loopReg) + ", L" +
+                           QString::number(head + 1));
+  }
+
+  /// A register value, biased towards edge cases.
+  long long value() {
+    switch (uniform(0, 3)) {
+    case 0:
+      return pick<long long>({0, 1, -1, INT32_MIN, INT32_MAX, 0x80, 0xFF});
+    case 1:
+      return uniform(-64, 64);
+    default:
+      return uniform(INT32_MIN, INT32_MAX);
+    }
+  }
+
+  QString instruction(unsigned i, unsigned length) {
+    const unsigned shamtMax = m_xlen - 1;
+    const unsigned kind = uniform(0, 99);
+    if (kind < 25) {
+      std::vector<QString> ops = {"add",  "sub",    "sll",   "slt",  "sltu",
+                                  "xor",  "srl",    "sra",   "or",   "and",
+                                  "mul",  "mulh",   "mulhsu", "mulhu", "div",
+                                  "divu", "rem",    "remu"};
+      if (m_xlen == 64)
+        ops.insert(ops.end(), {"addw", "subw", "sllw", "srlw", "sraw", "mulw",
+                               "divw", "divuw", "remw", "remuw"});
+      return pick(ops) + " " + dst() + ", " + src() + ", " + src();
+    }
+    if (kind < 45) {
+      std::vector<QString> ops = {"addi", "slti", "sltiu",
+                                  "xori", "ori",  "andi"};
+      if (m_xlen == 64)
+        ops.push_back("addiw");
+      return pick(ops) + " " + dst() + ", " + src() + ", " +
+             QString::number(uniform(-2048, 2047));
+    }
+    if (kind < 53) {
+      if (m_xlen == 64 && chance(30))
+        return pick<QString>({"slliw", "srliw", "sraiw"}) + " " + dst() +
+               ", " + src() + ", " + QString::number(uniform(0, 31));
+      return pick<QString>({"slli", "srli", "srai"}) + " " + dst() + ", " +
+             src() + ", " + QString::number(uniform(0, shamtMax));
+    }
+    if (kind < 57) {
+      return pick<QString>({"lui", "auipc"}) + " " + dst() + ", " +
+             QString::number(uniform(0, 0xFFFFF));
+    }
+    if (kind < 67) {
+      std::vector<std::pair<QString, unsigned>> ops = {
+          {"lb", 1}, {"lbu", 1}, {"lh", 2}, {"lhu", 2}, {"lw", 4}};
+      if (m_xlen == 64)
+        ops.insert(ops.end(), {{"lwu", 4}, {"ld", 8}});
+      const auto &op = pick(ops);
+      return op.first + " " + dst() + ", " + offset(op.second) + "(" +
+             reg(s_baseReg) + ")";
+    }
+    if (kind < 75) {
+      std::vector<std::pair<QString, unsigned>> ops = {
+          {"sb", 1}, {"sh", 2}, {"sw", 4}};
+      if (m_xlen == 64)
+        ops.push_back({"sd", 8});
+      const auto &op = pick(ops);
+      return op.first + " " + src() + ", " + offset(op.second) + "(" +
+             reg(s_baseReg) + ")";
+    }
+    if (kind < 84) {
+      return pick<QString>({"beq", "bne", "blt", "bge", "bltu", "bgeu"}) +
+             " " + src() + ", " + src() + ", " + target(i, length);
+    }
+    if (kind < 87)
+      return "jal " + dst() + ", " + target(i, length);
+    return compressed();
+  }
+
+  /// An aligned offset of a @p width byte access into the data buffer.
+  QString offset(unsigned width) {
+    return QString::number(uniform(0, s_bufferSize / width - 1) * width);
+  }
+
+  /// A compressed integer computational instruction. Compressed memory and
+  /// control flow instructions are not generated.
+  QString compressed() {
+    const unsigned shamtMax = m_xlen - 1;
+    auto nonzeroImm = [&] {
+      long long imm;
+      do {
+        imm = uniform(-32, 31);
+      } while (imm == 0);
+      return QString::number(imm);
+    };
+    switch (uniform(0, m_xlen == 64 ? 9 : 7)) {
+    case 0:
+      return "c.addi " + dstNonZero() + ", " + nonzeroImm();
+    case 1:
+      return "c.li " + dstNonZero() + ", " + QString::number(uniform(-32, 31));
+    case 2:
+      return "c.mv " + dstNonZero() + ", " + reg(uniform(1, 31));
+    case 3:
+      return "c.add " + dstNonZero() + ", " + reg(uniform(1, 31));
+    case 4:
+      return pick<QString>({"c.sub", "c.xor", "c.or", "c.and"}) + " " +
+             creg(true) + ", " + creg(false);
+    case 5:
+      return "c.andi " + creg(true) + ", " + QString::number(uniform(-32, 31));
+    case 6:
+      return pick<QString>({"c.srli", "c.srai"}) + " " + creg(true) + ", " +
+             QString::number(uniform(1, shamtMax));
+    case 7:
+      return "c.slli " + dstNonZero() + ", " +
+             QString::number(uniform(1, shamtMax));
+    case 8:
+      return pick<QString>({"c.addw", "c.subw"}) + " " + creg(true) + ", " +
+             creg(false);
+    default:
+      return "c.addiw " + dstNonZero() + ", " +
+             QString::number(uniform(-32, 31));
+    }
+  }
+
+  unsigned m_xlen;
+  std::mt19937_64 m_rng;
+};
+
+/// Assembles programs for an ISA. Assemblers are only used from the main
+/// thread.
+class FuzzAssembler {
+public:
+  FuzzAssembler(unsigned xlen) {
+    if (xlen == 32) {
+      m_isa32 = std::make_unique<ISAInfo<ISA::RV32I>>(s_extensions);
+      m_assembler = std::make_unique<RV32I_Assembler>(m_isa32.get());
+    } else {
+      m_isa64 = std::make_unique<ISAInfo<ISA::RV64I>>(s_extensions);
+      m_assembler = std::make_unique<RV64I_Assembler>(m_isa64.get());
+    }
+  }
+
+  std::shared_ptr<const Program> assemble(const FuzzProgram &program,
+                                          QString &err) {
+    auto res = m_assembler->assembleRaw(program.render());
+    if (!res.errors.empty()) {
+      err = res.errors.toString();
+      return nullptr;
+    }
+    return std::make_shared<Program>(res.program);
+  }
+
+private:
+  std::unique_ptr<ISAInfo<ISA::RV32I>> m_isa32;
+  std::unique_ptr<ISAInfo<ISA::RV64I>> m_isa64;
+  std::unique_ptr<Assembler::AssemblerBase> m_assembler;
+};
+
+Cosimulator::Model referenceModel(unsigned xlen) {
+  return {xlen == 32 ? ProcessorID::RV32_SS : ProcessorID::RV64_SS,
+          ProcessorEngine::Compiled};
+}
+
+QString modelName(const Cosimulator::Model &model) {
+  QString name = enumToString<ProcessorID>(model.id);
+  if (model.engine == ProcessorEngine::Compiled)
+    name += "-compiled";
+  else if (model.engine == ProcessorEngine::Translated)
+    name += "-translated";
+  return name;
+}
+
+std::optional<QString> cosimulate(const Options &options, unsigned xlen,
+                                  const Cosimulator::Model &model,
+                                  const std::shared_ptr<const Program> &p) {
+  Cosimulator cosimulator(referenceModel(xlen), model, s_extensions);
+  return cosimulator.run(p, options.maxCycles).error;
+}
+
+/// Removes instructions from @p program for as long as it still fails on
+/// @p model.
+FuzzProgram minimize(const Options &options, unsigned xlen,
+                     const Cosimulator::Model &model, FuzzAssembler &assembler,
+                     FuzzProgram program) {
+  auto fails = [&](const FuzzProgram &candidate) {
+    QString err;
+    const auto p = assembler.assemble(candidate, err);
+    return p && cosimulate(options, xlen, model, p).has_value();
+  };
+  for (size_t chunk = program.size() / 2; chunk > 0; chunk /= 2) {
+    for (size_t start = 0; start < program.size(); start += chunk) {
+      FuzzProgram candidate = program;
+      bool changed = false;
+      for (size_t i = start; i < std::min(start + chunk, program.size()); ++i) {
+        changed |= !candidate.at(i).isEmpty();
+        candidate.at(i).clear();
+      }
+      if (changed && fails(candidate))
+        program = candidate;
+    }
+  }
+  return program;
+}
+
+struct Task {
+  unsigned xlen;
+  quint64 seed;
+  FuzzProgram program;
+  std::shared_ptr<const Program> assembled;
+  Cosimulator::Model model;
+  std::optional<QString> error;
+};
+
+/// The models to fuzz. Processors which provide a compiled model are fuzzed
+/// with it as well. For compiled models which translate, the translating
+/// engine is fuzzed instead, the reference model being the interpreting
+/// compiled model.
+std::vector<Cosimulator::Model> selectedModels(const Options &options,
+                                               unsigned xlen) {
+  std::vector<Cosimulator::Model> models;
+  for (const auto &it : ProcessorRegistry::getAvailableProcessors()) {
+    const auto &desc = *it.second;
+    if (desc.isaInfo().isa->bits() != xlen)
+      continue;
+    const QString name = enumToString<ProcessorID>(desc.id);
+    if (options.procs.isEmpty() ? s_softwareScheduledModels.count(desc.id)
+                                : !options.procs.contains(name))
+      continue;
+    models.push_back({desc.id, ProcessorEngine::VSRTL});
+    if (desc.hasTranslatedEngine())
+      models.push_back({desc.id, ProcessorEngine::Translated});
+    else if (desc.hasCompiledEngine())
+      models.push_back({desc.id, ProcessorEngine::Compiled});
+  }
+  return models;
+}
+
+/// Runs @p tasks on options.jobs worker threads.
+void runTasks(const Options &options, std::vector<Task> &tasks) {
+  std::atomic<size_t> next{0};
+  auto worker = [&] {
+    for (size_t i = next++; i < tasks.size(); i = next++) {
+      auto &task = tasks[i];
+      task.error = cosimulate(options, task.xlen, task.model, task.assembled);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (unsigned i = 1; i < options.jobs; ++i)
+    threads.emplace_back(worker);
+  worker();
+  for (auto &thread : threads)
+    thread.join();
+}
+
+QString writeFailure(const Options &options, const Task &task,
+                     const FuzzProgram &program) {
+  const QString name = modelName(task.model);
+  const QString path = QDir(options.outputDir)
+                           .filePath("fuzz-" + name + "-" +
+                                     QString::number(task.seed) + ".s");
+  QFile file(path);
+  if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    return QString();
+  QTextStream s(&file);
+  s << "# Differential fuzzing failure on " << name << " (seed "
+    << task.seed << ", ISA extensions " << s_extensions.join("") << ")\n";
+  for (const auto &line : task.error->split('\n'))
+    s << "# " << line << "\n";
+  s << program.render();
+  return path;
+}
+
+int runFuzzer(const Options &options) {
+  if (!QDir().mkpath(options.outputDir)) {
+    std::cerr << "ERROR: Failed to create output directory" << std::endl;
+    return 1;
+  }
+
+  std::map<unsigned, std::unique_ptr<FuzzAssembler>> assemblers;
+  std::map<unsigned, std::vector<Cosimulator::Model>> models;
+  for (const unsigned xlen : options.xlens) {
+    assemblers[xlen] = std::make_unique<FuzzAssembler>(xlen);
+    models[xlen] = selectedModels(options, xlen);
+  }
+
+  QElapsedTimer timer;
+  timer.start();
+  long long programs = 0;
+  long long runs = 0;
+  QJsonArray failures;
+  // Each batch generates a program per worker and ISA, and cosimulates each
+  // of them on all selected processors.
+  for (long long iteration = 0;
+       options.iterations == 0 || iteration < options.iterations;) {
+    if (options.timeLimitS != 0 && timer.elapsed() >= options.timeLimitS * 1000)
+      break;
+
+    std::vector<Task> tasks;
+    for (unsigned j = 0; j < options.jobs; ++j, ++iteration) {
+      if (options.iterations != 0 && iteration >= options.iterations)
+        break;
+      const quint64 seed = options.seed + iteration;
+      for (const unsigned xlen : options.xlens) {
+        const auto program = ProgramGenerator(xlen, seed).generate(
+            options.length);
+        QString err;
+        const auto assembled = assemblers[xlen]->assemble(program, err);
+        if (!assembled) {
+          std::cerr << "ERROR: Generated program (seed " << seed
+                    << ") failed to assemble:\n"
+                    << err.toStdString() << std::endl;
+          return 1;
+        }
+        programs++;
+        for (const auto &model : models[xlen])
+          tasks.push_back({xlen, seed, program, assembled, model, {}});
+      }
+    }
+    runTasks(options, tasks);
+    runs += tasks.size();
+
+    for (const auto &task : tasks) {
+      if (!task.error)
+        continue;
+      const QString name = modelName(task.model);
+      std::cerr << "FAIL: " << name.toStdString() << " (seed " << task.seed
+                << ")" << std::endl;
+      const FuzzProgram program =
+          options.minimize ? minimize(options, task.xlen, task.model,
+                                      *assemblers[task.xlen], task.program)
+                           : task.program;
+      QJsonObject failure;
+      failure.insert("proc", name);
+      failure.insert("seed", QString::number(task.seed));
+      failure.insert("file", writeFailure(options, task, program));
+      failure.insert("error", *task.error);
+      failures.append(failure);
+    }
+    std::cerr << "Programs: " << programs << "\tCosimulations: " << runs
+              << "\tFailures: " << failures.size() << std::endl;
+  }
+
+  QJsonObject out;
+  out.insert("seed", QString::number(options.seed));
+  out.insert("programs", programs);
+  out.insert("cosimulations", runs);
+  out.insert("wallMs", timer.elapsed());
+  out.insert("failures", failures);
+  std::cout << QJsonDocument(out).toJson(QJsonDocument::Indented).toStdString();
+  return failures.isEmpty() ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  QCoreApplication app(argc, argv);
+
+  QCommandLineParser parser;
+  parser.setApplicationDescription(
+      "Ripes differential fuzzer. Cosimulates random programs on all "
+      "processor models against the single-cycle model.");
+  parser.addHelpOption();
+  parser.addOption(QCommandLineOption(
+      "seed", "Seed of the first program (default: current time).", "seed"));
+  parser.addOption(QCommandLineOption(
+      "iterations", "Number of programs to generate per ISA (0: unlimited).",
+      "n", "100"));
+  parser.addOption(QCommandLineOption(
+      "time", "Stop after this many seconds (0: no limit).", "s", "0"));
+  parser.addOption(QCommandLineOption(
+      "length", "Number of instructions per program.", "n", "100"));
+  parser.addOption(QCommandLineOption(
+      "jobs", "Number of worker threads (default: number of cores).", "n"));
+  parser.addOption(QCommandLineOption(
+      "xlen", "Register widths to fuzz [32, 64] (default: both).", "xlen"));
+  parser.addOption(QCommandLineOption(
+      "proc",
+      "Comma-separated list of processors to fuzz (default: all processors "
+      "which do not rely on software-scheduled code).",
+      "procs"));
+  parser.addOption(QCommandLineOption(
+      "output", "Directory in which failing programs are written.", "dir",
+      "fuzz-failures"));
+  parser.addOption(QCommandLineOption(
+      "max-cycles", "Maximum number of cycles of each cosimulation.", "n",
+      "100000"));
+  parser.addOption(QCommandLineOption(
+      "no-minimize", "Do not minimize failing programs."));
+  parser.process(app);
+
+  Options options;
+  bool ok = true;
+  auto number = [&](const QString &name) {
+    bool valid = false;
+    const long long v = parser.value(name).toLongLong(&valid);
+    ok &= valid && v >= 0;
+    return v;
+  };
+  options.seed = parser.isSet("seed")
+                     ? parser.value("seed").toULongLong(&ok)
+                     : QDateTime::currentMSecsSinceEpoch();
+  options.iterations = number("iterations");
+  options.timeLimitS = number("time");
+  options.length = number("length");
+  options.maxCycles = number("max-cycles");
+  options.jobs = parser.isSet("jobs")
+                     ? number("jobs")
+                     : std::max(1u, std::thread::hardware_concurrency());
+  if (parser.isSet("xlen")) {
+    const unsigned xlen = number("xlen");
+    ok &= xlen == 32 || xlen == 64;
+    options.xlens = {xlen};
+  }
+  if (parser.isSet("proc"))
+    options.procs = parser.value("proc").split(",");
+  options.outputDir = parser.value("output");
+  options.minimize = !parser.isSet("no-minimize");
+  if (!ok || options.jobs == 0 || options.length == 0) {
+    std::cerr << "ERROR: Invalid arguments" << std::endl;
+    parser.showHelp(1);
+  }
+
+  return runFuzzer(options);
+}
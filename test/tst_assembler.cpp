@@ -4,11 +4,16 @@
 #include "assembler/matcher.h"
 #include "isa/isainfo.h"
 #include "isa/rv32isainfo.h"
+#include "isa/rv64isainfo.h"
+#include "isa/rvinstrtable.h"
 
 #include "assembler/rv32i_assembler.h"
 #include "assembler/rv64i_assembler.h"
 
 #include "processorhandler.h"
+#include "programcache.h"
+
+#include <QBuffer>
 
 using namespace Ripes;
 using namespace Assembler;
@@ -47,6 +52,10 @@ private slots:
   void tst_stringDirectives();
   void tst_riscv();
   void tst_relativeLabels();
+  void tst_linkUnits();
+  void tst_instrTable();
+  void tst_csr();
+  void tst_programCache();
 
 private:
   QString createProgram(int entries) {
@@ -64,6 +73,22 @@ private:
     return out;
   }
 
+  /// Checks that each instruction of the instruction table which is
+  /// available to @p assembler is matched from its encoding.
+  template <typename T_Assembler>
+  void testInstrTable(T_Assembler &assembler, unsigned xlen) {
+    for (const auto &enc : RVISA::Instructions) {
+      if (!enc.availableIn(xlen, true))
+        continue;
+      auto match = assembler.getMatcher().matchInstruction(enc.match());
+      if (auto *error = std::get_if<Error>(&match))
+        QFAIL(error->toString().toStdString().c_str());
+      auto *instr =
+          std::get<const typename T_Assembler::_Instruction *>(match);
+      QCOMPARE(instr->name(), QString(enc.mnemonic));
+    }
+  }
+
   enum class Expect { Fail, Success };
   void testAssemble(const QStringList &program, Expect expect,
                     QByteArray expectData = {}) {
@@ -378,6 +403,52 @@ void tst_Assembler::tst_relativeLabels() {
                Expect::Fail);
 }
 
+void tst_Assembler::tst_linkUnits() {
+  auto isa = std::make_unique<ISAInfo<ISA::RV32I>>(QStringList());
+  auto assembler = RV32I_Assembler(isa.get());
+
+  const QString main = ".data\n"
+                       "a: .word 1\n"
+                       ".text\n"
+                       ".globl main\n"
+                       "main: la a0, a\n"
+                       "call lib\n"
+                       "loop: j loop\n";
+  const QString lib = ".data\n"
+                      "b: .word 2\n"
+                      ".text\n"
+                      ".global lib\n"
+                      "lib: la a1, b\n"
+                      "lw a1, 0(a1)\n"
+                      "loop: j loop\n"
+                      "ret\n";
+
+  // Linking the units should yield the same program as assembling their
+  // concatenation, once unit-local symbols have been made unique.
+  auto linked = assembler.assembleUnits({{"main.s", main}, {"lib.s", lib}});
+  if (!linked.errors.empty()) {
+    linked.errors.print();
+    QFAIL("Expected linking to succeed");
+  }
+  auto concatenated =
+      assembler.assembleRaw(main + QString(lib).replace("loop", "loop2"));
+  QVERIFY(concatenated.errors.empty());
+  for (const auto &section : concatenated.program.sections) {
+    QCOMPARE(linked.program.getSection(section.first)->data,
+             section.second.data);
+  }
+
+  // Symbols are only visible to other units when declared global.
+  auto undefined = assembler.assembleUnits(
+      {{"main.s", main}, {"lib.s", QString(lib).replace(".global", "#")}});
+  QVERIFY(!undefined.errors.empty());
+
+  // Global symbols must be unique across units.
+  auto duplicate = assembler.assembleUnits(
+      {{"main.s", main}, {"lib.s", lib + ".globl main\nmain: nop\n"}});
+  QVERIFY(!duplicate.errors.empty());
+}
+
 void tst_Assembler::tst_matcher() {
   auto isa = std::make_unique<ISAInfo<ISA::RV32I>>(QStringList());
   auto assembler = RV32I_Assembler(isa.get());
@@ -418,5 +489,87 @@ void tst_Assembler::tst_matcher() {
   }
 }
 
+void tst_Assembler::tst_instrTable() {
+  auto isa32 = std::make_unique<ISAInfo<ISA::RV32I>>(QStringList{"M"});
+  auto assembler32 = RV32I_Assembler(isa32.get());
+  testInstrTable(assembler32, 32);
+
+  auto isa64 = std::make_unique<ISAInfo<ISA::RV64I>>(QStringList{"M"});
+  auto assembler64 = RV64I_Assembler(isa64.get());
+  testInstrTable(assembler64, 64);
+}
+
+void tst_Assembler::tst_csr() {
+  testAssemble(QStringList() << "csrrw x0 0xC00 a1"
+                             << "csrrsi a0 mhpmcounter3 1"
+                             << "csrr a0 cycle"
+                             << "rdinstret t0"
+                             << "rdcycleh a1",
+               Expect::Success);
+  testAssemble(QStringList() << "csrr a0 foo", Expect::Fail);
+  testAssemble(QStringList() << "csrrw a0 4096 a1", Expect::Fail);
+
+  // csrrs a0, cycle, x0
+  auto isa = std::make_unique<ISAInfo<ISA::RV32I>>(QStringList());
+  auto assembler = RV32I_Assembler(isa.get());
+  auto disres = assembler.disassemble(0xC0002573, {});
+  QCOMPARE(disres.repr, QString("csrrs x10 cycle x0"));
+}
+
+void tst_Assembler::tst_programCache() {
+  auto isa = std::make_unique<ISAInfo<ISA::RV32I>>(QStringList());
+  auto assembler = RV32I_Assembler(isa.get());
+  auto res = assembler.assembleRaw(".data\n"
+                                   "a: .word 1 2 3\n"
+                                   ".align 4\n"
+                                   "b: .string \"abc\"\n"
+                                   ".text\n"
+                                   "main: la a0, a\n"
+                                   "loop: addi a0 a0 1\n"
+                                   "beqz a0 loop\n"
+                                   ".equ c, 42\n");
+  QVERIFY(res.errors.empty());
+  const Program &program = res.program;
+  QVERIFY(!program.symbols.empty());
+  QVERIFY(!program.sourceMapping.empty());
+
+  // A program must round-trip unchanged through the cache format.
+  QBuffer buffer;
+  buffer.open(QIODevice::ReadWrite);
+  QDataStream out(&buffer);
+  ProgramCache::writeProgram(out, program);
+  buffer.seek(0);
+  QDataStream in(&buffer);
+  const auto loaded = ProgramCache::readProgram(in);
+  QVERIFY(loaded.has_value());
+
+  QCOMPARE(loaded->entryPoint, program.entryPoint);
+  QCOMPARE(loaded->sourceHash, program.sourceHash);
+  QCOMPARE(loaded->sections.size(), program.sections.size());
+  for (const auto &[name, section] : program.sections) {
+    const auto *loadedSection = loaded->getSection(name);
+    QVERIFY(loadedSection);
+    QCOMPARE(loadedSection->name, section.name);
+    QCOMPARE(loadedSection->address, section.address);
+    QCOMPARE(loadedSection->data, section.data);
+    QCOMPARE(loadedSection->alignment, section.alignment);
+  }
+  QCOMPARE(loaded->symbols.size(), program.symbols.size());
+  for (const auto &[address, symbol] : program.symbols) {
+    const auto it = loaded->symbols.find(address);
+    QVERIFY(it != loaded->symbols.end());
+    QCOMPARE(it->second.v, symbol.v);
+    QCOMPARE(it->second.type, symbol.type);
+  }
+  QVERIFY(loaded->sourceMapping == program.sourceMapping);
+
+  // Truncated entries are rejected.
+  QBuffer truncated;
+  truncated.setData(buffer.data().left(buffer.size() / 2));
+  truncated.open(QIODevice::ReadOnly);
+  QDataStream truncatedIn(&truncated);
+  QVERIFY(!ProgramCache::readProgram(truncatedIn).has_value());
+}
+
 QTEST_APPLESS_MAIN(tst_Assembler)
 #include "tst_assembler.moc"
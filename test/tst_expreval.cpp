@@ -9,6 +9,7 @@ class tst_ExprEval : public QObject {
 
 private slots:
   void tst_binops();
+  void tst_parsedExpr();
 };
 
 void expect(const ExprEvalRes &res, const ExprEvalVT &expected) {
@@ -27,5 +28,35 @@ void tst_ExprEval::tst_binops() {
   expect(evaluate(Location::unknown(), "(B *(3+ 4))+4", &symbols.abs), 18);
 }
 
+void tst_ExprEval::tst_parsedExpr() {
+  // A parsed expression may be reevaluated as its symbols are resolved.
+  ExprCache cache;
+  auto parsed = cache.get(Location::unknown(), "(2*(3+4))+B");
+  QVERIFY(std::holds_alternative<ExprPtr>(parsed));
+  const auto &expr = std::get<ExprPtr>(parsed);
+  QVERIFY(std::holds_alternative<Error>(
+      evaluate(Location::unknown(), expr, SymbolLookup())));
+  auto lookup = [](const QString &name) -> std::optional<ExprEvalVT> {
+    if (name == "B")
+      return 4;
+    return std::nullopt;
+  };
+  expect(evaluate(Location::unknown(), expr, lookup), 18);
+
+  // Errors are reported for every evaluation of a cached expression.
+  QVERIFY(std::holds_alternative<Error>(cache.get(Location(1), "1+2)")));
+  QVERIFY(std::holds_alternative<Error>(cache.get(Location(2), "1+2)")));
+  QVERIFY(std::holds_alternative<Error>(evaluate(Location::unknown(), "1/0")));
+
+  // The most negative value divided by -1 overflows, also when folded at
+  // parse time.
+  const QString min = "((0-4611686018427387904)*2)";
+  expect(evaluate(Location::unknown(), min), INT64_MIN);
+  QVERIFY(std::holds_alternative<Error>(
+      evaluate(Location::unknown(), min + "/(0-1)")));
+  QVERIFY(std::holds_alternative<Error>(
+      evaluate(Location::unknown(), min + "%(0-1)")));
+}
+
 QTEST_APPLESS_MAIN(tst_ExprEval)
 #include "tst_expreval.moc"
@@ -3,11 +3,15 @@
 #include <QStringList>
 #include <QtTest/QTest>
 
+#include <map>
+
 #include "processorhandler.h"
 #include "processorregistry.h"
 #include "ripessettings.h"
 
 #include "assembler/rv32i_assembler.h"
+#include "processors/RISC-V/rv_batchexecutor.h"
+#include "processors/RISC-V/rv_translator.h"
 
 #if !defined(RISCV32_TEST_DIR) || !defined(RISCV64_TEST_DIR) ||                \
     !defined(RISCV32_C_TEST_DIR) || !defined(RISCV64_C_TEST_DIR)
@@ -54,7 +58,8 @@ private:
   QString m_currentTest;
 
   void runTests(const ProcessorID &id, const QStringList &extensions,
-                const QStringList &testdirs);
+                const QStringList &testdirs,
+                ProcessorEngine engine = ProcessorEngine::VSRTL);
 
   void trapHandler();
 
@@ -68,10 +73,25 @@ private slots:
     runTests(ProcessorID::RV64_SS, {"M", "C"},
              {RISCV64_TEST_DIR, RISCV64_C_TEST_DIR});
   }
+  void testRV64_SingleCycleCompiled() {
+    runTests(ProcessorID::RV64_SS, {"M", "C"},
+             {RISCV64_TEST_DIR, RISCV64_C_TEST_DIR},
+             ProcessorEngine::Compiled);
+  }
+  void testRV64_SingleCycleTranslated() {
+    runTests(ProcessorID::RV64_SS, {"M", "C"},
+             {RISCV64_TEST_DIR, RISCV64_C_TEST_DIR},
+             ProcessorEngine::Translated);
+  }
   void testRV64_5StagePipeline() {
     runTests(ProcessorID::RV64_5S, {"M", "C"},
              {RISCV64_TEST_DIR, RISCV64_C_TEST_DIR});
   }
+  void testRV64_5StagePipelineCompiled() {
+    runTests(ProcessorID::RV64_5S, {"M", "C"},
+             {RISCV64_TEST_DIR, RISCV64_C_TEST_DIR},
+             ProcessorEngine::Compiled);
+  }
   void testRV64_5StagePipelineNOFW() {
     runTests(ProcessorID::RV64_5S_NO_FW, {"M", "C"},
              {RISCV64_TEST_DIR, RISCV64_C_TEST_DIR});
@@ -85,10 +105,25 @@ private slots:
     runTests(ProcessorID::RV32_SS, {"M", "C"},
              {RISCV32_TEST_DIR, RISCV32_C_TEST_DIR});
   }
+  void testRV32_SingleCycleCompiled() {
+    runTests(ProcessorID::RV32_SS, {"M", "C"},
+             {RISCV32_TEST_DIR, RISCV32_C_TEST_DIR},
+             ProcessorEngine::Compiled);
+  }
+  void testRV32_SingleCycleTranslated() {
+    runTests(ProcessorID::RV32_SS, {"M", "C"},
+             {RISCV32_TEST_DIR, RISCV32_C_TEST_DIR},
+             ProcessorEngine::Translated);
+  }
   void testRV32_5StagePipeline() {
     runTests(ProcessorID::RV32_5S, {"M", "C"},
              {RISCV32_TEST_DIR, RISCV32_C_TEST_DIR});
   }
+  void testRV32_5StagePipelineCompiled() {
+    runTests(ProcessorID::RV32_5S, {"M", "C"},
+             {RISCV32_TEST_DIR, RISCV32_C_TEST_DIR},
+             ProcessorEngine::Compiled);
+  }
   void testRV32_5StagePipelineNOFW() {
     runTests(ProcessorID::RV32_5S_NO_FW, {"M", "C"},
              {RISCV32_TEST_DIR, RISCV32_C_TEST_DIR});
@@ -97,6 +132,11 @@ private slots:
     runTests(ProcessorID::RV32_6S_DUAL, {"M", "C"},
              {RISCV32_TEST_DIR, RISCV32_C_TEST_DIR});
   }
+
+  void testBatchLockstep();
+  void testBatchConsoleIO();
+  void testTranslatedMatchesCompiled();
+  void testCounterCSRs();
 };
 
 bool tst_RISCV::skipTest(const QString &test) {
@@ -180,11 +220,11 @@ QString tst_RISCV::executeSimulator() {
 }
 
 void tst_RISCV::runTests(const ProcessorID &id, const QStringList &extensions,
-                         const QStringList &testDirs) {
+                         const QStringList &testDirs, ProcessorEngine engine) {
   for (auto testDir : testDirs) {
     const auto dir = QDir(testDir);
     const auto testFiles = dir.entryList({"*.s"});
-    ProcessorHandler::selectProcessor(id, extensions);
+    ProcessorHandler::selectProcessor(id, extensions, {}, engine);
 
     for (const auto &test : testFiles) {
       auto testPath = testDir + QString(QDir::separator()) + test;
@@ -227,5 +267,426 @@ void tst_RISCV::runTests(const ProcessorID &id, const QStringList &extensions,
   }
 }
 
+// Counts the steps of the Collatz sequence starting at a0, such that lanes of
+// a batch diverge and reconverge.
+static constexpr auto s_collatzProgram = R"(
+  li a1, 0
+  li t0, 1
+loop:
+  beq a0, t0, done
+  andi t1, a0, 1
+  beqz t1, even
+  slli t2, a0, 1
+  add a0, a0, t2
+  addi a0, a0, 1
+  j next
+even:
+  srai a0, a0, 1
+next:
+  addi a1, a1, 1
+  j loop
+done:
+  mv a0, a1
+  li a7, 1
+  ecall
+  li a7, 10
+  ecall
+)";
+
+void tst_RISCV::testBatchLockstep() {
+  constexpr unsigned lanes = 64;
+  ProcessorHandler::selectProcessor(ProcessorID::RV32_SS, {"M"}, {},
+                                    ProcessorEngine::Compiled);
+  const auto res =
+      ProcessorHandler::getAssembler()->assembleRaw(s_collatzProgram);
+  QVERIFY(res.errors.empty());
+  const auto program = std::make_shared<Program>(res.program);
+  // The lanes execute the text section of the loaded program.
+  ProcessorHandler::loadProgram(program);
+
+  RVBatchMemory memory;
+  for (const auto &section : program->sections)
+    memory.write(section.second.address, section.second.data.constData(),
+                 section.second.data.size());
+  RVBatchExecutor<uint32_t> batch(ProcessorHandler::currentISA(), lanes,
+                                  memory, program->entryPoint);
+  for (unsigned lane = 0; lane < lanes; ++lane)
+    batch.setRegister(lane, 10, lane + 1);
+  batch.run(
+      [&](uint32_t pc) { return ProcessorHandler::isExecutableAddress(pc); });
+
+  // Each lane must match a sequential run of the same register initialization.
+  for (unsigned lane = 0; lane < lanes; ++lane) {
+    ProcessorHandler::selectProcessor(ProcessorID::RV32_SS, {"M"},
+                                      {{10, lane + 1}},
+                                      ProcessorEngine::Compiled);
+    ProcessorHandler::get()->loadProgram(program);
+    RipesSettings::getObserver(RIPES_GLOBALSIGNAL_REQRESET)->trigger();
+    bool exited = false;
+    ProcessorHandler::getProcessorNonConst()->trapHandler = [&] {
+      exited = ProcessorHandler::getProcessor()->getRegister(
+                   RegisterFileType::GPR, 17) == RVABI::Exit;
+    };
+    unsigned cycles = 0;
+    while (!exited && cycles++ < s_maxCycles)
+      ProcessorHandler::getProcessorNonConst()->clock();
+
+    QCOMPARE(batch.status(lane),
+             RVBatchExecutor<uint32_t>::LaneStatus::Exited);
+    QCOMPARE(static_cast<VInt>(batch.getRegister(lane, 10)),
+             ProcessorHandler::getProcessor()->getRegister(
+                 RegisterFileType::GPR, 10));
+    QCOMPARE(batch.instructionsRetired(lane),
+             ProcessorHandler::getProcessor()->getInstructionsRetired());
+    QCOMPARE(QString::fromStdString(batch.output(lane)),
+             QString::number(batch.getRegister(lane, 10)));
+  }
+}
+
+// Echoes up to 16 bytes of console input to stdout, and exits with the number
+// of bytes read.
+static constexpr auto s_echoProgram = R"(
+.data
+buf: .zero 16
+.text
+  li a0, 0
+  la a1, buf
+  li a2, 16
+  li a7, 63
+  ecall
+  mv a2, a0
+  mv s0, a0
+  li a0, 1
+  la a1, buf
+  li a7, 64
+  ecall
+  mv a0, s0
+  li a7, 93
+  ecall
+)";
+
+void tst_RISCV::testBatchConsoleIO() {
+  const std::vector<std::string> inputs = {"", "foo", "a longer input line"};
+  ProcessorHandler::selectProcessor(ProcessorID::RV32_SS, {"M"}, {},
+                                    ProcessorEngine::Compiled);
+  const auto res = ProcessorHandler::getAssembler()->assembleRaw(s_echoProgram);
+  QVERIFY(res.errors.empty());
+  ProcessorHandler::loadProgram(std::make_shared<Program>(res.program));
+
+  RVBatchMemory memory;
+  for (const auto &section : res.program.sections)
+    memory.write(section.second.address, section.second.data.constData(),
+                 section.second.data.size());
+  RVBatchExecutor<uint32_t> batch(ProcessorHandler::currentISA(),
+                                  inputs.size(), memory,
+                                  res.program.entryPoint);
+  for (unsigned lane = 0; lane < inputs.size(); ++lane)
+    batch.setInput(lane, inputs[lane]);
+  batch.run(
+      [&](uint32_t pc) { return ProcessorHandler::isExecutableAddress(pc); });
+
+  for (unsigned lane = 0; lane < inputs.size(); ++lane) {
+    const std::string expected = inputs[lane].substr(0, 16);
+    QCOMPARE(batch.status(lane),
+             RVBatchExecutor<uint32_t>::LaneStatus::Exited);
+    QCOMPARE(batch.output(lane), expected);
+    QCOMPARE(batch.exitCode(lane), static_cast<int>(expected.size()));
+  }
+}
+
+// Syscall of testTranslatedMatchesCompiled, which writes the word a1 to the
+// address a0.
+static constexpr unsigned s_writeWordSyscall = 1000;
+
+// A loop running for long enough for its blocks to be translated. Every 64
+// iterations, a store of the loop rewrites the immediate of the instruction at
+// 'patch' within the same block, and the write syscall rewrites the
+// instruction at 'patch2' in the block following it; otherwise, both write to
+// 'buf'. %1 is replaced by the RV64 word instructions.
+static constexpr auto s_translatedProgram = R"(
+.data
+buf: .zero 64
+.text
+  li s0, 0
+  li s1, 200
+  li s2, 1
+  li s3, 0x12345
+  li s4, 0
+  li s5, 0
+  la s6, buf
+  la s7, patch
+  la s8, patch2
+  lw s9, 0(s7)
+  lw s10, 0(s8)
+loop:
+  add s2, s2, s3
+  xor s3, s3, s2
+  slli t0, s2, 3
+  srli t1, s3, 2
+  srai t2, s2, 1
+  or s4, s4, t0
+  and t1, t1, t2
+  sub s4, s4, t1
+  sltu t3, s3, s2
+  slt t4, s2, s3
+  add s4, s4, t3
+  add s4, s4, t4
+  xori s4, s4, 0x5a
+  sll t5, s4, s0
+  sra t6, s3, s0
+  add s4, s4, t5
+  xor s4, s4, t6
+  mul t0, s2, s3
+  mulh t1, s2, s3
+  mulhu t2, s3, s2
+  mulhsu t3, s4, s3
+  add s4, s4, t0
+  xor s4, s4, t1
+  add s4, s4, t2
+  xor s4, s4, t3
+  addi t3, s0, 3
+  div t4, s2, t3
+  rem t5, s3, t3
+  divu t6, s4, t3
+  remu a2, s4, s0
+  add s4, s4, t4
+  add s4, s4, t5
+  add s4, s4, t6
+  add s4, s4, a2
+  lui t1, 0x80000
+  li t2, -1
+  div t3, t1, t2
+  rem t4, t1, t2
+  add s4, s4, t3
+  add s4, s4, t4
+%1
+  andi t0, s0, 15
+  slli t0, t0, 2
+  add t0, s6, t0
+  lw t1, 0(t0)
+  add t1, t1, s4
+  sw t1, 0(t0)
+  sb s2, 1(t0)
+  lh t2, 0(t0)
+  lbu t3, 3(t0)
+  sh t3, 2(t0)
+  add s5, s5, t2
+  lw t4, 60(s6)
+  add s5, s5, t4
+  andi t0, s0, 63
+  seqz t0, t0
+  neg t0, t0
+  addi t1, s6, 56
+  xor t2, t1, s7
+  and t2, t2, t0
+  xor t1, t1, t2
+  srli t3, s0, 6
+  slli t3, t3, 20
+  add t3, s9, t3
+  sw t3, 0(t1)
+patch:
+  addi s5, s5, 1
+  addi t0, s0, 32
+  andi t0, t0, 63
+  seqz t0, t0
+  neg t0, t0
+  addi a0, s6, 60
+  xor t1, a0, s8
+  and t1, t1, t0
+  xor a0, a0, t1
+  slli a1, s0, 1
+  srli t2, s0, 6
+  addi t2, t2, 1
+  slli t2, t2, 20
+  add t2, s10, t2
+  xor t2, t2, a1
+  and t2, t2, t0
+  xor a1, a1, t2
+  li a7, 1000
+  ecall
+patch2:
+  addi s5, s5, 7
+  addi s0, s0, 1
+  blt s0, s1, loop
+  li a7, 10
+  ecall
+)";
+
+static constexpr auto s_translatedWordOps = R"(
+  addw t0, s2, s3
+  subw t1, s3, s2
+  sllw t2, s2, s0
+  srlw t3, s3, s0
+  sraw t4, s4, s0
+  addiw t5, s2, -7
+  slliw t6, s3, 5
+  srliw a2, s4, 3
+  sraiw a3, s4, 2
+  mulw a4, s2, s3
+  divw a5, s3, t5
+  remw a6, s2, t3
+  divuw a7, s4, t2
+  remuw t5, s3, a3
+  add s4, s4, t0
+  xor s4, s4, t1
+  add s4, s4, t2
+  xor s4, s4, t3
+  add s4, s4, t4
+  xor s4, s4, t5
+  add s4, s4, t6
+  xor s4, s4, a2
+  add s4, s4, a3
+  xor s4, s4, a4
+  add s4, s4, a5
+  xor s4, s4, a6
+  add s4, s4, a7
+)";
+
+void tst_RISCV::testTranslatedMatchesCompiled() {
+  constexpr unsigned maxClocks = 100000;
+  struct Result {
+    std::vector<VInt> regs;
+    QByteArray memory;
+    long long cycles = 0;
+    long long instructions = 0;
+    unsigned clocks = 0;
+  };
+
+  for (const auto id : {ProcessorID::RV32_SS, ProcessorID::RV64_SS}) {
+    const QString source = QString(s_translatedProgram)
+                               .arg(QString(id == ProcessorID::RV64_SS
+                                                ? s_translatedWordOps
+                                                : ""));
+    std::map<ProcessorEngine, Result> results;
+    for (const auto engine :
+         {ProcessorEngine::Compiled, ProcessorEngine::Translated}) {
+      ProcessorHandler::selectProcessor(id, {"M"}, {}, engine);
+      const auto res = ProcessorHandler::getAssembler()->assembleRaw(source);
+      if (!res.errors.empty())
+        QFAIL(res.errors.toString().toStdString().c_str());
+      const auto program = std::make_shared<Program>(res.program);
+      ProcessorHandler::get()->loadProgram(program);
+      RipesSettings::getObserver(RIPES_GLOBALSIGNAL_REQRESET)->trigger();
+
+      auto *proc = ProcessorHandler::getProcessorNonConst();
+      bool exited = false;
+      proc->trapHandler = [&] {
+        const auto reg = [&](unsigned i) {
+          return proc->getRegister(RegisterFileType::GPR, i);
+        };
+        if (reg(17) == s_writeWordSyscall)
+          ProcessorHandler::writeMem(reg(10), reg(11), 4);
+        else
+          exited = reg(17) == RVABI::Exit;
+      };
+      Result &result = results[engine];
+      while (!exited && result.clocks++ < maxClocks)
+        proc->clock();
+      QVERIFY(exited);
+
+      for (unsigned i = 0; i < ProcessorHandler::currentISA()->regCnt(); i++)
+        result.regs.push_back(proc->getRegister(RegisterFileType::GPR, i));
+      for (const auto &section : program->sections) {
+        QByteArray data(section.second.data.size(), 0);
+        ProcessorHandler::readMemBlock(section.second.address, data.data(),
+                                       data.size());
+        result.memory += data;
+      }
+      result.cycles = proc->getCycleCount();
+      result.instructions = proc->getInstructionsRetired();
+
+      // The program must have rewritten its own code.
+      const auto *text = program->getSection(TEXT_SECTION_NAME);
+      QVERIFY(!result.memory.contains(text->data));
+    }
+
+    const Result &compiled = results[ProcessorEngine::Compiled];
+    const Result &translated = results[ProcessorEngine::Translated];
+    for (unsigned i = 0; i < compiled.regs.size(); i++)
+      QCOMPARE(translated.regs.at(i), compiled.regs.at(i));
+    QCOMPARE(translated.memory, compiled.memory);
+    QCOMPARE(translated.cycles, compiled.cycles);
+    QCOMPARE(translated.instructions, compiled.instructions);
+    // Translated blocks execute within a single clock.
+    if (RIPES_RV_TRANSLATOR_HOST)
+      QVERIFY(translated.clocks < translated.instructions);
+  }
+}
+
+// Reads instret and hpmcounter3 (taken branches) before and after a loop of 40
+// iterations, and exits with the differences in a0 and a1. Both reads are
+// preceded by a jump, such that pipelined models are in the same state for
+// both. 84 instructions are retired from the first instret read up to the
+// second: the two reads, the loop counter initialization, 2 * 40 loop
+// instructions and the jump. The loop branch is taken 39 times.
+static constexpr auto s_counterProgram = R"(
+  j first
+first:
+  csrr s0, instret
+  csrr s2, hpmcounter3
+  li t0, 40
+loop:
+  addi t0, t0, -1
+  bnez t0, loop
+  j second
+second:
+  csrr s1, instret
+  csrr s3, hpmcounter3
+  sub a0, s1, s0
+  sub a1, s3, s2
+  li a7, 10
+  ecall
+)";
+
+void tst_RISCV::testCounterCSRs() {
+  // Models without hazard detection require scheduled code, and are not
+  // tested (see runTests).
+  for (const auto id :
+       {ProcessorID::RV32_SS, ProcessorID::RV32_5S, ProcessorID::RV32_5S_NO_FW,
+        ProcessorID::RV32_6S_DUAL, ProcessorID::RV64_SS, ProcessorID::RV64_5S,
+        ProcessorID::RV64_5S_NO_FW, ProcessorID::RV64_6S_DUAL}) {
+    std::vector<ProcessorEngine> engines = {ProcessorEngine::VSRTL};
+    const auto &desc = ProcessorRegistry::getDescription(id);
+    if (desc.hasCompiledEngine())
+      engines.push_back(ProcessorEngine::Compiled);
+    if (desc.hasTranslatedEngine())
+      engines.push_back(ProcessorEngine::Translated);
+
+    for (const auto engine : engines) {
+      ProcessorHandler::selectProcessor(id, {"M"}, {}, engine);
+      const auto res =
+          ProcessorHandler::getAssembler()->assembleRaw(s_counterProgram);
+      if (!res.errors.empty())
+        QFAIL(res.errors.toString().toStdString().c_str());
+      ProcessorHandler::get()->loadProgram(
+          std::make_shared<Program>(res.program));
+      RipesSettings::getObserver(RIPES_GLOBALSIGNAL_REQRESET)->trigger();
+
+      bool exited = false;
+      VInt instructions = 0;
+      VInt takenBranches = 0;
+      auto *proc = ProcessorHandler::getProcessorNonConst();
+      proc->trapHandler = [&] {
+        instructions = proc->getRegister(RegisterFileType::GPR, 10);
+        takenBranches = proc->getRegister(RegisterFileType::GPR, 11);
+        exited = true;
+      };
+      unsigned cycles = 0;
+      while (!exited && cycles++ < s_maxCycles)
+        proc->clock();
+
+      m_currentTest = enumToString<ProcessorID>(id) + " engine " +
+                      QString::number(static_cast<int>(engine));
+      QVERIFY2(exited, m_currentTest.toStdString().c_str());
+      if (instructions != 84 || takenBranches != 39) {
+        QFAIL((m_currentTest + ": instret " + QString::number(instructions) +
+               ", hpmcounter3 " + QString::number(takenBranches))
+                  .toStdString()
+                  .c_str());
+      }
+    }
+  }
+}
+
 QTEST_APPLESS_MAIN(tst_RISCV)
 #include "tst_riscv.moc"